@@ -23,6 +23,9 @@
 #ifdef HAVE_STRING_H
 #include <string.h>
 #endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 
 #include <glib.h>
 #include <common/panel-debug.h>
@@ -30,8 +33,79 @@
 
 
 
+/* size of the trace event ring buffer */
+#define TRACE_RING_SIZE (16384)
+
+/* number of spans in the startup summary */
+#define STARTUP_SUMMARY_SIZE (25)
+
+/* number of recent stalls kept by the watchdog */
+#define WATCHDOG_N_STALLS (32)
+
+
+
+typedef struct
+{
+  gint64                time;
+  const gchar          *name;
+  PanelDebugFlag        domain;
+  PanelDebugTracePhase  phase;
+  gint                  id;
+  gint                  thread;
+}
+PanelDebugTraceEvent;
+
+typedef struct
+{
+  const gchar *name;
+  gint         id;
+  gint64       start;
+  gint64       duration;
+}
+PanelDebugTraceSpan;
+
+typedef struct
+{
+  gint64       time;
+  gint64       duration;
+  const gchar *label;
+}
+PanelDebugStall;
+
+
+
 static PanelDebugFlag panel_debug_flags = 0;
 
+/* domain names indexed by the bit of the flag */
+static const gchar   *panel_debug_domain_names[32];
+
+/* trace ring buffer, only allocated when tracing is enabled */
+gboolean                    panel_debug_tracing = FALSE;
+static PanelDebugTraceEvent *trace_ring = NULL;
+static guint                 trace_ring_head = 0;
+static guint                 trace_ring_length = 0;
+static gint                  trace_thread_counter = 0;
+static GPrivate              trace_thread_id;
+static GHashTable           *trace_labels = NULL;
+G_LOCK_DEFINE_STATIC (trace_ring);
+
+/* startup profiler */
+static gboolean              startup_profiling = FALSE;
+static gint64                startup_time = 0;
+static gint                  startup_pending = 0;
+
+/* main loop watchdog, the thread itself runs in panel/main.c */
+gboolean                     panel_debug_watchdog_running = FALSE;
+static gpointer              watchdog_label = NULL;
+static PanelDebugStall       watchdog_stalls[WATCHDOG_N_STALLS];
+static guint                 watchdog_stalls_head = 0;
+static guint                 watchdog_stalls_length = 0;
+G_LOCK_DEFINE_STATIC (watchdog);
+
+/* lower bounds in milliseconds of the stall histogram buckets */
+static const guint           watchdog_buckets[] = { 0, 100, 250, 500, 1000, 2000, 5000 };
+static guint                 watchdog_histogram[G_N_ELEMENTS (watchdog_buckets)];
+
 
 
 /* additional debug levels */
@@ -55,7 +129,12 @@ static const GDebugKey panel_debug_keys[] =
   { "struts", PANEL_DEBUG_STRUTS },
   { "systray", PANEL_DEBUG_SYSTRAY },
   { "tasklist", PANEL_DEBUG_TASKLIST },
-  { "pager", PANEL_DEBUG_PAGER }
+  { "pager", PANEL_DEBUG_PAGER },
+
+  /* trace mode */
+  { "trace", PANEL_DEBUG_TRACE },
+  { "startup", PANEL_DEBUG_STARTUP },
+  { "watchdog", PANEL_DEBUG_WATCHDOG }
 };
 
 
@@ -65,9 +144,14 @@ panel_debug_init (void)
 {
   static volatile gsize  inited__volatile = 0;
   const gchar           *value;
+  guint                  i;
 
   if (g_once_init_enter (&inited__volatile))
     {
+      /* lookup table for the domain names */
+      for (i = 0; i < G_N_ELEMENTS (panel_debug_keys); i++)
+        panel_debug_domain_names[g_bit_nth_lsf (panel_debug_keys[i].value, -1)] = panel_debug_keys[i].key;
+
       value = g_getenv ("PANEL_DEBUG");
       if (value != NULL && *value != '\0')
         {
@@ -77,12 +161,27 @@ panel_debug_init (void)
           /* always enable (unfiltered) debugging messages */
           PANEL_SET_FLAG (panel_debug_flags, PANEL_DEBUG_YES);
 
-          /* unset gdb and valgrind in 'all' mode */
+          /* unset gdb and valgrind in 'all' mode, the trace, startup
+           * and watchdog modes are opt-in as well */
           if (g_ascii_strcasecmp (value, "all") == 0)
-            PANEL_UNSET_FLAG (panel_debug_flags, PANEL_DEBUG_GDB | PANEL_DEBUG_VALGRIND);
+            PANEL_UNSET_FLAG (panel_debug_flags, PANEL_DEBUG_GDB | PANEL_DEBUG_VALGRIND
+                              | PANEL_DEBUG_TRACE | PANEL_DEBUG_STARTUP
+                              | PANEL_DEBUG_WATCHDOG);
+
+          /* allocate the trace ring buffer */
+          if (PANEL_HAS_FLAG (panel_debug_flags, PANEL_DEBUG_TRACE))
+            {
+              trace_ring = g_new0 (PanelDebugTraceEvent, TRACE_RING_SIZE);
+              panel_debug_tracing = TRUE;
+            }
         }
 
       g_once_init_leave (&inited__volatile, 1);
+
+      /* the startup profiler records trace events until the
+       * panel finished starting */
+      if (PANEL_HAS_FLAG (panel_debug_flags, PANEL_DEBUG_STARTUP))
+        panel_debug_startup_enable ();
     }
 
   return panel_debug_flags;
@@ -96,19 +195,10 @@ panel_debug_print (PanelDebugFlag  domain,
                    va_list         args)
 {
   gchar       *string;
-  const gchar *domain_name = NULL;
-  guint        i;
+  const gchar *domain_name;
 
   /* lookup domain name */
-  for (i = 0; i < G_N_ELEMENTS (panel_debug_keys); i++)
-    {
-      if (panel_debug_keys[i].value == domain)
-        {
-          domain_name = panel_debug_keys[i].key;
-          break;
-        }
-    }
-
+  domain_name = panel_debug_domain_names[g_bit_nth_lsf (domain, -1)];
   panel_assert (domain_name != NULL);
 
   string = g_strdup_vprintf (message, args);
@@ -165,3 +255,488 @@ panel_debug_filtered (PanelDebugFlag  domain,
   panel_debug_print (domain, message, args);
   va_end (args);
 }
+
+
+
+void
+panel_debug_trace (PanelDebugFlag        domain,
+                   PanelDebugTracePhase  phase,
+                   const gchar          *name,
+                   gint                  id)
+{
+  PanelDebugTraceEvent *event;
+  gint                  thread;
+
+  panel_return_if_fail (domain > 0);
+  panel_return_if_fail (name != NULL);
+
+  if (!panel_debug_tracing)
+    return;
+
+  /* small per-thread id for the trace viewer */
+  thread = GPOINTER_TO_INT (g_private_get (&trace_thread_id));
+  if (G_UNLIKELY (thread == 0))
+    {
+      thread = g_atomic_int_add (&trace_thread_counter, 1) + 1;
+      g_private_set (&trace_thread_id, GINT_TO_POINTER (thread));
+    }
+
+  G_LOCK (trace_ring);
+
+  /* async spans that are still running during startup */
+  if (G_UNLIKELY (startup_profiling))
+    {
+      if (phase == PANEL_DEBUG_TRACE_ASYNC_BEGIN)
+        startup_pending++;
+      else if (phase == PANEL_DEBUG_TRACE_ASYNC_END)
+        startup_pending--;
+    }
+
+  /* overwrite the oldest event if the ring is full */
+  event = &trace_ring[trace_ring_head];
+  event->time = g_get_monotonic_time ();
+  event->name = name;
+  event->domain = domain;
+  event->phase = phase;
+  event->id = id;
+  event->thread = thread;
+
+  trace_ring_head = (trace_ring_head + 1) % TRACE_RING_SIZE;
+  if (trace_ring_length < TRACE_RING_SIZE)
+    trace_ring_length++;
+
+  G_UNLOCK (trace_ring);
+}
+
+
+
+void
+panel_debug_trace_label (const gchar *name,
+                         gint         id,
+                         const gchar *label)
+{
+  panel_return_if_fail (name != NULL);
+  panel_return_if_fail (label != NULL);
+
+  if (!panel_debug_tracing)
+    return;
+
+  G_LOCK (trace_ring);
+
+  if (trace_labels == NULL)
+    trace_labels = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+  g_hash_table_replace (trace_labels, g_strdup_printf ("%s-%d", name, id),
+                        g_strdup_printf ("%s-%d", label, id));
+
+  G_UNLOCK (trace_ring);
+}
+
+
+
+static void
+panel_debug_trace_append_json_string (GString     *json,
+                                      const gchar *str)
+{
+  const gchar *p;
+
+  g_string_append_c (json, '"');
+  for (p = str; *p != '\0'; p++)
+    {
+      if (*p == '"' || *p == '\\')
+        g_string_append_printf (json, "\\%c", *p);
+      else if ((guchar) *p < 0x20)
+        g_string_append_printf (json, "\\u%04x", (guint) *p);
+      else
+        g_string_append_c (json, *p);
+    }
+  g_string_append_c (json, '"');
+}
+
+
+
+/**
+ * panel_debug_trace_to_json:
+ *
+ * Export the events in the trace ring buffer in the Chrome trace
+ * event format, this can be loaded in chrome://tracing.
+ *
+ * Returns: a newly allocated JSON string, %NULL if tracing is disabled.
+ **/
+gchar *
+panel_debug_trace_to_json (void)
+{
+  GString              *json;
+  PanelDebugTraceEvent *event;
+  guint                 i, start;
+  const gchar          *domain_name;
+  gint                  pid;
+
+  if (!panel_debug_tracing)
+    return NULL;
+
+  json = g_string_sized_new (128 * trace_ring_length);
+  g_string_append (json, "{\"traceEvents\":[");
+
+  pid = getpid ();
+
+  G_LOCK (trace_ring);
+
+  start = (trace_ring_head + TRACE_RING_SIZE - trace_ring_length) % TRACE_RING_SIZE;
+  for (i = 0; i < trace_ring_length; i++)
+    {
+      event = &trace_ring[(start + i) % TRACE_RING_SIZE];
+      domain_name = panel_debug_domain_names[g_bit_nth_lsf (event->domain, -1)];
+
+      if (i > 0)
+        g_string_append_c (json, ',');
+
+      g_string_append (json, "{\"name\":");
+      panel_debug_trace_append_json_string (json, event->name);
+      g_string_append (json, ",\"cat\":");
+      panel_debug_trace_append_json_string (json, domain_name != NULL ? domain_name : "panel");
+      g_string_append_printf (json, ",\"ph\":\"%c\",\"ts\":%" G_GINT64_FORMAT
+                              ",\"pid\":%d,\"tid\":%d",
+                              event->phase, event->time, pid, event->thread);
+      if (event->phase == PANEL_DEBUG_TRACE_INSTANT)
+        g_string_append (json, ",\"s\":\"t\"");
+      else if (event->phase == PANEL_DEBUG_TRACE_ASYNC_BEGIN
+               || event->phase == PANEL_DEBUG_TRACE_ASYNC_END)
+        g_string_append_printf (json, ",\"id\":%d", event->id);
+      if (event->id != -1)
+        g_string_append_printf (json, ",\"args\":{\"id\":%d}", event->id);
+      g_string_append_c (json, '}');
+    }
+
+  G_UNLOCK (trace_ring);
+
+  g_string_append (json, "],\"displayTimeUnit\":\"ms\"}");
+
+  return g_string_free (json, FALSE);
+}
+
+
+
+/**
+ * panel_debug_startup_enable:
+ *
+ * Start the startup profiler, this records trace events, also if
+ * PANEL_DEBUG=trace is not set, until panel_debug_startup_finish()
+ * prints a summary.
+ **/
+void
+panel_debug_startup_enable (void)
+{
+  panel_debug_init ();
+
+  if (startup_profiling)
+    return;
+
+  if (trace_ring == NULL)
+    trace_ring = g_new0 (PanelDebugTraceEvent, TRACE_RING_SIZE);
+
+  startup_time = g_get_monotonic_time ();
+  startup_profiling = TRUE;
+  panel_debug_tracing = TRUE;
+
+  panel_debug_trace (PANEL_DEBUG_MAIN, PANEL_DEBUG_TRACE_BEGIN, "startup", -1);
+}
+
+
+
+gboolean
+panel_debug_startup_enabled (void)
+{
+  return startup_profiling;
+}
+
+
+
+/**
+ * panel_debug_startup_pending:
+ *
+ * Returns: the number of async spans, like external plugins that
+ *          are not embedded yet, started during startup that did
+ *          not end yet.
+ **/
+guint
+panel_debug_startup_pending (void)
+{
+  return MAX (startup_pending, 0);
+}
+
+
+
+static gint
+panel_debug_trace_span_compare (gconstpointer a,
+                                gconstpointer b)
+{
+  const PanelDebugTraceSpan *span_a = a;
+  const PanelDebugTraceSpan *span_b = b;
+
+  /* longest span first */
+  if (span_a->duration == span_b->duration)
+    return 0;
+
+  return span_a->duration < span_b->duration ? 1 : -1;
+}
+
+
+
+/**
+ * panel_debug_startup_finish:
+ *
+ * Stop the startup profiler and print the longest spans recorded
+ * since panel_debug_startup_enable() to stderr.
+ **/
+void
+panel_debug_startup_finish (void)
+{
+  GArray               *spans;
+  PanelDebugTraceEvent *event;
+  PanelDebugTraceSpan   span, *open;
+  guint                 i, start;
+  gint                  n;
+  gint64                total;
+  const gchar          *label;
+  gchar                *key;
+
+  if (!startup_profiling)
+    return;
+
+  panel_debug_trace (PANEL_DEBUG_MAIN, PANEL_DEBUG_TRACE_END, "startup", -1);
+  total = g_get_monotonic_time () - startup_time;
+
+  spans = g_array_new (FALSE, FALSE, sizeof (PanelDebugTraceSpan));
+
+  G_LOCK (trace_ring);
+
+  startup_profiling = FALSE;
+
+  /* match the begin and end events of the spans */
+  start = (trace_ring_head + TRACE_RING_SIZE - trace_ring_length) % TRACE_RING_SIZE;
+  for (i = 0; i < trace_ring_length; i++)
+    {
+      event = &trace_ring[(start + i) % TRACE_RING_SIZE];
+      if (event->time < startup_time)
+        continue;
+
+      if (event->phase == PANEL_DEBUG_TRACE_BEGIN
+          || event->phase == PANEL_DEBUG_TRACE_ASYNC_BEGIN)
+        {
+          span.name = event->name;
+          span.id = event->id;
+          span.start = event->time - startup_time;
+          span.duration = -1;
+          g_array_append_val (spans, span);
+        }
+      else if (event->phase == PANEL_DEBUG_TRACE_END
+               || event->phase == PANEL_DEBUG_TRACE_ASYNC_END)
+        {
+          /* the last open span with the same name and id */
+          for (n = spans->len - 1; n >= 0; n--)
+            {
+              open = &g_array_index (spans, PanelDebugTraceSpan, n);
+              if (open->duration == -1
+                  && open->id == event->id
+                  && strcmp (open->name, event->name) == 0)
+                {
+                  open->duration = event->time - startup_time - open->start;
+                  break;
+                }
+            }
+        }
+    }
+
+  g_array_sort (spans, panel_debug_trace_span_compare);
+
+  g_printerr (PACKAGE_NAME "(startup): finished after %.1f ms\n", total / 1000.0);
+
+  for (i = 0, n = 0; i < spans->len && n < STARTUP_SUMMARY_SIZE; i++)
+    {
+      open = &g_array_index (spans, PanelDebugTraceSpan, i);
+
+      /* unfinished spans and the startup span itself */
+      if (open->duration < 0 || strcmp (open->name, "startup") == 0)
+        continue;
+
+      label = NULL;
+      if (open->id != -1 && trace_labels != NULL)
+        {
+          key = g_strdup_printf ("%s-%d", open->name, open->id);
+          label = g_hash_table_lookup (trace_labels, key);
+          g_free (key);
+        }
+
+      if (label != NULL)
+        g_printerr (PACKAGE_NAME "(startup): %8.1f ms at %8.1f ms  %s (%s)\n",
+                    open->duration / 1000.0, open->start / 1000.0, open->name, label);
+      else if (open->id != -1)
+        g_printerr (PACKAGE_NAME "(startup): %8.1f ms at %8.1f ms  %s (%d)\n",
+                    open->duration / 1000.0, open->start / 1000.0, open->name, open->id);
+      else
+        g_printerr (PACKAGE_NAME "(startup): %8.1f ms at %8.1f ms  %s\n",
+                    open->duration / 1000.0, open->start / 1000.0, open->name);
+
+      n++;
+    }
+
+  /* keep the recorded events for the trace dump, but stop recording
+   * if tracing was only enabled for the startup profiler */
+  if (!PANEL_HAS_FLAG (panel_debug_flags, PANEL_DEBUG_TRACE))
+    panel_debug_tracing = FALSE;
+
+  G_UNLOCK (trace_ring);
+
+  g_array_free (spans, TRUE);
+}
+
+
+
+/**
+ * panel_debug_watchdog_enable:
+ *
+ * Enable the watchdog labels and its debug messages, also if
+ * PANEL_DEBUG=watchdog is not set. Call this before the watchdog
+ * thread is started.
+ **/
+void
+panel_debug_watchdog_enable (void)
+{
+  panel_debug_init ();
+
+  /* only the watchdog domain, not all the other debug messages */
+  PANEL_SET_FLAG (panel_debug_flags, PANEL_DEBUG_WATCHDOG);
+  panel_debug_watchdog_running = TRUE;
+}
+
+
+
+gboolean
+panel_debug_watchdog_enabled (void)
+{
+  return panel_debug_watchdog_running;
+}
+
+
+
+const gchar *
+panel_debug_watchdog_intern (const gchar *format,
+                             ...)
+{
+  va_list      args;
+  gchar       *string;
+  const gchar *label;
+
+  va_start (args, format);
+  string = g_strdup_vprintf (format, args);
+  va_end (args);
+
+  label = g_intern_string (string);
+  g_free (string);
+
+  return label;
+}
+
+
+
+/**
+ * panel_debug_watchdog_swap_label:
+ * @label : the new label, or %NULL.
+ *
+ * Only called from the main loop, the watchdog thread only reads.
+ *
+ * Returns: the label that was running before.
+ **/
+const gchar *
+panel_debug_watchdog_swap_label (const gchar *label)
+{
+  const gchar *previous;
+
+  previous = g_atomic_pointer_get (&watchdog_label);
+  g_atomic_pointer_set (&watchdog_label, (gpointer) label);
+
+  return previous;
+}
+
+
+
+/**
+ * panel_debug_watchdog_get_label:
+ *
+ * Returns: the label of the callback that is running in the main
+ *          loop, can be called from the watchdog thread.
+ **/
+const gchar *
+panel_debug_watchdog_get_label (void)
+{
+  return g_atomic_pointer_get (&watchdog_label);
+}
+
+
+
+void
+panel_debug_watchdog_add_stall (gint64       duration,
+                                const gchar *label)
+{
+  PanelDebugStall *stall;
+  guint            i;
+
+  G_LOCK (watchdog);
+
+  for (i = G_N_ELEMENTS (watchdog_buckets) - 1; i > 0; i--)
+    if (duration >= watchdog_buckets[i] * G_GINT64_CONSTANT (1000))
+      break;
+  watchdog_histogram[i]++;
+
+  /* overwrite the oldest stall if the list is full */
+  stall = &watchdog_stalls[watchdog_stalls_head];
+  stall->time = g_get_real_time ();
+  stall->duration = duration;
+  stall->label = label;
+
+  watchdog_stalls_head = (watchdog_stalls_head + 1) % WATCHDOG_N_STALLS;
+  if (watchdog_stalls_length < WATCHDOG_N_STALLS)
+    watchdog_stalls_length++;
+
+  G_UNLOCK (watchdog);
+}
+
+
+
+/**
+ * panel_debug_watchdog_get_stalls:
+ * @histogram : return location for an a(uu) variant with the lower
+ *              bound in milliseconds and the number of stalls.
+ * @stalls    : return location for an a(xus) variant with the wall
+ *              clock time, duration in milliseconds and label of the
+ *              most recent stalls, oldest first.
+ **/
+void
+panel_debug_watchdog_get_stalls (GVariant **histogram,
+                                 GVariant **stalls)
+{
+  GVariantBuilder  builder;
+  PanelDebugStall *stall;
+  guint            i, start;
+
+  G_LOCK (watchdog);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(uu)"));
+  for (i = 0; i < G_N_ELEMENTS (watchdog_buckets); i++)
+    g_variant_builder_add (&builder, "(uu)", watchdog_buckets[i], watchdog_histogram[i]);
+  *histogram = g_variant_builder_end (&builder);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(xus)"));
+  start = (watchdog_stalls_head + WATCHDOG_N_STALLS - watchdog_stalls_length) % WATCHDOG_N_STALLS;
+  for (i = 0; i < watchdog_stalls_length; i++)
+    {
+      stall = &watchdog_stalls[(start + i) % WATCHDOG_N_STALLS];
+      g_variant_builder_add (&builder, "(xus)", stall->time,
+                             (guint) (stall->duration / 1000),
+                             stall->label != NULL ? stall->label : "");
+    }
+  *stalls = g_variant_builder_end (&builder);
+
+  G_UNLOCK (watchdog);
+}
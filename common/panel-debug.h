@@ -43,10 +43,69 @@ typedef enum
   PANEL_DEBUG_STRUTS           = 1 << 13,
   PANEL_DEBUG_SYSTRAY          = 1 << 14,
   PANEL_DEBUG_TASKLIST         = 1 << 15,
-  PANEL_DEBUG_PAGER            = 1 << 16
+  PANEL_DEBUG_PAGER            = 1 << 16,
+
+  /* record trace events in a ring buffer */
+  PANEL_DEBUG_TRACE            = 1 << 17,
+
+  /* print a summary of the trace events during startup */
+  PANEL_DEBUG_STARTUP          = 1 << 18,
+
+  /* log callbacks that block the main loop */
+  PANEL_DEBUG_WATCHDOG         = 1 << 19
 }
 PanelDebugFlag;
 
+typedef enum
+{
+  PANEL_DEBUG_TRACE_BEGIN   = 'B',
+  PANEL_DEBUG_TRACE_END     = 'E',
+  PANEL_DEBUG_TRACE_INSTANT = 'i',
+
+  /* spans that do not nest, like D-Bus round trips, matched by id */
+  PANEL_DEBUG_TRACE_ASYNC_BEGIN = 'b',
+  PANEL_DEBUG_TRACE_ASYNC_END   = 'e'
+}
+PanelDebugTracePhase;
+
+/* only read this through the macros below */
+extern gboolean panel_debug_tracing;
+
+/* trace event names are not copied, use static or interned strings */
+#define panel_debug_trace_begin(domain,name,id) \
+  G_STMT_START { if (G_UNLIKELY (panel_debug_tracing)) \
+    panel_debug_trace ((domain), PANEL_DEBUG_TRACE_BEGIN, (name), (id)); } G_STMT_END
+#define panel_debug_trace_end(domain,name,id) \
+  G_STMT_START { if (G_UNLIKELY (panel_debug_tracing)) \
+    panel_debug_trace ((domain), PANEL_DEBUG_TRACE_END, (name), (id)); } G_STMT_END
+#define panel_debug_trace_instant(domain,name,id) \
+  G_STMT_START { if (G_UNLIKELY (panel_debug_tracing)) \
+    panel_debug_trace ((domain), PANEL_DEBUG_TRACE_INSTANT, (name), (id)); } G_STMT_END
+#define panel_debug_trace_async_begin(domain,name,id) \
+  G_STMT_START { if (G_UNLIKELY (panel_debug_tracing)) \
+    panel_debug_trace ((domain), PANEL_DEBUG_TRACE_ASYNC_BEGIN, (name), (id)); } G_STMT_END
+#define panel_debug_trace_async_end(domain,name,id) \
+  G_STMT_START { if (G_UNLIKELY (panel_debug_tracing)) \
+    panel_debug_trace ((domain), PANEL_DEBUG_TRACE_ASYNC_END, (name), (id)); } G_STMT_END
+
+/* name the events with name and id in the startup summary */
+#define panel_debug_trace_set_label(name,id,label) \
+  G_STMT_START { if (G_UNLIKELY (panel_debug_tracing)) \
+    panel_debug_trace_label ((name), (id), (label)); } G_STMT_END
+
+/* only read this through the macros below */
+extern gboolean panel_debug_watchdog_running;
+
+/* watchdog labels are not copied, use static or interned strings; enter
+ * stores the running label in saved, leave restores it so nested callbacks
+ * do not clear the label of the outer one */
+#define panel_debug_watchdog_enter(label,saved) \
+  G_STMT_START { if (G_UNLIKELY (panel_debug_watchdog_running)) \
+    (saved) = panel_debug_watchdog_swap_label ((label)); } G_STMT_END
+#define panel_debug_watchdog_leave(saved) \
+  G_STMT_START { if (G_UNLIKELY (panel_debug_watchdog_running)) \
+    panel_debug_watchdog_swap_label ((saved)); } G_STMT_END
+
 gboolean panel_debug_has_domain   (PanelDebugFlag  domain);
 
 void     panel_debug              (PanelDebugFlag  domain,
@@ -57,4 +116,40 @@ void     panel_debug_filtered     (PanelDebugFlag  domain,
                                    const gchar    *message,
                                    ...) G_GNUC_PRINTF (2, 3);
 
+void     panel_debug_trace        (PanelDebugFlag        domain,
+                                   PanelDebugTracePhase  phase,
+                                   const gchar          *name,
+                                   gint                  id);
+
+void     panel_debug_trace_label  (const gchar          *name,
+                                   gint                  id,
+                                   const gchar          *label);
+
+gchar   *panel_debug_trace_to_json (void) G_GNUC_MALLOC;
+
+void     panel_debug_startup_enable  (void);
+
+gboolean panel_debug_startup_enabled (void);
+
+guint    panel_debug_startup_pending (void);
+
+void     panel_debug_startup_finish  (void);
+
+void         panel_debug_watchdog_enable     (void);
+
+gboolean     panel_debug_watchdog_enabled    (void);
+
+const gchar *panel_debug_watchdog_intern     (const gchar  *format,
+                                              ...) G_GNUC_PRINTF (1, 2);
+
+const gchar *panel_debug_watchdog_swap_label (const gchar  *label);
+
+const gchar *panel_debug_watchdog_get_label  (void);
+
+void         panel_debug_watchdog_add_stall  (gint64        duration,
+                                              const gchar  *label);
+
+void         panel_debug_watchdog_get_stalls (GVariant    **histogram,
+                                              GVariant    **stalls);
+
 #endif /* !__PANEL_DEBUG_H__ */
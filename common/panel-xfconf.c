@@ -20,12 +20,331 @@
 #include <config.h>
 #endif
 
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
 #include <common/panel-private.h>
+#include <common/panel-debug.h>
 #include <common/panel-xfconf.h>
 #include <libxfce4panel/xfce-panel-macros.h>
 
 
 
+/* startup snapshot of the whole channel, see panel_properties_snapshot_begin();
+ * it is also set as qdata on the channel, so the copies of this file in the
+ * plugin modules can read it */
+#define SNAPSHOT_QUARK_NAME "panel-properties-snapshot"
+
+static GHashTable    *snapshot = NULL;
+static XfconfChannel *snapshot_channel = NULL;
+static gulong         snapshot_changed_id = 0;
+
+/* write-behind journal, see panel_properties_journal_set() */
+#define JOURNAL_FLUSH_TIMEOUT (1) /* seconds */
+
+typedef struct _PanelPropertyWrite PanelPropertyWrite;
+struct _PanelPropertyWrite
+{
+  /* G_TYPE_INVALID for a reset */
+  GValue   value;
+  guint    recursive : 1;
+};
+
+static GHashTable    *journal = NULL;
+static GHashTable    *journal_written = NULL;
+static XfconfChannel *journal_channel = NULL;
+static gulong         journal_changed_id = 0;
+static guint          journal_timeout_id = 0;
+static guint          journal_suppressed = 0;
+static gboolean       journal_flushing = FALSE;
+static gboolean       journal_holds_xfconf = FALSE;
+static gboolean       journal_enabled = FALSE;
+
+/* live binding between an object and xfconf property, see
+ * panel_properties_bind() */
+typedef struct _PanelPropertyBinding PanelPropertyBinding;
+struct _PanelPropertyBinding
+{
+  XfconfChannel *channel;
+  gchar         *xfconf_property;
+  GType          xfconf_property_type;
+  GObject       *object;
+  const gchar   *object_property;
+  gulong         channel_handler_id;
+  gulong         object_handler_id;
+};
+
+static GQuark         binding_quark = 0;
+
+
+
+static void
+panel_properties_snapshot_changed (XfconfChannel *channel,
+                                   const gchar   *property,
+                                   const GValue  *value)
+{
+  GValue *copy;
+
+  panel_return_if_fail (snapshot != NULL);
+
+  /* keep the snapshot in sync with writes during startup */
+  if (value != NULL && G_VALUE_TYPE (value) != G_TYPE_INVALID)
+    {
+      copy = g_new0 (GValue, 1);
+      g_value_init (copy, G_VALUE_TYPE (value));
+      g_value_copy (value, copy);
+      g_hash_table_replace (snapshot, g_strdup (property), copy);
+    }
+  else
+    {
+      /* property was reset */
+      g_hash_table_remove (snapshot, property);
+    }
+}
+
+
+
+static void
+panel_properties_snapshot_value_free (gpointer data)
+{
+  GValue *value = data;
+
+  g_value_unset (value);
+  g_free (value);
+}
+
+
+
+static gboolean
+panel_properties_snapshot_lookup_value (XfconfChannel *channel,
+                                        const gchar   *property,
+                                        const GValue **value)
+{
+  static GQuark  snapshot_quark = 0;
+  GHashTable    *table;
+
+  /* the channel is a singleton, shared with the plugin modules */
+  if (snapshot_quark == 0)
+    snapshot_quark = g_quark_from_string (SNAPSHOT_QUARK_NAME);
+
+  table = g_object_get_qdata (G_OBJECT (channel), snapshot_quark);
+  if (table == NULL)
+    return FALSE;
+
+  *value = g_hash_table_lookup (table, property);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+panel_properties_value_equal (const GValue *a,
+                              const GValue *b)
+{
+  GPtrArray *array_a, *array_b;
+  guint      i;
+
+  if (G_VALUE_TYPE (a) != G_VALUE_TYPE (b))
+    return FALSE;
+
+  switch (G_VALUE_TYPE (a))
+    {
+    case G_TYPE_BOOLEAN:
+      return g_value_get_boolean (a) == g_value_get_boolean (b);
+
+    case G_TYPE_INT:
+      return g_value_get_int (a) == g_value_get_int (b);
+
+    case G_TYPE_UINT:
+      return g_value_get_uint (a) == g_value_get_uint (b);
+
+    case G_TYPE_DOUBLE:
+      return g_value_get_double (a) == g_value_get_double (b);
+
+    case G_TYPE_STRING:
+      return g_strcmp0 (g_value_get_string (a), g_value_get_string (b)) == 0;
+
+    default:
+      if (G_VALUE_HOLDS (a, G_TYPE_PTR_ARRAY))
+        {
+          array_a = g_value_get_boxed (a);
+          array_b = g_value_get_boxed (b);
+          if (array_a == NULL || array_b == NULL)
+            return array_a == array_b;
+          if (array_a->len != array_b->len)
+            return FALSE;
+
+          for (i = 0; i < array_a->len; i++)
+            if (!panel_properties_value_equal (g_ptr_array_index (array_a, i),
+                                               g_ptr_array_index (array_b, i)))
+              return FALSE;
+
+          return TRUE;
+        }
+
+      /* unknown type, never suppress the write */
+      return FALSE;
+    }
+}
+
+
+
+static void
+panel_properties_journal_write_free (gpointer data)
+{
+  PanelPropertyWrite *write = data;
+
+  if (G_IS_VALUE (&write->value))
+    g_value_unset (&write->value);
+  g_slice_free (PanelPropertyWrite, write);
+}
+
+
+
+static void
+panel_properties_journal_remove_prefix (GHashTable  *table,
+                                        const gchar *property)
+{
+  GHashTableIter  iter;
+  gpointer        key;
+  gsize           len;
+
+  len = strlen (property);
+  g_hash_table_iter_init (&iter, table);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    if (strncmp (key, property, len) == 0
+        && (((const gchar *) key)[len] == '\0' || ((const gchar *) key)[len] == '/'))
+      g_hash_table_iter_remove (&iter);
+}
+
+
+
+static void
+panel_properties_journal_changed (XfconfChannel *channel,
+                                  const gchar   *property,
+                                  const GValue  *value)
+{
+  GValue *copy;
+
+  panel_return_if_fail (journal != NULL);
+
+  if (value != NULL && G_VALUE_TYPE (value) != G_TYPE_INVALID)
+    {
+      /* somebody else changed the property after it was queued, the
+       * newer value wins so drop our pending write */
+      if (!journal_flushing)
+        g_hash_table_remove (journal, property);
+
+      /* remember the value in the channel to suppress redundant writes */
+      copy = g_new0 (GValue, 1);
+      g_value_init (copy, G_VALUE_TYPE (value));
+      g_value_copy (value, copy);
+      g_hash_table_replace (journal_written, g_strdup (property), copy);
+    }
+  else
+    {
+      /* a reset can also remove properties below this one */
+      if (!journal_flushing)
+        panel_properties_journal_remove_prefix (journal, property);
+      panel_properties_journal_remove_prefix (journal_written, property);
+    }
+}
+
+
+
+static gboolean
+panel_properties_journal_write (XfconfChannel *channel,
+                                const gchar   *property,
+                                const GValue  *value)
+{
+  if (G_VALUE_HOLDS (value, G_TYPE_PTR_ARRAY))
+    return xfconf_channel_set_arrayv (channel, property, g_value_get_boxed (value));
+
+  return xfconf_channel_set_property (channel, property, value);
+}
+
+
+
+static gboolean
+panel_properties_journal_timeout (gpointer user_data)
+{
+  journal_timeout_id = 0;
+  panel_properties_journal_flush ();
+
+  return FALSE;
+}
+
+
+
+static PanelPropertyWrite *
+panel_properties_journal_queue (XfconfChannel *channel,
+                                const gchar   *property)
+{
+  PanelPropertyWrite *write;
+
+  if (journal == NULL)
+    {
+      journal = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                       panel_properties_journal_write_free);
+      journal_written = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                               panel_properties_snapshot_value_free);
+      journal_channel = g_object_ref (channel);
+      journal_changed_id = g_signal_connect (G_OBJECT (channel), "property-changed",
+          G_CALLBACK (panel_properties_journal_changed), NULL);
+    }
+
+  /* coalesce with an earlier write of the same property */
+  if (g_hash_table_remove (journal, property))
+    journal_suppressed++;
+
+  /* keep xfconf alive until the journal is flushed */
+  if (!journal_holds_xfconf)
+    journal_holds_xfconf = xfconf_init (NULL);
+
+  write = g_slice_new0 (PanelPropertyWrite);
+  g_hash_table_insert (journal, g_strdup (property), write);
+
+  if (journal_timeout_id == 0)
+    journal_timeout_id = g_timeout_add_seconds (JOURNAL_FLUSH_TIMEOUT,
+                                                panel_properties_journal_timeout,
+                                                NULL);
+
+  return write;
+}
+
+
+
+static GPtrArray *
+panel_properties_rgba_to_array (const GdkRGBA *rgba)
+{
+  gdouble    components[4];
+  GPtrArray *array;
+  GValue    *component;
+  guint      i;
+
+  /* work around xfconf's lack of storing colors (bug #7117) and
+   * do the same as xfconf_g_property_bind_gdkcolor() does */
+  components[0] = rgba->red;
+  components[1] = rgba->green;
+  components[2] = rgba->blue;
+  components[3] = rgba->alpha;
+
+  array = g_ptr_array_sized_new (G_N_ELEMENTS (components));
+  for (i = 0; i < G_N_ELEMENTS (components); i++)
+    {
+      component = g_new0 (GValue, 1);
+      g_value_init (component, G_TYPE_DOUBLE);
+      g_value_set_double (component, components[i]);
+      g_ptr_array_add (array, component);
+    }
+
+  return array;
+}
+
+
+
 static void
 panel_properties_store_value (XfconfChannel *channel,
                               const gchar   *xfconf_property,
@@ -34,7 +353,7 @@ panel_properties_store_value (XfconfChannel *channel,
                               const gchar   *object_property)
 {
   GValue       value = { 0, };
-  GdkRGBA     *rgba;
+  GPtrArray   *array;
 #ifndef NDEBUG
   GParamSpec *pspec;
 #endif
@@ -61,26 +380,209 @@ panel_properties_store_value (XfconfChannel *channel,
 
   if (G_LIKELY (xfconf_property_type != GDK_TYPE_RGBA))
     {
-        xfconf_channel_set_property (channel, xfconf_property, &value);
+      panel_properties_journal_set (channel, xfconf_property, &value);
+    }
+  else
+    {
+      array = panel_properties_rgba_to_array (g_value_get_boxed (&value));
+      panel_properties_journal_set_arrayv (channel, xfconf_property, array);
+      xfconf_array_free (array);
+    }
+
+  g_value_unset (&value);
+}
+
+
+
+static void
+panel_properties_apply_value (const GValue  *xfconf_value,
+                              GType          xfconf_property_type,
+                              GObject       *object,
+                              const gchar   *object_property)
+{
+  GValue        value = { 0, };
+  GPtrArray    *array;
+  GdkRGBA       rgba;
+  gdouble      *components[] = { &rgba.red, &rgba.green, &rgba.blue, &rgba.alpha };
+  guint         i;
+
+  panel_return_if_fail (G_IS_OBJECT (object));
+
+  if (G_LIKELY (xfconf_property_type != GDK_TYPE_RGBA))
+    {
+      g_value_init (&value, xfconf_property_type);
+      if (g_value_transform (xfconf_value, &value))
+        g_object_set_property (object, object_property, &value);
+      g_value_unset (&value);
+    }
+  else if (G_VALUE_HOLDS (xfconf_value, G_TYPE_PTR_ARRAY))
+    {
+      /* colors are stored as an array of 4 doubles, see
+       * panel_properties_store_value() */
+      array = g_value_get_boxed (xfconf_value);
+      if (array == NULL || array->len != G_N_ELEMENTS (components))
+        return;
+
+      for (i = 0; i < array->len; i++)
+        {
+          if (!G_VALUE_HOLDS_DOUBLE (g_ptr_array_index (array, i)))
+            return;
+          *components[i] = g_value_get_double (g_ptr_array_index (array, i));
+        }
+
+      g_object_set (object, object_property, &rgba, NULL);
+    }
+}
+
+
+
+static void
+panel_properties_load_value (XfconfChannel *channel,
+                             const gchar   *xfconf_property,
+                             GType          xfconf_property_type,
+                             GObject       *object,
+                             const gchar   *object_property)
+{
+  const GValue *snapshot_value = NULL;
+  GValue        value = { 0, };
+
+  /* during startup the value comes from memory, otherwise ask xfconf */
+  if (panel_properties_snapshot_lookup_value (channel, xfconf_property, &snapshot_value))
+    {
+      if (snapshot_value != NULL)
+        panel_properties_apply_value (snapshot_value, xfconf_property_type,
+                                      object, object_property);
+    }
+  else if (xfconf_channel_get_property (channel, xfconf_property, &value))
+    {
+      panel_properties_apply_value (&value, xfconf_property_type,
+                                    object, object_property);
+      g_value_unset (&value);
+    }
+}
+
+
+
+static void
+panel_properties_binding_channel_changed (XfconfChannel        *channel,
+                                          const gchar          *property,
+                                          const GValue         *value,
+                                          PanelPropertyBinding *binding)
+{
+  /* nothing to do for a reset, like xfconf's own bindings */
+  if (value == NULL || G_VALUE_TYPE (value) == G_TYPE_INVALID)
+    return;
+
+  g_signal_handler_block (binding->object, binding->object_handler_id);
+  panel_properties_apply_value (value, binding->xfconf_property_type,
+                                binding->object, binding->object_property);
+  g_signal_handler_unblock (binding->object, binding->object_handler_id);
+}
+
+
+
+static void
+panel_properties_binding_object_notify (GObject              *object,
+                                        GParamSpec           *pspec,
+                                        PanelPropertyBinding *binding)
+{
+  GValue     value = { 0, };
+  GdkRGBA   *rgba;
+  GPtrArray *array;
+
+  g_value_init (&value, binding->xfconf_property_type);
+  g_object_get_property (object, binding->object_property, &value);
+
+  g_signal_handler_block (binding->channel, binding->channel_handler_id);
+
+  if (G_LIKELY (binding->xfconf_property_type != GDK_TYPE_RGBA))
+    {
+      panel_properties_journal_set (binding->channel, binding->xfconf_property, &value);
     }
   else
     {
-      /* work around xfconf's lack of storing colors (bug #7117) and
-       * do the same as xfconf_g_property_bind_gdkcolor() does */
       rgba = g_value_get_boxed (&value);
-      xfconf_channel_set_array (channel, xfconf_property,
-                                G_TYPE_DOUBLE, &rgba->red,
-                                G_TYPE_DOUBLE, &rgba->green,
-                                G_TYPE_DOUBLE, &rgba->blue,
-                                G_TYPE_DOUBLE, &rgba->alpha,
-                                G_TYPE_INVALID);
+      if (rgba != NULL)
+        {
+          array = panel_properties_rgba_to_array (rgba);
+          panel_properties_journal_set_arrayv (binding->channel, binding->xfconf_property, array);
+          xfconf_array_free (array);
+        }
     }
 
+  g_signal_handler_unblock (binding->channel, binding->channel_handler_id);
+
   g_value_unset (&value);
 }
 
 
 
+static void
+panel_properties_binding_free (gpointer data)
+{
+  PanelPropertyBinding *binding = data;
+
+  g_signal_handler_disconnect (binding->channel, binding->channel_handler_id);
+
+  /* the handlers of the object are already gone if it is finalized */
+  if (g_signal_handler_is_connected (binding->object, binding->object_handler_id))
+    g_signal_handler_disconnect (binding->object, binding->object_handler_id);
+
+  g_object_unref (G_OBJECT (binding->channel));
+  g_free (binding->xfconf_property);
+  g_slice_free (PanelPropertyBinding, binding);
+}
+
+
+
+static void
+panel_properties_binding_list_free (gpointer data)
+{
+  g_slist_free_full (data, panel_properties_binding_free);
+}
+
+
+
+static void
+panel_properties_binding_new (XfconfChannel *channel,
+                              const gchar   *xfconf_property,
+                              GType          xfconf_property_type,
+                              GObject       *object,
+                              const gchar   *object_property)
+{
+  PanelPropertyBinding *binding;
+  GSList               *bindings;
+  gchar                *signal_name;
+
+  binding = g_slice_new0 (PanelPropertyBinding);
+  binding->channel = g_object_ref (channel);
+  binding->xfconf_property = g_strdup (xfconf_property);
+  binding->xfconf_property_type = xfconf_property_type;
+  binding->object = object;
+  binding->object_property = g_intern_string (object_property);
+
+  signal_name = g_strconcat ("property-changed::", xfconf_property, NULL);
+  binding->channel_handler_id = g_signal_connect (G_OBJECT (channel), signal_name,
+      G_CALLBACK (panel_properties_binding_channel_changed), binding);
+  g_free (signal_name);
+
+  signal_name = g_strconcat ("notify::", object_property, NULL);
+  binding->object_handler_id = g_signal_connect (object, signal_name,
+      G_CALLBACK (panel_properties_binding_object_notify), binding);
+  g_free (signal_name);
+
+  if (binding_quark == 0)
+    binding_quark = g_quark_from_static_string ("panel-properties-bindings");
+
+  /* steal the list so the destroy notify does not free it */
+  bindings = g_object_steal_qdata (object, binding_quark);
+  bindings = g_slist_prepend (bindings, binding);
+  g_object_set_qdata_full (object, binding_quark, bindings,
+                           panel_properties_binding_list_free);
+}
+
+
+
 XfconfChannel *
 panel_properties_get_channel (GObject *object_for_weak_ref)
 {
@@ -123,21 +625,32 @@ panel_properties_bind (XfconfChannel       *channel,
     channel = panel_properties_get_channel (object);
   panel_return_if_fail (XFCONF_IS_CHANNEL (channel));
 
-  /* walk the properties array */
+  /* set the initial values in one notify batch, from the snapshot
+   * during startup, before the bindings exist so the queued
+   * notifications are not written back to xfconf */
+  g_object_freeze_notify (object);
+
   for (prop = properties; prop->property != NULL; prop++)
     {
       property = g_strconcat (property_base, "/", prop->property, NULL);
 
       if (save_properties)
         panel_properties_store_value (channel, property, prop->type, object, prop->property);
-
-      if (G_LIKELY (prop->type != GDK_TYPE_RGBA))
-        xfconf_g_property_bind (channel, property, prop->type, object, prop->property);
       else
-        xfconf_g_property_bind_gdkrgba (channel, property, object, prop->property);
+        panel_properties_load_value (channel, property, prop->type, object, prop->property);
 
       g_free (property);
     }
+
+  g_object_thaw_notify (object);
+
+  /* the live bindings, without another read of the initial value */
+  for (prop = properties; prop->property != NULL; prop++)
+    {
+      property = g_strconcat (property_base, "/", prop->property, NULL);
+      panel_properties_binding_new (channel, property, prop->type, object, prop->property);
+      g_free (property);
+    }
 }
 
 
@@ -145,5 +658,355 @@ panel_properties_bind (XfconfChannel       *channel,
 void
 panel_properties_unbind (GObject *object)
 {
-  xfconf_g_property_unbind_all (object);
+  if (binding_quark != 0)
+    g_object_set_qdata (object, binding_quark, NULL);
+}
+
+
+
+/**
+ * panel_properties_snapshot_begin:
+ * @channel : the panel #XfconfChannel.
+ *
+ * Fetch all the properties in @channel with a single call and serve
+ * the reads of panel_properties_get_property(), panel_properties_get_string(),
+ * panel_properties_has_property() and the initial values of
+ * panel_properties_bind() from memory until panel_properties_snapshot_end()
+ * is called. This avoids a D-Bus round trip per property during startup.
+ * The internal plugins bound in the meantime read from the snapshot too.
+ **/
+void
+panel_properties_snapshot_begin (XfconfChannel *channel)
+{
+  GHashTable     *properties;
+  GHashTableIter  iter;
+  gpointer        key, value;
+
+  panel_return_if_fail (XFCONF_IS_CHANNEL (channel));
+
+  if (snapshot != NULL)
+    return;
+
+  properties = xfconf_channel_get_properties (channel, NULL);
+  if (G_UNLIKELY (properties == NULL))
+    return;
+
+  /* copy the values, so we control how they are released */
+  snapshot = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                    panel_properties_snapshot_value_free);
+  g_hash_table_iter_init (&iter, properties);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    panel_properties_snapshot_changed (channel, key, value);
+  g_hash_table_destroy (properties);
+
+  snapshot_channel = g_object_ref (channel);
+  snapshot_changed_id = g_signal_connect (G_OBJECT (channel), "property-changed",
+      G_CALLBACK (panel_properties_snapshot_changed), NULL);
+
+  g_object_set_qdata (G_OBJECT (channel),
+                      g_quark_from_string (SNAPSHOT_QUARK_NAME), snapshot);
+}
+
+
+
+void
+panel_properties_snapshot_end (void)
+{
+  if (snapshot == NULL)
+    return;
+
+  g_object_set_qdata (G_OBJECT (snapshot_channel),
+                      g_quark_from_string (SNAPSHOT_QUARK_NAME), NULL);
+  g_signal_handler_disconnect (G_OBJECT (snapshot_channel), snapshot_changed_id);
+  g_object_unref (G_OBJECT (snapshot_channel));
+  snapshot_channel = NULL;
+
+  g_hash_table_destroy (snapshot);
+  snapshot = NULL;
+}
+
+
+
+gboolean
+panel_properties_get_property (XfconfChannel *channel,
+                               const gchar   *property,
+                               GValue        *value)
+{
+  const GValue *snapshot_value;
+
+  panel_return_val_if_fail (XFCONF_IS_CHANNEL (channel), FALSE);
+  panel_return_val_if_fail (property != NULL, FALSE);
+  panel_return_val_if_fail (value != NULL, FALSE);
+
+  if (!panel_properties_snapshot_lookup_value (channel, property, &snapshot_value))
+    return xfconf_channel_get_property (channel, property, value);
+
+  if (snapshot_value == NULL)
+    return FALSE;
+
+  g_value_init (value, G_VALUE_TYPE (snapshot_value));
+  g_value_copy (snapshot_value, value);
+
+  return TRUE;
+}
+
+
+
+gchar *
+panel_properties_get_string (XfconfChannel *channel,
+                             const gchar   *property,
+                             const gchar   *default_value)
+{
+  const GValue *snapshot_value;
+
+  panel_return_val_if_fail (XFCONF_IS_CHANNEL (channel), NULL);
+  panel_return_val_if_fail (property != NULL, NULL);
+
+  if (!panel_properties_snapshot_lookup_value (channel, property, &snapshot_value))
+    return xfconf_channel_get_string (channel, property, default_value);
+
+  if (snapshot_value != NULL && G_VALUE_HOLDS_STRING (snapshot_value))
+    return g_value_dup_string (snapshot_value);
+
+  return g_strdup (default_value);
+}
+
+
+
+gboolean
+panel_properties_has_property (XfconfChannel *channel,
+                               const gchar   *property)
+{
+  const GValue *snapshot_value;
+
+  panel_return_val_if_fail (XFCONF_IS_CHANNEL (channel), FALSE);
+  panel_return_val_if_fail (property != NULL, FALSE);
+
+  if (!panel_properties_snapshot_lookup_value (channel, property, &snapshot_value))
+    return xfconf_channel_has_property (channel, property);
+
+  return snapshot_value != NULL;
+}
+
+
+
+/**
+ * panel_properties_journal_enable:
+ *
+ * Use the write-behind journal for the writes of this process. Only the
+ * panel calls this: internal plugin modules link their own copy of
+ * libpanel-common, which is never flushed on save or quit, so their
+ * writes go to xfconf directly.
+ **/
+void
+panel_properties_journal_enable (void)
+{
+  journal_enabled = TRUE;
+}
+
+
+
+/**
+ * panel_properties_journal_set:
+ * @channel  : the panel #XfconfChannel.
+ * @property : the property name.
+ * @value    : the new value.
+ *
+ * Queue a write of @property in the write-behind journal. Writes of
+ * the same property are coalesced and writes of the value already in
+ * the channel are dropped. The journal is flushed from a timeout or
+ * with panel_properties_journal_flush(). Without
+ * panel_properties_journal_enable() the value is written immediately.
+ **/
+void
+panel_properties_journal_set (XfconfChannel *channel,
+                              const gchar   *property,
+                              const GValue  *value)
+{
+  PanelPropertyWrite *write;
+  const GValue       *written;
+
+  panel_return_if_fail (XFCONF_IS_CHANNEL (channel));
+  panel_return_if_fail (property != NULL && *property == '/');
+  panel_return_if_fail (G_IS_VALUE (value));
+
+  /* the journal serves a single channel, in the panel only */
+  if (!journal_enabled
+      || G_UNLIKELY (journal_channel != NULL && journal_channel != channel))
+    {
+      if (!panel_properties_journal_write (channel, property, value))
+        g_warning ("Failed to store property \"%s\"", property);
+      return;
+    }
+
+  if (journal_written != NULL
+      && !g_hash_table_contains (journal, property))
+    {
+      written = g_hash_table_lookup (journal_written, property);
+      if (written != NULL && panel_properties_value_equal (written, value))
+        {
+          journal_suppressed++;
+          return;
+        }
+    }
+
+  write = panel_properties_journal_queue (channel, property);
+  g_value_init (&write->value, G_VALUE_TYPE (value));
+  g_value_copy (value, &write->value);
+}
+
+
+
+void
+panel_properties_journal_set_string (XfconfChannel *channel,
+                                     const gchar   *property,
+                                     const gchar   *string)
+{
+  GValue value = { 0, };
+
+  g_value_init (&value, G_TYPE_STRING);
+  g_value_set_static_string (&value, string);
+  panel_properties_journal_set (channel, property, &value);
+  g_value_unset (&value);
+}
+
+
+
+/**
+ * panel_properties_journal_set_arrayv:
+ * @channel  : the panel #XfconfChannel.
+ * @property : the property name.
+ * @values   : a #GPtrArray of #GValue<!-- -->s, as used by
+ *             xfconf_channel_set_arrayv().
+ *
+ * Same as panel_properties_journal_set() for an array property, @values
+ * is copied so the caller still has to free it.
+ **/
+void
+panel_properties_journal_set_arrayv (XfconfChannel *channel,
+                                     const gchar   *property,
+                                     GPtrArray     *values)
+{
+  GPtrArray *copy;
+  GValue    *item;
+  GValue     value = { 0, };
+  guint      i;
+
+  panel_return_if_fail (values != NULL);
+
+  copy = g_ptr_array_new_full (values->len, panel_properties_snapshot_value_free);
+  for (i = 0; i < values->len; i++)
+    {
+      item = g_new0 (GValue, 1);
+      g_value_init (item, G_VALUE_TYPE (g_ptr_array_index (values, i)));
+      g_value_copy (g_ptr_array_index (values, i), item);
+      g_ptr_array_add (copy, item);
+    }
+
+  g_value_init (&value, G_TYPE_PTR_ARRAY);
+  g_value_take_boxed (&value, copy);
+  panel_properties_journal_set (channel, property, &value);
+  g_value_unset (&value);
+}
+
+
+
+void
+panel_properties_journal_reset (XfconfChannel *channel,
+                                const gchar   *property,
+                                gboolean       recursive)
+{
+  PanelPropertyWrite *write;
+
+  panel_return_if_fail (XFCONF_IS_CHANNEL (channel));
+  panel_return_if_fail (property != NULL && *property == '/');
+
+  if (!journal_enabled
+      || G_UNLIKELY (journal_channel != NULL && journal_channel != channel))
+    {
+      xfconf_channel_reset_property (channel, property, recursive);
+      return;
+    }
+
+  write = panel_properties_journal_queue (channel, property);
+  write->recursive = recursive;
+}
+
+
+
+/**
+ * panel_properties_journal_flush:
+ *
+ * Write all the pending properties in the journal to xfconf, in a
+ * single pass. Call this before the configuration has to be on disk,
+ * like on an explicit save or when quitting.
+ **/
+void
+panel_properties_journal_flush (void)
+{
+  GHashTable         *pending;
+  GHashTableIter      iter;
+  gpointer            key, value;
+  PanelPropertyWrite *write;
+  guint               n_writes;
+
+  if (journal_timeout_id != 0)
+    {
+      g_source_remove (journal_timeout_id);
+      journal_timeout_id = 0;
+    }
+
+  if (journal == NULL)
+    return;
+
+  if (g_hash_table_size (journal) == 0)
+    goto release;
+
+  /* swap the table, so writes queued while flushing are not lost */
+  pending = journal;
+  journal = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                   panel_properties_journal_write_free);
+  n_writes = g_hash_table_size (pending);
+
+  journal_flushing = TRUE;
+
+  g_hash_table_iter_init (&iter, pending);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      write = value;
+
+      if (!G_IS_VALUE (&write->value))
+        {
+          if (xfconf_channel_has_property (journal_channel, key))
+            xfconf_channel_reset_property (journal_channel, key, write->recursive);
+        }
+      else if (!panel_properties_journal_write (journal_channel, key, &write->value))
+        {
+          g_warning ("Failed to store property \"%s\"", (const gchar *) key);
+        }
+    }
+
+  journal_flushing = FALSE;
+
+  g_hash_table_destroy (pending);
+
+  panel_debug_filtered (PANEL_DEBUG_APPLICATION, "flushed %u property writes, %u redundant "
+                        "writes suppressed so far", n_writes, journal_suppressed);
+
+release:
+
+  /* release the reference taken in panel_properties_journal_queue() */
+  if (journal_holds_xfconf)
+    {
+      journal_holds_xfconf = FALSE;
+      xfconf_shutdown ();
+    }
+}
+
+
+
+guint
+panel_properties_journal_get_suppressed (void)
+{
+  return journal_suppressed;
 }
@@ -42,6 +42,43 @@ void           panel_properties_bind                 (XfconfChannel       *chann
 
 void           panel_properties_unbind               (GObject             *object);
 
+void           panel_properties_snapshot_begin       (XfconfChannel       *channel);
+
+void           panel_properties_snapshot_end         (void);
+
+gboolean       panel_properties_get_property         (XfconfChannel       *channel,
+                                                      const gchar         *property,
+                                                      GValue              *value);
+
+gchar         *panel_properties_get_string           (XfconfChannel       *channel,
+                                                      const gchar         *property,
+                                                      const gchar         *default_value);
+
+gboolean       panel_properties_has_property         (XfconfChannel       *channel,
+                                                      const gchar         *property);
+
+void           panel_properties_journal_enable       (void);
+
+void           panel_properties_journal_set          (XfconfChannel       *channel,
+                                                      const gchar         *property,
+                                                      const GValue        *value);
+
+void           panel_properties_journal_set_string   (XfconfChannel       *channel,
+                                                      const gchar         *property,
+                                                      const gchar         *string);
+
+void           panel_properties_journal_set_arrayv   (XfconfChannel       *channel,
+                                                      const gchar         *property,
+                                                      GPtrArray           *values);
+
+void           panel_properties_journal_reset        (XfconfChannel       *channel,
+                                                      const gchar         *property,
+                                                      gboolean             recursive);
+
+void           panel_properties_journal_flush        (void);
+
+guint          panel_properties_journal_get_suppressed (void);
+
 GType          panel_properties_value_array_get_type (void) G_GNUC_CONST;
 
 #endif /* !__PANEL_XFCONF_H__ */
@@ -34,6 +34,27 @@
 
 
 
+typedef enum
+{
+  SOURCE_LOOKUP_THEME,  /* icon name in the icon theme */
+  SOURCE_LOOKUP_FILE,   /* file in one of the pixmaps folders */
+  SOURCE_LOOKUP_MISSING /* nothing found, use the fallback icon */
+}
+SourceLookupType;
+
+typedef struct
+{
+  SourceLookupType  type;
+  gchar            *name;
+}
+SourceLookup;
+
+
+
+static GQuark source_cache_quark = 0;
+
+
+
 /**
  * SECTION: convenience
  * @title: Convenience Functions
@@ -163,6 +184,122 @@ xfce_panel_get_channel_name (void)
 
 
 
+static void
+xfce_panel_pixbuf_source_lookup_free (gpointer data)
+{
+  SourceLookup *lookup = data;
+
+  g_free (lookup->name);
+  g_slice_free (SourceLookup, lookup);
+}
+
+
+
+static SourceLookup *
+xfce_panel_pixbuf_source_lookup_new (SourceLookupType  type,
+                                     gchar            *name)
+{
+  SourceLookup *lookup;
+
+  lookup = g_slice_new (SourceLookup);
+  lookup->type = type;
+  lookup->name = name;
+
+  return lookup;
+}
+
+
+
+static GHashTable *
+xfce_panel_pixbuf_source_cache (GtkIconTheme *icon_theme)
+{
+  GHashTable *cache;
+
+  if (G_UNLIKELY (source_cache_quark == 0))
+    source_cache_quark = g_quark_from_static_string ("xfce-panel-pixbuf-source-cache");
+
+  cache = g_object_get_qdata (G_OBJECT (icon_theme), source_cache_quark);
+  if (G_UNLIKELY (cache == NULL))
+    {
+      cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                     xfce_panel_pixbuf_source_lookup_free);
+      g_object_set_qdata_full (G_OBJECT (icon_theme), source_cache_quark, cache,
+                               (GDestroyNotify) g_hash_table_destroy);
+
+      /* the theme or its directories changed, resolve all names again */
+      g_signal_connect (G_OBJECT (icon_theme), "changed",
+          G_CALLBACK (xfce_panel_pixbuf_clear_source_cache), NULL);
+    }
+
+  return cache;
+}
+
+
+
+static GdkPixbuf *
+xfce_panel_pixbuf_source_lookup_load (const SourceLookup *lookup,
+                                      GtkIconTheme       *icon_theme,
+                                      gint                size)
+{
+  switch (lookup->type)
+    {
+    case SOURCE_LOOKUP_THEME:
+      return gtk_icon_theme_load_icon (icon_theme, lookup->name, size, 0, NULL);
+
+    case SOURCE_LOOKUP_FILE:
+      return gdk_pixbuf_new_from_file (lookup->name, NULL);
+
+    default:
+      return NULL;
+    }
+}
+
+
+
+static SourceLookup *
+xfce_panel_pixbuf_source_resolve (const gchar   *source,
+                                  GtkIconTheme  *icon_theme,
+                                  gint           size,
+                                  GdkPixbuf    **pixbuf)
+{
+  gchar *p;
+  gchar *name;
+  gchar *filename;
+
+  /* try to load from the icon theme */
+  *pixbuf = gtk_icon_theme_load_icon (icon_theme, source, size, 0, NULL);
+  if (G_LIKELY (*pixbuf != NULL))
+    return xfce_panel_pixbuf_source_lookup_new (SOURCE_LOOKUP_THEME, g_strdup (source));
+
+  /* try to lookup names like application.png in the theme */
+  p = strrchr (source, '.');
+  if (p != NULL)
+    {
+      name = g_strndup (source, p - source);
+      *pixbuf = gtk_icon_theme_load_icon (icon_theme, name, size, 0, NULL);
+      if (*pixbuf != NULL)
+        return xfce_panel_pixbuf_source_lookup_new (SOURCE_LOOKUP_THEME, name);
+      g_free (name);
+    }
+
+  /* maybe they point to a file in the pixbufs folder */
+  filename = g_build_filename ("pixmaps", source, NULL);
+  name = xfce_resource_lookup (XFCE_RESOURCE_DATA, filename);
+  g_free (filename);
+
+  if (name != NULL)
+    {
+      *pixbuf = gdk_pixbuf_new_from_file (name, NULL);
+      if (*pixbuf != NULL)
+        return xfce_panel_pixbuf_source_lookup_new (SOURCE_LOOKUP_FILE, name);
+      g_free (name);
+    }
+
+  return xfce_panel_pixbuf_source_lookup_new (SOURCE_LOOKUP_MISSING, NULL);
+}
+
+
+
 /**
  * xfce_panel_pixbuf_from_source_at_size:
  * @source: string that contains the location of an icon
@@ -181,6 +318,11 @@ xfce_panel_get_channel_name (void)
  * If it is when loaded from the disk, the pixbuf is scaled
  * preserving the aspect ratio.
  *
+ * How a source that is not an absolute path resolves is cached per
+ * icon theme, so the next lookup loads the icon directly. The cache
+ * is cleared when the icon theme changes, see also
+ * xfce_panel_pixbuf_clear_source_cache().
+ *
  * Returns: (transfer full): a GdkPixbuf or %NULL if nothing was found. The value should
  *          be released with g_object_unref when no longer used.
  *
@@ -194,15 +336,14 @@ xfce_panel_pixbuf_from_source_at_size (const gchar  *source,
                                        gint          dest_width,
                                        gint          dest_height)
 {
-  GdkPixbuf *pixbuf = NULL;
-  gchar     *p;
-  gchar     *name;
-  gchar     *filename;
-  gint       src_w, src_h;
-  gdouble    ratio;
-  GdkPixbuf *dest;
-  GError    *error = NULL;
-  gint       size = MIN (dest_width, dest_height);
+  GdkPixbuf    *pixbuf = NULL;
+  GHashTable   *cache;
+  SourceLookup *lookup;
+  gint          src_w, src_h;
+  gdouble       ratio;
+  GdkPixbuf    *dest;
+  GError       *error = NULL;
+  gint          size = MIN (dest_width, dest_height);
 
   g_return_val_if_fail (source != NULL, NULL);
   g_return_val_if_fail (icon_theme == NULL || GTK_IS_ICON_THEME (icon_theme), NULL);
@@ -224,32 +365,22 @@ xfce_panel_pixbuf_from_source_at_size (const gchar  *source,
       if (G_UNLIKELY (icon_theme == NULL))
         icon_theme = gtk_icon_theme_get_default ();
 
-      /* try to load from the icon theme */
-      pixbuf = gtk_icon_theme_load_icon (icon_theme, source, size, 0, NULL);
-      if (G_UNLIKELY (pixbuf == NULL))
+      /* load the icon from the previously resolved location */
+      cache = xfce_panel_pixbuf_source_cache (icon_theme);
+      lookup = g_hash_table_lookup (cache, source);
+      if (G_LIKELY (lookup != NULL))
         {
-          /* try to lookup names like application.png in the theme */
-          p = strrchr (source, '.');
-          if (p != NULL)
-            {
-              name = g_strndup (source, p - source);
-              pixbuf = gtk_icon_theme_load_icon (icon_theme, name, size, 0, NULL);
-              g_free (name);
-            }
-
-          /* maybe they point to a file in the pixbufs folder */
-          if (G_UNLIKELY (pixbuf == NULL))
-            {
-              filename = g_build_filename ("pixmaps", source, NULL);
-              name = xfce_resource_lookup (XFCE_RESOURCE_DATA, filename);
-              g_free (filename);
-
-              if (name != NULL)
-                {
-                  pixbuf = gdk_pixbuf_new_from_file (name, NULL);
-                  g_free (name);
-                }
-            }
+          pixbuf = xfce_panel_pixbuf_source_lookup_load (lookup, icon_theme, size);
+
+          /* the resolved icon is gone, try all locations again */
+          if (G_UNLIKELY (pixbuf == NULL && lookup->type != SOURCE_LOOKUP_MISSING))
+            lookup = NULL;
+        }
+
+      if (lookup == NULL)
+        {
+          lookup = xfce_panel_pixbuf_source_resolve (source, icon_theme, size, &pixbuf);
+          g_hash_table_replace (cache, g_strdup (source), lookup);
         }
     }
 
@@ -318,5 +449,36 @@ xfce_panel_pixbuf_from_source (const gchar  *source,
 
 
 
+/**
+ * xfce_panel_pixbuf_clear_source_cache:
+ * @icon_theme: (allow-none): icon theme or %NULL to use the default icon theme
+ *
+ * Forget how sources were resolved by xfce_panel_pixbuf_from_source_at_size()
+ * for @icon_theme. This happens automatically when the icon theme changes,
+ * but plugins that install icons in a pixmaps folder at runtime should
+ * call this so the new files are found.
+ *
+ * Since: 4.16
+ **/
+void
+xfce_panel_pixbuf_clear_source_cache (GtkIconTheme *icon_theme)
+{
+  GHashTable *cache;
+
+  g_return_if_fail (icon_theme == NULL || GTK_IS_ICON_THEME (icon_theme));
+
+  if (G_UNLIKELY (source_cache_quark == 0))
+    return;
+
+  if (icon_theme == NULL)
+    icon_theme = gtk_icon_theme_get_default ();
+
+  cache = g_object_get_qdata (G_OBJECT (icon_theme), source_cache_quark);
+  if (cache != NULL)
+    g_hash_table_remove_all (cache);
+}
+
+
+
 #define __XFCE_PANEL_CONVENIENCE_C__
 #include <libxfce4panel/libxfce4panel-aliasdef.c>
@@ -42,6 +42,8 @@ GdkPixbuf   *xfce_panel_pixbuf_from_source         (const gchar  *source,
                                                     GtkIconTheme *icon_theme,
                                                     gint          size) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
 
+void         xfce_panel_pixbuf_clear_source_cache  (GtkIconTheme *icon_theme);
+
 G_END_DECLS
 
 #endif /* !__XFCE_PANEL_CONVENIENCE_H__ */
@@ -101,6 +101,7 @@ static void          xfce_panel_plugin_set_nrows              (XfcePanelPluginPr
                                                                guint                             nrows);
 static void          xfce_panel_plugin_set_screen_position    (XfcePanelPluginProvider          *provider,
                                                                XfceScreenPosition                screen_position);
+static void          xfce_panel_plugin_geometry_emit          (XfcePanelPlugin                  *plugin);
 static void          xfce_panel_plugin_save                   (XfcePanelPluginProvider          *provider);
 static gboolean      xfce_panel_plugin_get_show_configure     (XfcePanelPluginProvider          *provider);
 static void          xfce_panel_plugin_show_configure         (XfcePanelPluginProvider          *provider);
@@ -154,6 +155,7 @@ enum
   SCREEN_POSITION_CHANGED,
   MODE_CHANGED,
   NROWS_CHANGED,
+  GEOMETRY_CHANGED,
   LAST_SIGNAL
 };
 
@@ -168,6 +170,16 @@ typedef enum
 }
 PluginFlags;
 
+typedef enum
+{
+  GEOMETRY_SIZE            = 1 << 0,
+  GEOMETRY_ICON_SIZE       = 1 << 1,
+  GEOMETRY_MODE            = 1 << 2,
+  GEOMETRY_NROWS           = 1 << 3,
+  GEOMETRY_SCREEN_POSITION = 1 << 4
+}
+GeometryFlags;
+
 struct _XfcePanelPluginPrivate
 {
   /* plugin information */
@@ -199,6 +211,11 @@ struct _XfcePanelPluginPrivate
 
   /* autohide block counter */
   gint                 panel_lock;
+
+  /* geometry freeze counter and the changes queued meanwhile */
+  gint                 geometry_freeze;
+  GeometryFlags        geometry_changed;
+  GtkOrientation       geometry_orientation;
 };
 
 
@@ -348,6 +365,35 @@ xfce_panel_plugin_class_init (XfcePanelPluginClass *klass)
                   g_cclosure_marshal_VOID__UINT,
                   G_TYPE_NONE, 1, G_TYPE_UINT);
 
+  /**
+   * XfcePanelPlugin::geometry-changed
+   * @plugin    : an #XfcePanelPlugin.
+   * @size      : the new size of the panel (all rows).
+   * @icon_size : the new icon size of the panel.
+   * @mode      : the new #XfcePanelPluginMode of the panel.
+   * @rows      : the new number of rows of the panel.
+   * @position  : the new #XfceScreenPosition of the panel.
+   *
+   * This signal is emmitted once after a batch of geometry changes
+   * of the panel the @plugin is on, after the individual
+   * #XfcePanelPlugin::mode-changed, #XfcePanelPlugin::nrows-changed,
+   * #XfcePanelPlugin::screen-position-changed and
+   * #XfcePanelPlugin::size-changed signals. Plugins that relayout on
+   * every change can use this to do the work only once.
+   *
+   * Since: 4.16
+   **/
+  plugin_signals[GEOMETRY_CHANGED] =
+    g_signal_new (g_intern_static_string ("geometry-changed"),
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  G_STRUCT_OFFSET (XfcePanelPluginClass, geometry_changed),
+                  NULL, NULL,
+                  _libxfce4panel_marshal_VOID__INT_INT_ENUM_UINT_ENUM,
+                  G_TYPE_NONE, 5, G_TYPE_INT, G_TYPE_INT,
+                  XFCE_TYPE_PANEL_PLUGIN_MODE, G_TYPE_UINT,
+                  XFCE_TYPE_SCREEN_POSITION);
+
   /**
    * XfcePanelPlugin::remote-event
    * @plugin : an #XfcePanelPlugin.
@@ -722,6 +768,9 @@ xfce_panel_plugin_init (XfcePanelPlugin *plugin)
   plugin->priv->locked = TRUE;
   plugin->priv->menu_items = NULL;
   plugin->priv->nrows = 1;
+  plugin->priv->geometry_freeze = 0;
+  plugin->priv->geometry_changed = 0;
+  plugin->priv->geometry_orientation = GTK_ORIENTATION_HORIZONTAL;
 
   /* bind the text domain of the panel so our strings
    * are properly translated in the old 4.6 panel plugins */
@@ -1447,24 +1496,64 @@ xfce_panel_plugin_unregister_menu (GtkMenu         *menu,
 
 
 static void
-xfce_panel_plugin_set_size (XfcePanelPluginProvider *provider,
-                            gint                     size)
+xfce_panel_plugin_geometry_emit (XfcePanelPlugin *plugin)
 {
-  XfcePanelPlugin *plugin = XFCE_PANEL_PLUGIN (provider);
-  gboolean         handled = FALSE;
-  gint             real_size;
+  GeometryFlags  changed = plugin->priv->geometry_changed;
+  gboolean       handled = FALSE;
+  gint           real_size;
+  GtkOrientation new_orientation;
 
-  panel_return_if_fail (XFCE_IS_PANEL_PLUGIN (provider));
+  panel_return_if_fail (XFCE_IS_PANEL_PLUGIN (plugin));
 
-  /* check if update is required, -1 for forced property emit
-   * by xfce_panel_plugin_set_nrows */
-  if (G_LIKELY (plugin->priv->size != size))
+  plugin->priv->geometry_changed = 0;
+
+  g_object_freeze_notify (G_OBJECT (plugin));
+
+  /* emit the individual signals once, in the order the setters
+   * used to, so existing plugins keep working unchanged */
+  if (PANEL_HAS_FLAG (changed, GEOMETRY_MODE))
     {
-      if (size != -1)
-        plugin->priv->size = size;
+      g_signal_emit (G_OBJECT (plugin),
+                     plugin_signals[MODE_CHANGED], 0, plugin->priv->mode);
 
-      real_size = plugin->priv->size * plugin->priv->nrows;
+      g_object_notify_by_pspec (G_OBJECT (plugin), plugin_props[PROP_MODE]);
 
+      /* emit old orientation property for compatibility */
+      new_orientation = xfce_panel_plugin_get_orientation (plugin);
+      if (plugin->priv->geometry_orientation != new_orientation)
+        {
+          g_signal_emit (G_OBJECT (plugin),
+                         plugin_signals[ORIENTATION_CHANGED], 0, new_orientation);
+
+          g_object_notify_by_pspec (G_OBJECT (plugin), plugin_props[PROP_ORIENTATION]);
+        }
+    }
+
+  if (PANEL_HAS_FLAG (changed, GEOMETRY_NROWS))
+    {
+      g_signal_emit (G_OBJECT (plugin),
+                     plugin_signals[NROWS_CHANGED], 0, plugin->priv->nrows);
+
+      g_object_notify_by_pspec (G_OBJECT (plugin), plugin_props[PROP_NROWS]);
+    }
+
+  if (PANEL_HAS_FLAG (changed, GEOMETRY_SCREEN_POSITION))
+    {
+      g_signal_emit (G_OBJECT (plugin),
+                     plugin_signals[SCREEN_POSITION_CHANGED], 0,
+                     plugin->priv->screen_position);
+
+      g_object_notify_by_pspec (G_OBJECT (plugin), plugin_props[PROP_SCREEN_POSITION]);
+    }
+
+  if (PANEL_HAS_FLAG (changed, GEOMETRY_ICON_SIZE))
+    g_object_notify_by_pspec (G_OBJECT (plugin), plugin_props[PROP_ICON_SIZE]);
+
+  /* a new icon size or number of rows also requires a size update,
+   * so the icons get re-rendered */
+  real_size = plugin->priv->size * plugin->priv->nrows;
+  if (PANEL_HAS_FLAG (changed, GEOMETRY_SIZE | GEOMETRY_ICON_SIZE | GEOMETRY_NROWS))
+    {
       g_signal_emit (G_OBJECT (plugin),
                      plugin_signals[SIZE_CHANGED], 0, real_size, &handled);
 
@@ -1474,6 +1563,34 @@ xfce_panel_plugin_set_size (XfcePanelPluginProvider *provider,
 
       g_object_notify_by_pspec (G_OBJECT (plugin), plugin_props[PROP_SIZE]);
     }
+
+  g_signal_emit (G_OBJECT (plugin), plugin_signals[GEOMETRY_CHANGED], 0,
+                 real_size, plugin->priv->icon_size, plugin->priv->mode,
+                 plugin->priv->nrows, plugin->priv->screen_position);
+
+  g_object_thaw_notify (G_OBJECT (plugin));
+}
+
+
+
+static void
+xfce_panel_plugin_set_size (XfcePanelPluginProvider *provider,
+                            gint                     size)
+{
+  XfcePanelPlugin *plugin = XFCE_PANEL_PLUGIN (provider);
+
+  panel_return_if_fail (XFCE_IS_PANEL_PLUGIN (provider));
+
+  /* check if update is required */
+  if (G_LIKELY (plugin->priv->size != size))
+    {
+      xfce_panel_plugin_freeze_geometry (plugin);
+
+      plugin->priv->size = size;
+      PANEL_SET_FLAG (plugin->priv->geometry_changed, GEOMETRY_SIZE);
+
+      xfce_panel_plugin_thaw_geometry (plugin);
+    }
 }
 
 
@@ -1484,13 +1601,16 @@ xfce_panel_plugin_set_icon_size (XfcePanelPluginProvider *provider,
 {
   XfcePanelPlugin *plugin = XFCE_PANEL_PLUGIN (provider);
 
+  panel_return_if_fail (XFCE_IS_PANEL_PLUGIN (provider));
+
   if (G_LIKELY (plugin->priv->icon_size != icon_size))
     {
+      xfce_panel_plugin_freeze_geometry (plugin);
+
       plugin->priv->icon_size = icon_size;
-      g_object_notify_by_pspec (G_OBJECT (plugin), plugin_props[PROP_ICON_SIZE]);
+      PANEL_SET_FLAG (plugin->priv->geometry_changed, GEOMETRY_ICON_SIZE);
 
-      /* also update the size so the icon gets re-rendered */
-      xfce_panel_plugin_set_size (provider, -1);
+      xfce_panel_plugin_thaw_geometry (plugin);
     }
 }
 
@@ -1501,32 +1621,18 @@ xfce_panel_plugin_set_mode (XfcePanelPluginProvider *provider,
                             XfcePanelPluginMode      mode)
 {
   XfcePanelPlugin *plugin = XFCE_PANEL_PLUGIN (provider);
-  GtkOrientation   old_orientation;
-  GtkOrientation   new_orientation;
 
   panel_return_if_fail (XFCE_IS_PANEL_PLUGIN (provider));
 
   /* check if update is required */
   if (G_LIKELY (plugin->priv->mode != mode))
     {
-      old_orientation = xfce_panel_plugin_get_orientation (plugin);
+      xfce_panel_plugin_freeze_geometry (plugin);
 
       plugin->priv->mode = mode;
+      PANEL_SET_FLAG (plugin->priv->geometry_changed, GEOMETRY_MODE);
 
-      g_signal_emit (G_OBJECT (plugin),
-                     plugin_signals[MODE_CHANGED], 0, mode);
-
-      g_object_notify_by_pspec (G_OBJECT (plugin), plugin_props[PROP_MODE]);
-
-      /* emit old orientation property for compatibility */
-      new_orientation = xfce_panel_plugin_get_orientation (plugin);
-      if (old_orientation != new_orientation)
-        {
-          g_signal_emit (G_OBJECT (plugin),
-                         plugin_signals[ORIENTATION_CHANGED], 0, new_orientation);
-
-          g_object_notify_by_pspec (G_OBJECT (plugin), plugin_props[PROP_ORIENTATION]);
-        }
+      xfce_panel_plugin_thaw_geometry (plugin);
     }
 }
 
@@ -1545,15 +1651,12 @@ xfce_panel_plugin_set_nrows (XfcePanelPluginProvider *provider,
   /* check if update is required */
   if (G_LIKELY (plugin->priv->nrows != nrows))
     {
-      plugin->priv->nrows = nrows;
-
-      g_signal_emit (G_OBJECT (plugin),
-                     plugin_signals[NROWS_CHANGED], 0, nrows);
+      xfce_panel_plugin_freeze_geometry (plugin);
 
-      g_object_notify_by_pspec (G_OBJECT (plugin), plugin_props[PROP_NROWS]);
+      plugin->priv->nrows = nrows;
+      PANEL_SET_FLAG (plugin->priv->geometry_changed, GEOMETRY_NROWS);
 
-      /* also the size changed */
-      xfce_panel_plugin_set_size (provider, -1);
+      xfce_panel_plugin_thaw_geometry (plugin);
     }
 }
 
@@ -1571,13 +1674,12 @@ xfce_panel_plugin_set_screen_position (XfcePanelPluginProvider *provider,
   if (G_LIKELY (plugin->priv->screen_position != screen_position
       || xfce_screen_position_is_floating (screen_position)))
     {
-      plugin->priv->screen_position = screen_position;
+      xfce_panel_plugin_freeze_geometry (plugin);
 
-      g_signal_emit (G_OBJECT (plugin),
-                     plugin_signals[SCREEN_POSITION_CHANGED], 0,
-                     screen_position);
+      plugin->priv->screen_position = screen_position;
+      PANEL_SET_FLAG (plugin->priv->geometry_changed, GEOMETRY_SCREEN_POSITION);
 
-      g_object_notify_by_pspec (G_OBJECT (plugin), plugin_props[PROP_SCREEN_POSITION]);
+      xfce_panel_plugin_thaw_geometry (plugin);
     }
 }
 
@@ -2865,6 +2967,58 @@ xfce_panel_plugin_block_autohide (XfcePanelPlugin *plugin,
 
 
 
+/**
+ * xfce_panel_plugin_freeze_geometry:
+ * @plugin : an #XfcePanelPlugin.
+ *
+ * Defers the geometry signals (#XfcePanelPlugin::size-changed,
+ * #XfcePanelPlugin::mode-changed, #XfcePanelPlugin::nrows-changed,
+ * #XfcePanelPlugin::screen-position-changed and their properties) of
+ * @plugin until the matching xfce_panel_plugin_thaw_geometry(). This
+ * is used by the panel around a batch of property changes, so each
+ * signal is emitted once with the final value, followed by a single
+ * #XfcePanelPlugin::geometry-changed.
+ *
+ * Calls can be nested.
+ *
+ * Since: 4.16
+ **/
+void
+xfce_panel_plugin_freeze_geometry (XfcePanelPlugin *plugin)
+{
+  g_return_if_fail (XFCE_IS_PANEL_PLUGIN (plugin));
+  g_return_if_fail (plugin->priv->geometry_freeze >= 0);
+
+  /* remember the orientation to detect a change on thaw */
+  if (plugin->priv->geometry_freeze++ == 0)
+    plugin->priv->geometry_orientation = xfce_panel_plugin_get_orientation (plugin);
+}
+
+
+
+/**
+ * xfce_panel_plugin_thaw_geometry:
+ * @plugin : an #XfcePanelPlugin.
+ *
+ * Reverts the effect of a previous call to
+ * xfce_panel_plugin_freeze_geometry(). When the freeze count drops
+ * to zero, the geometry signals queued meanwhile are emitted.
+ *
+ * Since: 4.16
+ **/
+void
+xfce_panel_plugin_thaw_geometry (XfcePanelPlugin *plugin)
+{
+  g_return_if_fail (XFCE_IS_PANEL_PLUGIN (plugin));
+  g_return_if_fail (plugin->priv->geometry_freeze > 0);
+
+  if (--plugin->priv->geometry_freeze == 0
+      && plugin->priv->geometry_changed != 0)
+    xfce_panel_plugin_geometry_emit (plugin);
+}
+
+
+
 /**
  * xfce_panel_plugin_lookup_rc_file:
  * @plugin : an #XfcePanelPlugin.
@@ -99,6 +99,7 @@ typedef gboolean (*XfcePanelPluginCheck) (GdkScreen *screen);
  * @remote_event :            See #XfcePanelPlugin::remote-event for more information.
  * @mode_changed :            See #XfcePanelPlugin::mode-changed for more information.
  * @nrows_changed :           See #XfcePanelPlugin::nrows-changed for more information.
+ * @geometry_changed :        See #XfcePanelPlugin::geometry-changed for more information. Since 4.16.
  *
  * Class of an #XfcePanelPlugin. The interface can be used to create GObject based plugin.
  **/
@@ -133,8 +134,15 @@ struct _XfcePanelPluginClass
   void     (*nrows_changed)           (XfcePanelPlugin    *plugin,
                                        guint               rows);
 
+  /* new in 4.16 */
+  void     (*geometry_changed)        (XfcePanelPlugin    *plugin,
+                                       gint                size,
+                                       gint                icon_size,
+                                       XfcePanelPluginMode mode,
+                                       guint               rows,
+                                       XfceScreenPosition  position);
+
   /*< private >*/
-  void (*reserved1) (void);
   void (*reserved2) (void);
 };
 
@@ -241,6 +249,10 @@ void                  xfce_panel_plugin_focus_widget        (XfcePanelPlugin   *
 void                  xfce_panel_plugin_block_autohide      (XfcePanelPlugin   *plugin,
                                                              gboolean           blocked);
 
+void                  xfce_panel_plugin_freeze_geometry     (XfcePanelPlugin   *plugin);
+
+void                  xfce_panel_plugin_thaw_geometry       (XfcePanelPlugin   *plugin);
+
 gchar                *xfce_panel_plugin_lookup_rc_file      (XfcePanelPlugin   *plugin) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
 
 gchar                *xfce_panel_plugin_save_location       (XfcePanelPlugin   *plugin,
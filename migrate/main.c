@@ -65,6 +65,32 @@ main (gint argc, gchar **argv)
   g_log_set_always_fatal (G_LOG_LEVEL_CRITICAL | G_LOG_LEVEL_WARNING);
 #endif
 
+  /* precompile the default configuration next to the xml file, so
+   * first logins can skip parsing it */
+  if (argc == 2 && strcmp (argv[1], "--compile-default") == 0)
+    {
+      xfce_resource_push_path (XFCE_RESOURCE_CONFIG, XDGCONFIGDIR);
+      filename_default = xfce_resource_lookup (XFCE_RESOURCE_CONFIG, DEFAULT_CONFIG_FILENAME);
+      xfce_resource_pop_path (XFCE_RESOURCE_CONFIG);
+
+      if (filename_default == NULL)
+        {
+          g_printerr ("No default configuration found\n");
+          return EXIT_FAILURE;
+        }
+
+      if (!migrate_default_compile (filename_default, &error))
+        {
+          g_printerr ("Failed to compile \"%s\": %s\n", filename_default, error->message);
+          g_error_free (error);
+          retval = EXIT_FAILURE;
+        }
+
+      g_free (filename_default);
+
+      return retval;
+    }
+
   gtk_init (&argc, &argv);
 
   if (!xfconf_init (&error))
@@ -26,7 +26,11 @@
 #ifdef HAVE_STRING_H
 #include <string.h>
 #endif
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
 
+#include <glib/gstdio.h>
 #include <gtk/gtk.h>
 #include <xfconf/xfconf.h>
 #include <libxfce4util/libxfce4util.h>
@@ -35,14 +39,35 @@
 
 
 
+#define XFCONF_DBUS_NAME      "org.xfce.Xfconf"
+#define XFCONF_DBUS_PATH      "/org/xfce/Xfconf"
+#define XFCONF_DBUS_INTERFACE "org.xfce.Xfconf"
+
+/* format of the precompiled configuration: a version, the size and
+ * modification time of the xml file it was compiled from, the channel
+ * name and all property paths with their values */
+#define COMPILED_TYPE         "(utxsa{sv})"
+#define COMPILED_VERSION      (2)
+#define COMPILED_SUFFIX       ".gvariant"
+
+
+
 typedef struct
 {
-  XfconfChannel *channel;
-  GSList        *path;
-  GPtrArray     *array;
+  gchar           *channel_name;
+  GSList          *path;
+  GVariantBuilder *array;
+  GVariantBuilder *properties;
 }
 ConfigParser;
 
+typedef struct
+{
+  guint   pending;
+  GError *error;
+}
+ConfigCommit;
+
 
 
 static GType
@@ -68,32 +93,29 @@ migrate_default_gtype_from_string (const gchar *type)
 
 
 
-static void
-migrate_default_set_value (GValue      *value,
+static GVariant *
+migrate_default_value_new (GType        type,
                            const gchar *string)
 {
-  switch (G_VALUE_TYPE (value))
+  switch (type)
     {
     case G_TYPE_STRING:
-      g_value_set_string (value, string);
-      break;
+      return g_variant_new_string (string);
 
     case G_TYPE_UINT:
-      g_value_set_uint (value, strtol (string, NULL, 0));
-      break;
+      return g_variant_new_uint32 (strtol (string, NULL, 0));
 
     case G_TYPE_INT:
-      g_value_set_int (value, strtoul (string, NULL, 0));
-      break;
+      return g_variant_new_int32 (strtoul (string, NULL, 0));
 
     case G_TYPE_DOUBLE:
-      g_value_set_double (value, g_ascii_strtod (string, NULL));
-      break;
+      return g_variant_new_double (g_ascii_strtod (string, NULL));
 
     case G_TYPE_BOOLEAN:
-      g_value_set_boolean (value, strcmp (string, "true") == 0);
-      break;
+      return g_variant_new_boolean (strcmp (string, "true") == 0);
 
+    default:
+      return NULL;
     }
 }
 
@@ -118,6 +140,25 @@ migrate_default_property_path (ConfigParser *parser)
 
 
 
+static void
+migrate_default_flush_array (ConfigParser *parser)
+{
+  gchar *prop_path;
+
+  if (parser->array == NULL)
+    return;
+
+  prop_path = migrate_default_property_path (parser);
+  g_variant_builder_add (parser->properties, "{sv}", prop_path,
+                         g_variant_builder_end (parser->array));
+  g_free (prop_path);
+
+  g_variant_builder_unref (parser->array);
+  parser->array = NULL;
+}
+
+
+
 static void
 migrate_default_start_element_handler (GMarkupParseContext  *context,
                                        const gchar          *element_name,
@@ -132,9 +173,8 @@ migrate_default_start_element_handler (GMarkupParseContext  *context,
   const gchar  *prop_name, *prop_value, *prop_type;
   GType         type;
   gchar        *prop_path;
-  GValue        value = { 0, };
+  GVariant     *value;
   const gchar  *value_value, *value_type;
-  GValue       *value2;
 
   if (strcmp (element_name, "channel") == 0)
     {
@@ -145,25 +185,19 @@ migrate_default_start_element_handler (GMarkupParseContext  *context,
           for (i = 0; attribute_names[i] != NULL; i++)
             {
               if (strcmp (attribute_names[i], "name") == 0)
-                {
-                  channel_name = attribute_values[i];
-
-                  /* this is an xfce4-panel workaround to make it work
-                   * with the custom channel names */
-                  channel_name = XFCE_PANEL_CHANNEL_NAME;
-                }
+                channel_name = attribute_values[i];
             }
         }
 
-      if (channel_name != NULL)
+      if (G_UNLIKELY (channel_name == NULL))
         {
-          /* open the xfconf channel */
-          parser->channel = xfconf_channel_get (channel_name);
+          g_set_error_literal (error, G_MARKUP_ERROR_INVALID_CONTENT, G_MARKUP_ERROR,
+                               "The channel element has no name attribute");
         }
       else
         {
-          g_set_error_literal (error, G_MARKUP_ERROR_INVALID_CONTENT, G_MARKUP_ERROR,
-                               "The channel element has no name attribute");
+          g_free (parser->channel_name);
+          parser->channel_name = g_strdup (channel_name);
         }
     }
   else if (strcmp (element_name, "property") == 0)
@@ -173,15 +207,7 @@ migrate_default_start_element_handler (GMarkupParseContext  *context,
       prop_type = NULL;
 
       /* check if we need to flush an array */
-      if (parser->array != NULL)
-        {
-          prop_path = migrate_default_property_path (parser);
-          xfconf_channel_set_arrayv (parser->channel, prop_path, parser->array);
-          g_free (prop_path);
-
-          xfconf_array_free (parser->array);
-          parser->array = NULL;
-        }
+      migrate_default_flush_array (parser);
 
       if (G_LIKELY (attribute_names != NULL))
         {
@@ -210,18 +236,15 @@ migrate_default_start_element_handler (GMarkupParseContext  *context,
             }
           if (type == G_TYPE_BOXED)
             {
-              parser->array = g_ptr_array_new ();
+              parser->array = g_variant_builder_new (G_VARIANT_TYPE ("av"));
             }
           else if (type != G_TYPE_NONE && prop_value != NULL)
             {
-              g_value_init (&value, type);
-              migrate_default_set_value (&value, prop_value);
+              value = migrate_default_value_new (type, prop_value);
 
               prop_path = migrate_default_property_path (parser);
-              xfconf_channel_set_property (parser->channel, prop_path, &value);
+              g_variant_builder_add (parser->properties, "{sv}", prop_path, value);
               g_free (prop_path);
-
-              g_value_unset (&value);
             }
         }
       else
@@ -255,12 +278,8 @@ migrate_default_start_element_handler (GMarkupParseContext  *context,
 
               if (type != G_TYPE_INVALID && type != G_TYPE_NONE && type != G_TYPE_BOXED)
                 {
-                  value2 = g_new0 (GValue, 1);
-                  g_value_init (value2, type);
-
-                  migrate_default_set_value (value2, value_value);
-
-                  g_ptr_array_add (parser->array, value2);
+                  value = migrate_default_value_new (type, value_value);
+                  g_variant_builder_add (parser->array, "v", value);
                 }
               else
                 {
@@ -298,13 +317,9 @@ migrate_default_end_element_handler (GMarkupParseContext  *context,
 {
   ConfigParser *parser = user_data;
   GSList       *li;
-  gchar        *prop_path;
 
   if (strcmp (element_name, "channel") == 0)
     {
-      if (G_LIKELY (parser->channel != NULL))
-        parser->channel = NULL;
-
      if (parser->path != NULL)
        {
          g_set_error_literal (error, G_MARKUP_ERROR_UNKNOWN_ELEMENT, G_MARKUP_ERROR,
@@ -313,15 +328,7 @@ migrate_default_end_element_handler (GMarkupParseContext  *context,
     }
   else if (strcmp (element_name, "property") == 0)
     {
-      if (parser->array != NULL)
-        {
-          prop_path = migrate_default_property_path (parser);
-          xfconf_channel_set_arrayv (parser->channel, prop_path, parser->array);
-          g_free (prop_path);
-
-          xfconf_array_free (parser->array);
-          parser->array = NULL;
-        }
+      migrate_default_flush_array (parser);
 
       li = g_slist_last (parser->path);
       if (li != NULL)
@@ -359,24 +366,24 @@ static GMarkupParser markup_parser =
 
 
 
-gboolean
-migrate_default (const gchar    *filename,
-                 GError        **error)
+static GVariant *
+migrate_default_parse (const gchar  *filename,
+                       gchar       **channel_name,
+                       GError      **error)
 {
   gsize                length;
   gchar               *contents;
   GMarkupParseContext *context;
   ConfigParser        *parser;
-  gboolean             succeed = FALSE;
-
-  g_return_val_if_fail (filename != NULL, FALSE);
-  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+  GVariant            *properties = NULL;
 
   if (!g_file_get_contents (filename, &contents, &length, error))
-    return FALSE;
+    return NULL;
 
   parser = g_slice_new0 (ConfigParser);
   parser->path = NULL;
+  parser->array = NULL;
+  parser->properties = g_variant_builder_new (G_VARIANT_TYPE ("a{sv}"));
 
   context = g_markup_parse_context_new (&markup_parser, 0, parser, NULL);
 
@@ -384,12 +391,260 @@ migrate_default (const gchar    *filename,
     {
       /* check if the entire file is parsed */
       if (g_markup_parse_context_end_parse (context, error))
-        succeed = TRUE;
+        {
+          if (G_LIKELY (parser->channel_name != NULL))
+            {
+              properties = g_variant_ref_sink (g_variant_builder_end (parser->properties));
+              *channel_name = g_strdup (parser->channel_name);
+            }
+          else
+            {
+              g_set_error_literal (error, G_MARKUP_ERROR, G_MARKUP_ERROR_INVALID_CONTENT,
+                                   "The file contains no channel element");
+            }
+        }
     }
 
   g_free (contents);
   g_markup_parse_context_free (context);
+
+  if (parser->array != NULL)
+    g_variant_builder_unref (parser->array);
+  g_slist_free_full (parser->path, g_free);
+  g_free (parser->channel_name);
+  g_variant_builder_unref (parser->properties);
   g_slice_free (ConfigParser, parser);
 
+  return properties;
+}
+
+
+
+static gchar *
+migrate_default_compiled_filename (const gchar *filename)
+{
+  gchar *basename;
+  gchar *compiled;
+
+  if (g_str_has_suffix (filename, ".xml"))
+    {
+      basename = g_strndup (filename, strlen (filename) - strlen (".xml"));
+      compiled = g_strconcat (basename, COMPILED_SUFFIX, NULL);
+      g_free (basename);
+
+      return compiled;
+    }
+
+  return g_strconcat (filename, COMPILED_SUFFIX, NULL);
+}
+
+
+
+static GVariant *
+migrate_default_load_compiled (const gchar  *filename,
+                               gchar       **channel_name)
+{
+  gchar       *compiled;
+  GStatBuf     xml_stat;
+  GMappedFile *mapped;
+  GBytes      *bytes;
+  GVariant    *variant;
+  GVariant    *properties = NULL;
+  guint32      version;
+  guint64      xml_size;
+  gint64       xml_mtime;
+  const gchar *name;
+
+  if (g_stat (filename, &xml_stat) != 0)
+    return NULL;
+
+  compiled = migrate_default_compiled_filename (filename);
+  mapped = g_mapped_file_new (compiled, FALSE, NULL);
+  g_free (compiled);
+  if (mapped == NULL)
+    return NULL;
+
+  bytes = g_mapped_file_get_bytes (mapped);
+  variant = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (COMPILED_TYPE),
+                                                          bytes, FALSE));
+  g_bytes_unref (bytes);
+  g_mapped_file_unref (mapped);
+
+  /* only use the compiled file if it was compiled from this exact
+   * xml file, package installs keep the mtimes of the archive so
+   * a newer compiled file says nothing */
+  g_variant_get (variant, "(utx&s@a{sv})", &version, &xml_size, &xml_mtime,
+                 &name, &properties);
+  if (version == COMPILED_VERSION
+      && xml_size == (guint64) xml_stat.st_size
+      && xml_mtime == (gint64) xml_stat.st_mtime)
+    {
+      *channel_name = g_strdup (name);
+    }
+  else
+    {
+      g_variant_unref (properties);
+      properties = NULL;
+    }
+
+  g_variant_unref (variant);
+
+  return properties;
+}
+
+
+
+static void
+migrate_default_commit_ready (GObject      *source_object,
+                              GAsyncResult *result,
+                              gpointer      user_data)
+{
+  ConfigCommit *commit = user_data;
+  GVariant     *reply;
+  GError       *error = NULL;
+
+  reply = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source_object), result, &error);
+  if (reply != NULL)
+    g_variant_unref (reply);
+  else if (commit->error == NULL)
+    commit->error = error;
+  else
+    g_error_free (error);
+
+  commit->pending--;
+}
+
+
+
+static gboolean
+migrate_default_commit (const gchar  *channel_name,
+                        GVariant     *properties,
+                        GError      **error)
+{
+  GDBusConnection *connection;
+  GVariantIter     iter;
+  const gchar     *prop_path;
+  GVariant        *value;
+  ConfigCommit     commit = { 0, NULL };
+
+  /* this is an xfce4-panel workaround to make it work
+   * with the custom channel names */
+  if (g_strcmp0 (channel_name, "xfce4-panel") == 0)
+    channel_name = XFCE_PANEL_CHANNEL_NAME;
+
+  connection = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, error);
+  if (G_UNLIKELY (connection == NULL))
+    return FALSE;
+
+  /* send all properties to xfconfd without waiting for the replies
+   * in between, so the import costs a single round trip */
+  g_variant_iter_init (&iter, properties);
+  while (g_variant_iter_next (&iter, "{&sv}", &prop_path, &value))
+    {
+      g_dbus_connection_call (connection,
+                              XFCONF_DBUS_NAME,
+                              XFCONF_DBUS_PATH,
+                              XFCONF_DBUS_INTERFACE,
+                              "SetProperty",
+                              g_variant_new ("(ssv)", channel_name,
+                                             prop_path, value),
+                              NULL,
+                              G_DBUS_CALL_FLAGS_NONE,
+                              -1,
+                              NULL,
+                              migrate_default_commit_ready,
+                              &commit);
+      g_variant_unref (value);
+
+      commit.pending++;
+    }
+
+  while (commit.pending > 0)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_object_unref (G_OBJECT (connection));
+
+  if (commit.error != NULL)
+    {
+      g_propagate_error (error, commit.error);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+
+
+gboolean
+migrate_default (const gchar    *filename,
+                 GError        **error)
+{
+  GVariant *properties;
+  gchar    *channel_name = NULL;
+  gboolean  succeed;
+
+  g_return_val_if_fail (filename != NULL, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  /* skip parsing the xml file if it has been precompiled */
+  properties = migrate_default_load_compiled (filename, &channel_name);
+  if (properties == NULL)
+    {
+      properties = migrate_default_parse (filename, &channel_name, error);
+      if (properties == NULL)
+        return FALSE;
+    }
+
+  succeed = migrate_default_commit (channel_name, properties, error);
+  g_variant_unref (properties);
+  g_free (channel_name);
+
+  return succeed;
+}
+
+
+
+gboolean
+migrate_default_compile (const gchar  *filename,
+                         GError      **error)
+{
+  GVariant *properties;
+  GVariant *variant;
+  gchar    *compiled;
+  gchar    *channel_name = NULL;
+  GStatBuf  xml_stat;
+  gboolean  succeed;
+
+  g_return_val_if_fail (filename != NULL, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (g_stat (filename, &xml_stat) != 0)
+    {
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                   "Failed to stat \"%s\": %s", filename, g_strerror (errno));
+      return FALSE;
+    }
+
+  properties = migrate_default_parse (filename, &channel_name, error);
+  if (properties == NULL)
+    return FALSE;
+
+  /* remember which xml file this is compiled from */
+  variant = g_variant_ref_sink (g_variant_new ("(utxs@a{sv})", COMPILED_VERSION,
+                                               (guint64) xml_stat.st_size,
+                                               (gint64) xml_stat.st_mtime,
+                                               channel_name, properties));
+  g_variant_unref (properties);
+  g_free (channel_name);
+
+  /* store the variant in its serialized form, this is loaded
+   * with a plain mmap on first login */
+  compiled = migrate_default_compiled_filename (filename);
+  succeed = g_file_set_contents (compiled, g_variant_get_data (variant),
+                                 g_variant_get_size (variant), error);
+  g_free (compiled);
+
+  g_variant_unref (variant);
+
   return succeed;
 }
@@ -51,8 +51,18 @@
 #include <panel/panel-dbus-client.h>
 #include <panel/panel-preferences-dialog.h>
 
+/* default stall threshold of the watchdog in milliseconds */
+#define WATCHDOG_THRESHOLD (250)
+
+
+
 static PanelApplication *application = NULL;
 
+/* main loop watchdog */
+static GThread          *watchdog = NULL;
+static gint              watchdog_beats = 0;
+static gint              watchdog_quit = 0;
+
 static gint       opt_preferences = -1;
 static gint       opt_add_items = -1;
 static gboolean   opt_save = FALSE;
@@ -64,6 +74,8 @@ static gboolean   opt_disable_wm_check = FALSE;
 static gchar     *opt_plugin_event = NULL;
 static gchar    **opt_arguments = NULL;
 static guint      opt_socket_id = 0;
+static gboolean   opt_profile_startup = FALSE;
+static gint       opt_watchdog = 0;
 
 
 
@@ -85,6 +97,8 @@ static GOptionEntry option_entries[] =
   { "restart", 'r', 0, G_OPTION_ARG_NONE, &opt_restart, N_("Restart the running panel instance"), NULL },
   { "quit", 'q', 0, G_OPTION_ARG_NONE, &opt_quit, N_("Quit the running panel instance"), NULL },
   { "disable-wm-check", 'd', 0, G_OPTION_ARG_NONE, &opt_disable_wm_check, N_("Do not wait for a window manager on startup"), NULL },
+  { "profile-startup", '\0', 0, G_OPTION_ARG_NONE, &opt_profile_startup, N_("Print where the time went during startup"), NULL },
+  { "watchdog", '\0', 0, G_OPTION_ARG_INT, &opt_watchdog, N_("Log when the panel is blocked for more than MS milliseconds"), N_("MS") },
   { "version", 'V', 0, G_OPTION_ARG_NONE, &opt_version, N_("Print version information and exit"), NULL },
   { "plugin-event", '\0', G_OPTION_FLAG_HIDDEN, G_OPTION_ARG_STRING, &opt_plugin_event, NULL, NULL },
   { "socket-id", '\0', G_OPTION_FLAG_HIDDEN, G_OPTION_ARG_INT, &opt_socket_id, NULL, NULL },
@@ -199,6 +213,104 @@ panel_debug_notify_proxy (void)
 
 
 
+static gboolean
+panel_watchdog_heartbeat (gpointer user_data)
+{
+  g_atomic_int_inc (&watchdog_beats);
+
+  return TRUE;
+}
+
+
+
+static gpointer
+panel_watchdog_thread (gpointer user_data)
+{
+  gint64       threshold = GPOINTER_TO_INT (user_data) * G_GINT64_CONSTANT (1000);
+  gint64       now;
+  gint64       last_beat_time;
+  gint         beats, last_beats;
+  const gchar *label = NULL;
+  gboolean     stalled = FALSE;
+
+  last_beats = g_atomic_int_get (&watchdog_beats);
+  last_beat_time = g_get_monotonic_time ();
+
+  while (!g_atomic_int_get (&watchdog_quit))
+    {
+      g_usleep (threshold / 4);
+
+      now = g_get_monotonic_time ();
+      beats = g_atomic_int_get (&watchdog_beats);
+
+      if (beats != last_beats)
+        {
+          if (G_UNLIKELY (stalled))
+            {
+              /* the measured time is accurate to half the threshold */
+              panel_debug_filtered (PANEL_DEBUG_WATCHDOG,
+                                    "main loop was blocked for %.0f ms in %s",
+                                    (now - last_beat_time) / 1000.0,
+                                    label != NULL ? label : "an unknown callback");
+
+              panel_debug_watchdog_add_stall (now - last_beat_time, label);
+              stalled = FALSE;
+            }
+
+          last_beats = beats;
+          last_beat_time = now;
+        }
+      else if (!stalled && now - last_beat_time > threshold)
+        {
+          /* the main loop is still inside the blocking callback, so
+           * this is the moment to ask what it is doing */
+          label = panel_debug_watchdog_get_label ();
+          stalled = TRUE;
+
+          panel_debug_filtered (PANEL_DEBUG_WATCHDOG,
+                                "main loop blocked for more than %d ms in %s",
+                                GPOINTER_TO_INT (user_data),
+                                label != NULL ? label : "an unknown callback");
+        }
+    }
+
+  return NULL;
+}
+
+
+
+static void
+panel_watchdog_start (gint threshold)
+{
+  panel_return_if_fail (watchdog == NULL);
+  panel_return_if_fail (threshold > 0);
+
+  panel_debug_watchdog_enable ();
+
+  /* beat a few times per threshold, with a high priority so only
+   * callbacks that block the loop delay it */
+  g_timeout_add_full (G_PRIORITY_HIGH, MAX (threshold / 4, 1),
+                      panel_watchdog_heartbeat, NULL, NULL);
+
+  watchdog = g_thread_new ("panel-watchdog", panel_watchdog_thread,
+                           GINT_TO_POINTER (threshold));
+}
+
+
+
+static void
+panel_watchdog_stop (void)
+{
+  if (watchdog == NULL)
+    return;
+
+  g_atomic_int_set (&watchdog_quit, 1);
+  g_thread_join (watchdog);
+  watchdog = NULL;
+}
+
+
+
 static void
 panel_dbus_name_lost (GDBusConnection *connection,
                       const gchar     *name,
@@ -280,7 +392,14 @@ main (gint argc, gchar **argv)
     }
   g_option_context_free (context);
 
+  /* start the profiler before gtk_init, so it is in the timeline; with
+   * PANEL_DEBUG=startup it already runs since the first debug message */
+  if (opt_profile_startup)
+    panel_debug_startup_enable ();
+
+  panel_debug_trace_begin (PANEL_DEBUG_MAIN, "gtk-init", -1);
   gtk_init (&argc, &argv);
+  panel_debug_trace_end (PANEL_DEBUG_MAIN, "gtk-init", -1);
 
   if (opt_version)
     {
@@ -382,8 +501,17 @@ main (gint argc, gchar **argv)
   /* set EWMH source indication */
   wnck_set_client_type (WNCK_CLIENT_TYPE_PAGER);
 
+  /* log callbacks that block the panel, PANEL_DEBUG=watchdog uses
+   * the default threshold */
+  if (opt_watchdog > 0)
+    panel_watchdog_start (opt_watchdog);
+  else if (panel_debug_has_domain (PANEL_DEBUG_WATCHDOG))
+    panel_watchdog_start (WATCHDOG_THRESHOLD);
+
   gtk_main ();
 
+  panel_watchdog_stop ();
+
   /* make sure there are no incomming events when we close */
   g_object_unref (G_OBJECT (dbus_service));
 
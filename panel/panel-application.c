@@ -53,8 +53,12 @@
 #include <panel/panel-dialogs.h>
 #include <panel/panel-plugin-external.h>
 
-#define AUTOSAVE_INTERVAL (10 * 60)
-#define MIGRATE_BIN       HELPERDIR G_DIR_SEPARATOR_S "migrate"
+#define AUTOSAVE_INTERVAL       (10 * 60)
+#define MIGRATE_BIN             HELPERDIR G_DIR_SEPARATOR_S "migrate"
+
+/* longest wait in seconds for the panels to show up before the
+ * startup summary is printed */
+#define STARTUP_PROFILE_TIMEOUT (30)
 
 
 
@@ -131,6 +135,10 @@ struct _PanelApplication
   guint               wait_for_wm_timeout_id;
 #endif
 
+  /* startup profiler, waiting for the panels to show up */
+  guint               startup_profile_timeout_id;
+  gint64              startup_profile_deadline;
+
   /* drag and drop data */
   guint               drop_data_ready : 1;
   guint               drop_occurred : 1;
@@ -202,19 +210,25 @@ panel_application_init (PanelApplication *application)
   application->drop_desktop_files = FALSE;
   application->drop_data_ready = FALSE;
   application->drop_occurred = FALSE;
+  application->startup_profile_timeout_id = 0;
 
   /* get the xfconf channel (singleton) */
   application->xfconf = panel_properties_get_channel (G_OBJECT (application));
 
+  /* queue the writes of the panel, flushed on save and quit */
+  panel_properties_journal_enable ();
+
   /* check if we need to migrate configuration */
   configver = xfconf_channel_get_int (application->xfconf, "/configver", -1);
   if (G_UNLIKELY (configver < XFCE4_PANEL_CONFIG_VERSION))
     {
+      panel_debug_trace_begin (PANEL_DEBUG_APPLICATION, "migrate", -1);
       if (!g_spawn_command_line_sync (MIGRATE_BIN, NULL, NULL, NULL, &error))
         {
           xfce_dialog_show_error (NULL, error, _("Failed to launch the migration application"));
           g_error_free (error);
         }
+      panel_debug_trace_end (PANEL_DEBUG_APPLICATION, "migrate", -1);
     }
 
   /* check if we need to force all plugins to run external */
@@ -252,10 +266,16 @@ panel_application_finalize (GObject *object)
     g_source_remove (application->wait_for_wm_timeout_id);
 #endif
 
+  if (application->startup_profile_timeout_id != 0)
+    g_source_remove (application->startup_profile_timeout_id);
+
   /* destroy all panels */
   g_slist_foreach (application->windows, (GFunc) (void (*)(void)) gtk_widget_destroy, NULL);
   g_slist_free (application->windows);
 
+  /* write the pending configuration changes */
+  panel_properties_journal_flush ();
+
   g_object_unref (G_OBJECT (application->factory));
 
   /* this is a good reference if all the objects are released */
@@ -328,6 +348,43 @@ panel_application_xfconf_window_bindings (PanelApplication *application,
 
 
 
+static gboolean
+panel_application_startup_profile (gpointer user_data)
+{
+  PanelApplication *application = PANEL_APPLICATION (user_data);
+  GSList           *li;
+
+  /* wait until all panels are mapped and all external plugins are
+   * embedded, unless one of them does not show up at all */
+  if (g_get_monotonic_time () < application->startup_profile_deadline)
+    {
+      if (panel_debug_startup_pending () > 0)
+        return TRUE;
+
+      for (li = application->windows; li != NULL; li = li->next)
+        if (!gtk_widget_get_mapped (GTK_WIDGET (li->data)))
+          return TRUE;
+    }
+
+  panel_debug_startup_finish ();
+
+  application->startup_profile_timeout_id = 0;
+
+  return FALSE;
+}
+
+
+
+static gboolean
+panel_application_load_snapshot_end (gpointer user_data)
+{
+  panel_properties_snapshot_end ();
+
+  return FALSE;
+}
+
+
+
 static void
 panel_application_load_real (PanelApplication *application)
 {
@@ -343,6 +400,7 @@ panel_application_load_real (PanelApplication *application)
   gint          screen_num;
   GdkDisplay   *display;
   GValue        val = { 0, };
+  GValue        ids = { 0, };
   GPtrArray    *panels;
   gint          panel_id;
   gboolean      save_changed_ids = FALSE;
@@ -350,9 +408,15 @@ panel_application_load_real (PanelApplication *application)
   panel_return_if_fail (PANEL_IS_APPLICATION (application));
   panel_return_if_fail (XFCONF_IS_CHANNEL (application->xfconf));
 
+  panel_debug_trace_begin (PANEL_DEBUG_APPLICATION, "load-panels", -1);
+
   display = gdk_display_get_default ();
 
-  if (xfconf_channel_get_property (application->xfconf, "/panels", &val)
+  /* fetch the entire channel at once, instead of a round trip for
+   * each panel and plugin property below */
+  panel_properties_snapshot_begin (application->xfconf);
+
+  if (panel_properties_get_property (application->xfconf, "/panels", &val)
       && (G_VALUE_HOLDS_UINT (&val)
           || G_VALUE_HOLDS (&val, G_TYPE_PTR_ARRAY)))
     {
@@ -388,7 +452,7 @@ panel_application_load_real (PanelApplication *application)
 
           /* start the panel directly on the correct screen */
           g_snprintf (buf, sizeof (buf), "/panels/panel-%d/output-name", panel_id);
-          output_name = xfconf_channel_get_string (application->xfconf, buf, NULL);
+          output_name = panel_properties_get_string (application->xfconf, buf, NULL);
           if (output_name != NULL
               && strncmp (output_name, "screen-", 7) == 0
               && sscanf (output_name, "screen-%d", &screen_num) == 1)
@@ -403,10 +467,16 @@ panel_application_load_real (PanelApplication *application)
 
           /* walk all the plugins on the panel */
           g_snprintf (buf, sizeof (buf), "/panels/panel-%d/plugin-ids", panel_id);
-          array = xfconf_channel_get_arrayv (application->xfconf, buf);
-          if (array == NULL)
+          if (!panel_properties_get_property (application->xfconf, buf, &ids))
             continue;
 
+          if (!G_VALUE_HOLDS (&ids, G_TYPE_PTR_ARRAY)
+              || (array = g_value_get_boxed (&ids)) == NULL)
+            {
+              g_value_unset (&ids);
+              continue;
+            }
+
           for (j = 0; j < array->len; j++)
             {
               /* get the plugin id */
@@ -416,7 +486,7 @@ panel_application_load_real (PanelApplication *application)
 
               /* get the plugin name */
               g_snprintf (buf, sizeof (buf), "/plugins/plugin-%d", unique_id);
-              name = xfconf_channel_get_string (application->xfconf, buf, NULL);
+              name = panel_properties_get_string (application->xfconf, buf, NULL);
 
               /* append the plugin to the panel */
               if (unique_id < 1 || name == NULL
@@ -425,7 +495,7 @@ panel_application_load_real (PanelApplication *application)
                 {
                   /* plugin could not be loaded, remove it from the channel */
                   g_snprintf (buf, sizeof (buf), "/panels/plugin-%d", unique_id);
-                  if (xfconf_channel_has_property (application->xfconf, buf))
+                  if (panel_properties_has_property (application->xfconf, buf))
                     xfconf_channel_reset_property (application->xfconf, buf, TRUE);
 
                   /* show warnings */
@@ -439,7 +509,7 @@ panel_application_load_real (PanelApplication *application)
               g_free (name);
             }
 
-          xfconf_array_free (array);
+          g_value_unset (&ids);
         }
 
       /* free xfconf array or uint */
@@ -450,8 +520,23 @@ panel_application_load_real (PanelApplication *application)
   if (G_UNLIKELY (application->windows == NULL))
     panel_application_new_window (application, NULL, -1, TRUE);
 
+  /* internal plugins bind their properties when realized, so keep the
+   * snapshot around until the panels have been shown */
+  g_idle_add_full (G_PRIORITY_LOW, panel_application_load_snapshot_end, NULL, NULL);
+
   if (save_changed_ids)
     panel_application_save (application, SAVE_PLUGIN_IDS);
+
+  panel_debug_trace_end (PANEL_DEBUG_APPLICATION, "load-panels", -1);
+
+  /* print the startup summary once the panels are visible */
+  if (G_UNLIKELY (panel_debug_startup_enabled ()))
+    {
+      application->startup_profile_deadline =
+          g_get_monotonic_time () + STARTUP_PROFILE_TIMEOUT * G_USEC_PER_SEC;
+      application->startup_profile_timeout_id =
+          g_timeout_add (100, panel_application_startup_profile, application);
+    }
 }
 
 
@@ -491,6 +576,8 @@ panel_application_wait_for_window_manager_destroyed (gpointer data)
 
   application->wait_for_wm_timeout_id = 0;
 
+  panel_debug_trace_async_end (PANEL_DEBUG_APPLICATION, "wait-for-wm", -1);
+
   if (!wfwm->have_wm)
     {
       g_printerr (G_LOG_DOMAIN ": No window manager registered on screen 0. "
@@ -645,6 +732,7 @@ panel_application_plugin_provider_signal (XfcePanelPluginProvider       *provide
   PanelWindow *window;
   gint         unique_id;
   gchar       *name;
+  const gchar *saved_label = NULL;
 
   panel_return_if_fail (PANEL_IS_APPLICATION (application));
   panel_return_if_fail (XFCE_IS_PANEL_PLUGIN_PROVIDER (provider));
@@ -652,6 +740,11 @@ panel_application_plugin_provider_signal (XfcePanelPluginProvider       *provide
   window = PANEL_WINDOW (gtk_widget_get_toplevel (GTK_WIDGET (provider)));
   panel_return_if_fail (PANEL_IS_WINDOW (window));
 
+  panel_debug_watchdog_enter (panel_debug_watchdog_intern ("%s-%d provider-signal",
+                                                           xfce_panel_plugin_provider_get_name (provider),
+                                                           xfce_panel_plugin_provider_get_unique_id (provider)),
+                              saved_label);
+
   switch (provider_signal)
     {
     case PROVIDER_SIGNAL_MOVE_PLUGIN:
@@ -764,6 +857,8 @@ panel_application_plugin_provider_signal (XfcePanelPluginProvider       *provide
       g_critical ("Received unknown provider signal %d", provider_signal);
       break;
     }
+
+  panel_debug_watchdog_leave (saved_label);
 }
 
 
@@ -1217,6 +1312,7 @@ panel_application_load (PanelApplication  *application,
       g_strfreev (atom_names);
 
       /* setup timeout to check for a window manager */
+      panel_debug_trace_async_begin (PANEL_DEBUG_APPLICATION, "wait-for-wm", -1);
       application->wait_for_wm_timeout_id =
           gdk_threads_add_timeout_full (G_PRIORITY_DEFAULT_IDLE, 50, panel_application_wait_for_window_manager,
                                         wfwm, panel_application_wait_for_window_manager_destroyed);
@@ -1273,8 +1369,7 @@ panel_application_save (PanelApplication *application,
   if (panels != NULL)
     {
       /* store the panel ids */
-      if (!xfconf_channel_set_arrayv (channel, "/panels", panels))
-        g_warning ("Failed to store the number of panels");
+      panel_properties_journal_set_arrayv (channel, "/panels", panels);
       xfconf_array_free (panels);
     }
 }
@@ -1321,8 +1416,7 @@ panel_application_save_window (PanelApplication *application,
       if (G_UNLIKELY (children == NULL))
         {
           g_snprintf (buf, sizeof (buf), "/panels/panel-%d/plugin-ids", panel_id);
-          if (xfconf_channel_has_property (channel, buf))
-            xfconf_channel_reset_property (channel, buf, FALSE);
+          panel_properties_journal_reset (channel, buf, FALSE);
           return;
         }
 
@@ -1346,7 +1440,7 @@ panel_application_save_window (PanelApplication *application,
 
           /* make sure the plugin type-name is store in the plugin item */
           g_snprintf (buf, sizeof (buf), "/plugins/plugin-%d", plugin_id);
-          xfconf_channel_set_string (channel, buf, xfce_panel_plugin_provider_get_name (provider));
+          panel_properties_journal_set_string (channel, buf, xfce_panel_plugin_provider_get_name (provider));
         }
 
       /* ask the plugin to save */
@@ -1358,7 +1452,7 @@ panel_application_save_window (PanelApplication *application,
     {
       /* store the plugin ids for this panel */
       g_snprintf (buf, sizeof (buf), "/panels/panel-%d/plugin-ids", panel_id);
-      xfconf_channel_set_arrayv (channel, buf, array);
+      panel_properties_journal_set_arrayv (channel, buf, array);
       xfconf_array_free (array);
     }
 
@@ -41,6 +41,9 @@
                               ".xfce4-panel.background button { background: transparent; padding: 0; }"\
                               ".xfce4-panel.background.marching-ants { border: 1px dashed #ff0000; }"
 
+/* number of parsed css providers kept around before unused ones are dropped */
+#define CSS_PROVIDER_CACHE_SIZE (16)
+
 
 
 static void     panel_base_window_get_property                (GObject              *object,
@@ -65,7 +68,9 @@ static void     panel_base_window_active_timeout_destroyed    (gpointer
 static void     panel_base_window_set_background_color_css    (PanelBaseWindow      *window);
 static void     panel_base_window_set_background_image_css    (PanelBaseWindow      *window);
 static void     panel_base_window_set_background_css          (PanelBaseWindow      *window,
-                                                               gchar                *css_string);
+                                                               gchar                *css_string,
+                                                               gboolean              sets_background);
+static void     panel_base_window_unset_background_css        (PanelBaseWindow      *window);
 static void     panel_base_window_set_plugin_data             (PanelBaseWindow      *window,
                                                                GtkCallback           func);
 static void     panel_base_window_set_plugin_opacity          (GtkWidget            *widget,
@@ -99,8 +104,13 @@ struct _PanelBaseWindowPrivate
 {
   PanelBorders     borders;
 
-  /* background css style provider */
+  /* background css style provider, shared with other windows
+   * using the same css and owned by the provider cache */
   GtkCssProvider  *css_provider;
+  gchar           *css_string;
+
+  /* whether the provider overrides the theme background color */
+  guint            css_sets_background : 1;
 
   /* active window timeout id */
   guint            active_timeout_id;
@@ -112,6 +122,11 @@ G_DEFINE_TYPE_WITH_PRIVATE (PanelBaseWindow, panel_base_window, GTK_TYPE_WINDOW)
 
 
 
+/* parsed background css, keyed by the css string, shared by all windows */
+static GHashTable *css_provider_cache = NULL;
+
+
+
 static void
 panel_base_window_class_init (PanelBaseWindowClass *klass)
 {
@@ -206,7 +221,9 @@ panel_base_window_init (PanelBaseWindow *window)
   window->leave_opacity = 1.00;
   window->leave_opacity_old = 1.00;
 
-  window->priv->css_provider = gtk_css_provider_new ();
+  window->priv->css_provider = NULL;
+  window->priv->css_string = NULL;
+  window->priv->css_sets_background = FALSE;
   window->priv->borders = PANEL_BORDER_NONE;
   window->priv->active_timeout_id = 0;
 
@@ -428,7 +445,9 @@ panel_base_window_finalize (GObject *object)
   g_free (window->background_image);
   if (window->background_rgba != NULL)
     gdk_rgba_free (window->background_rgba);
-  g_object_unref (window->priv->css_provider);
+  if (window->priv->css_provider != NULL)
+    g_object_unref (window->priv->css_provider);
+  g_free (window->priv->css_string);
 
   (*G_OBJECT_CLASS (panel_base_window_parent_class)->finalize) (object);
 }
@@ -599,11 +618,13 @@ panel_base_window_active_timeout_destroyed (gpointer user_data)
 static void
 panel_base_window_set_background_color_css (PanelBaseWindow *window) {
   gchar                  *css_string;
+  gchar                  *color_text;
   panel_return_if_fail (window->background_rgba != NULL);
+  color_text = gdk_rgba_to_string (window->background_rgba);
   css_string = g_strdup_printf (".xfce4-panel.background { background-color: %s; border-color: transparent; } %s",
-                                gdk_rgba_to_string (window->background_rgba),
-                                PANEL_BASE_CSS);
-  panel_base_window_set_background_css (window, css_string);
+                                color_text, PANEL_BASE_CSS);
+  g_free (color_text);
+  panel_base_window_set_background_css (window, css_string, TRUE);
 }
 
 
@@ -616,23 +637,101 @@ panel_base_window_set_background_image_css (PanelBaseWindow *window) {
                                                           "background-image: url('%s');"
                                                           "border-color: transparent; } %s",
                                 window->background_image, PANEL_BASE_CSS);
-  panel_base_window_set_background_css (window, css_string);
+  panel_base_window_set_background_css (window, css_string, TRUE);
+}
+
+
+
+static gboolean
+panel_base_window_css_provider_unused (gpointer key,
+                                       gpointer value,
+                                       gpointer user_data)
+{
+  /* only referenced by the cache itself */
+  return G_OBJECT (value)->ref_count == 1;
+}
+
+
+
+static GtkCssProvider *
+panel_base_window_css_provider_lookup (const gchar *css_string)
+{
+  GtkCssProvider *provider;
+
+  if (G_UNLIKELY (css_provider_cache == NULL))
+    css_provider_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                g_free, g_object_unref);
+
+  provider = g_hash_table_lookup (css_provider_cache, css_string);
+  if (provider == NULL)
+    {
+      /* drop providers no longer used by any window, so picking colors
+       * in the preferences dialog does not grow the cache forever */
+      if (g_hash_table_size (css_provider_cache) >= CSS_PROVIDER_CACHE_SIZE)
+        g_hash_table_foreach_remove (css_provider_cache,
+                                     panel_base_window_css_provider_unused, NULL);
+
+      provider = gtk_css_provider_new ();
+      gtk_css_provider_load_from_data (provider, css_string, -1, NULL);
+      g_hash_table_insert (css_provider_cache, g_strdup (css_string), provider);
+
+      panel_debug (PANEL_DEBUG_BASE_WINDOW,
+                   "parsed new background css (%u cached)",
+                   g_hash_table_size (css_provider_cache));
+    }
+
+  return g_object_ref (provider);
 }
 
 
 
 static void
-panel_base_window_set_background_css (PanelBaseWindow *window, gchar *css_string) {
+panel_base_window_unset_background_css (PanelBaseWindow *window)
+{
+  PanelBaseWindowPrivate *priv = window->priv;
   GtkStyleContext        *context;
 
+  if (priv->css_provider == NULL)
+    return;
+
   context = gtk_widget_get_style_context (GTK_WIDGET (window));
+  gtk_style_context_remove_provider (context, GTK_STYLE_PROVIDER (priv->css_provider));
+  g_object_unref (priv->css_provider);
+  priv->css_provider = NULL;
+
+  g_free (priv->css_string);
+  priv->css_string = NULL;
+  priv->css_sets_background = FALSE;
+}
+
+
+
+static void
+panel_base_window_set_background_css (PanelBaseWindow *window,
+                                      gchar           *css_string,
+                                      gboolean         sets_background) {
+  PanelBaseWindowPrivate *priv = window->priv;
+  GtkStyleContext        *context;
+
+  /* nothing changed, avoid invalidating the style of the panel and all its plugins */
+  if (priv->css_provider != NULL
+      && g_strcmp0 (priv->css_string, css_string) == 0)
+    {
+      g_free (css_string);
+      return;
+    }
+
   /* Reset the css style provider */
-  gtk_style_context_remove_provider (context, GTK_STYLE_PROVIDER (window->priv->css_provider));
-  gtk_css_provider_load_from_data (window->priv->css_provider, css_string, -1, NULL);
+  panel_base_window_unset_background_css (window);
+
+  priv->css_provider = panel_base_window_css_provider_lookup (css_string);
+  priv->css_string = css_string;
+  priv->css_sets_background = sets_background;
+
+  context = gtk_widget_get_style_context (GTK_WIDGET (window));
   gtk_style_context_add_provider (context,
-                                  GTK_STYLE_PROVIDER (window->priv->css_provider),
+                                  GTK_STYLE_PROVIDER (priv->css_provider),
                                   GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
-  g_free (css_string);
 }
 
 
@@ -646,10 +745,13 @@ panel_base_window_reset_background_css (PanelBaseWindow *window) {
   gchar                   *base_css;
   gchar                   *color_text;
 
-  context = gtk_widget_get_style_context (GTK_WIDGET (window));
-  gtk_style_context_remove_provider (context,
-                                     GTK_STYLE_PROVIDER (window->priv->css_provider));
+  /* Only drop the provider if it overrides the theme's background color,
+   * otherwise an unchanged css does not need a style invalidation */
+  if (priv->css_sets_background)
+    panel_base_window_unset_background_css (window);
+
   /* Get the background color of the panel to draw the border */
+  context = gtk_widget_get_style_context (GTK_WIDGET (window));
   gtk_style_context_get (context, GTK_STATE_FLAG_NORMAL,
                          GTK_STYLE_PROPERTY_BACKGROUND_COLOR,
                          &background_rgba, NULL);
@@ -669,17 +771,13 @@ panel_base_window_reset_background_css (PanelBaseWindow *window) {
       color_text = gdk_rgba_to_string (background_rgba);
       base_css = g_strdup_printf ("%s .xfce4-panel.background { border-style: %s; border-width: 1px; border-color: shade(%s, 0.7); }",
                                   PANEL_BASE_CSS, border_side, color_text);
-      gtk_css_provider_load_from_data (window->priv->css_provider, base_css, -1, NULL);
-      g_free (base_css);
       g_free (color_text);
       g_free (border_side);
     }
   else
-    gtk_css_provider_load_from_data (window->priv->css_provider, PANEL_BASE_CSS, -1, NULL);
+    base_css = g_strdup (PANEL_BASE_CSS);
 
-  gtk_style_context_add_provider (context,
-                                  GTK_STYLE_PROVIDER (window->priv->css_provider),
-                                  GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+  panel_base_window_set_background_css (window, base_css, FALSE);
   gdk_rgba_free (background_rgba);
 }
 
@@ -28,6 +28,8 @@
 #include <gio/gio.h>
 #include <common/panel-private.h>
 #include <common/panel-dbus.h>
+#include <common/panel-debug.h>
+#include <common/panel-xfconf.h>
 #include <libxfce4util/libxfce4util.h>
 #include <libxfce4ui/libxfce4ui.h>
 #include <libxfce4panel/libxfce4panel.h>
@@ -37,6 +39,7 @@
 #include <panel/panel-preferences-dialog.h>
 #include <panel/panel-item-dialog.h>
 #include <panel/panel-module-factory.h>
+#include <panel/panel-plugin-external-wrapper.h>
 
 #include <panel/panel-gdbus-exported-service.h>
 
@@ -70,6 +73,19 @@ static gboolean  panel_dbus_service_plugin_event               (XfcePanelExporte
                                                                 const gchar              *name,
                                                                 GVariant                 *variant,
                                                                 PanelDBusService         *service);
+static gboolean  panel_dbus_service_plugin_events              (XfcePanelExportedService *skeleton,
+                                                                GDBusMethodInvocation    *invocation,
+                                                                GVariant                 *events,
+                                                                PanelDBusService         *service);
+static gboolean  panel_dbus_service_dump_trace                 (XfcePanelExportedService *skeleton,
+                                                                GDBusMethodInvocation    *invocation,
+                                                                PanelDBusService         *service);
+static gboolean  panel_dbus_service_get_plugin_metrics         (XfcePanelExportedService *skeleton,
+                                                                GDBusMethodInvocation    *invocation,
+                                                                PanelDBusService         *service);
+static gboolean  panel_dbus_service_get_stalls                 (XfcePanelExportedService *skeleton,
+                                                                GDBusMethodInvocation    *invocation,
+                                                                PanelDBusService         *service);
 static gboolean  panel_dbus_service_terminate                  (XfcePanelExportedService *skeleton,
                                                                 GDBusMethodInvocation    *invocation,
                                                                 gboolean                  restart,
@@ -162,10 +178,18 @@ panel_dbus_service_init (PanelDBusService *service)
                             G_CALLBACK(panel_dbus_service_display_preferences_dialog), service);
           g_signal_connect (service, "handle_plugin_event",
                             G_CALLBACK(panel_dbus_service_plugin_event), service);
+          g_signal_connect (service, "handle_plugin_events",
+                            G_CALLBACK(panel_dbus_service_plugin_events), service);
           g_signal_connect (service, "handle_save",
                             G_CALLBACK(panel_dbus_service_save), service);
           g_signal_connect (service, "handle_terminate",
                             G_CALLBACK(panel_dbus_service_terminate), service);
+          g_signal_connect (service, "handle_dump_trace",
+                            G_CALLBACK(panel_dbus_service_dump_trace), service);
+          g_signal_connect (service, "handle_get_plugin_metrics",
+                            G_CALLBACK(panel_dbus_service_get_plugin_metrics), service);
+          g_signal_connect (service, "handle_get_stalls",
+                            G_CALLBACK(panel_dbus_service_get_stalls), service);
         }
     }
   else
@@ -244,6 +268,9 @@ panel_dbus_service_save (XfcePanelExportedService *skeleton,
   panel_application_save (application, SAVE_EVERYTHING);
   g_object_unref (G_OBJECT (application));
 
+  /* the caller expects the configuration to be stored */
+  panel_properties_journal_flush ();
+
   xfce_panel_exported_service_complete_save (skeleton,
                                              invocation);
 
@@ -284,12 +311,10 @@ panel_dbus_service_add_new_item (XfcePanelExportedService *skeleton,
 
 
 static gboolean
-panel_dbus_service_plugin_event (XfcePanelExportedService *skeleton,
-                                 GDBusMethodInvocation    *invocation,
-                                 const gchar              *plugin_name,
-                                 const gchar              *name,
-                                 GVariant                 *variant,
-                                 PanelDBusService         *service)
+panel_dbus_service_plugin_event_dispatch (PanelDBusService *service,
+                                          const gchar      *plugin_name,
+                                          const gchar      *name,
+                                          GVariant         *variant)
 {
   GSList             *plugins, *li, *lnext;
   PanelModuleFactory *factory;
@@ -298,10 +323,7 @@ panel_dbus_service_plugin_event (XfcePanelExportedService *skeleton,
   gboolean            result;
   GValue              value = { 0, };
   gboolean            plugin_replied = FALSE;
-
-  panel_return_val_if_fail (PANEL_IS_DBUS_SERVICE (service), FALSE);
-  panel_return_val_if_fail (plugin_name != NULL, FALSE);
-  panel_return_val_if_fail (name != NULL, FALSE);
+  const gchar        *saved_label = NULL;
 
   /* send the event to all matching plugins, break if one of the
    * plugins returns TRUE in this remote-event handler */
@@ -317,7 +339,12 @@ panel_dbus_service_plugin_event (XfcePanelExportedService *skeleton,
 
       panel_return_val_if_fail (XFCE_IS_PANEL_PLUGIN_PROVIDER (li->data), FALSE);
 
+      panel_debug_watchdog_enter (panel_debug_watchdog_intern ("%s-%d remote-event",
+                                                               xfce_panel_plugin_provider_get_name (li->data),
+                                                               xfce_panel_plugin_provider_get_unique_id (li->data)),
+                                  saved_label);
       result = xfce_panel_plugin_provider_remote_event (li->data, name, &value, &handle);
+      panel_debug_watchdog_leave (saved_label);
 
       if (handle > 0 && lnext != NULL)
         {
@@ -354,13 +381,159 @@ panel_dbus_service_plugin_event (XfcePanelExportedService *skeleton,
         }
     }
 
+  if (G_IS_VALUE (&value))
+    g_value_unset (&value);
+  g_variant_unref (variant);
   g_slist_free (plugins);
   g_object_unref (G_OBJECT (factory));
 
+  return plugin_replied;
+}
+
+
+
+static gboolean
+panel_dbus_service_plugin_event (XfcePanelExportedService *skeleton,
+                                 GDBusMethodInvocation    *invocation,
+                                 const gchar              *plugin_name,
+                                 const gchar              *name,
+                                 GVariant                 *variant,
+                                 PanelDBusService         *service)
+{
+  gboolean plugin_replied;
+
+  panel_return_val_if_fail (PANEL_IS_DBUS_SERVICE (service), FALSE);
+  panel_return_val_if_fail (plugin_name != NULL, FALSE);
+  panel_return_val_if_fail (name != NULL, FALSE);
+
+  panel_debug_trace_begin (PANEL_DEBUG_APPLICATION, "dbus-plugin-event", -1);
+
+  plugin_replied = panel_dbus_service_plugin_event_dispatch (service, plugin_name,
+                                                             name, variant);
+
   xfce_panel_exported_service_complete_plugin_event (skeleton, invocation, plugin_replied);
 
+  panel_debug_trace_end (PANEL_DEBUG_APPLICATION, "dbus-plugin-event", -1);
+
+  return TRUE;
+
+}
+
+
+
+static gboolean
+panel_dbus_service_plugin_events (XfcePanelExportedService *skeleton,
+                                  GDBusMethodInvocation    *invocation,
+                                  GVariant                 *events,
+                                  PanelDBusService         *service)
+{
+  GVariantIter     iter;
+  GVariantBuilder  succeed;
+  const gchar     *plugin_name;
+  const gchar     *name;
+  GVariant        *variant;
+  gboolean         plugin_replied;
+
+  panel_return_val_if_fail (PANEL_IS_DBUS_SERVICE (service), FALSE);
+
+  panel_debug_trace_begin (PANEL_DEBUG_APPLICATION, "dbus-plugin-events", -1);
+
+  g_variant_builder_init (&succeed, G_VARIANT_TYPE ("ab"));
+
+  /* dispatch all events in one pass, the events for external plugins
+   * are queued and sent to each wrapper in one signal */
+  panel_plugin_external_wrapper_remote_events_begin ();
+
+  g_variant_iter_init (&iter, events);
+  while (g_variant_iter_next (&iter, "(&s&s@v)", &plugin_name, &name, &variant))
+    {
+      plugin_replied = panel_dbus_service_plugin_event_dispatch (service, plugin_name,
+                                                                 name, variant);
+      g_variant_builder_add (&succeed, "b", plugin_replied);
+      g_variant_unref (variant);
+    }
+
+  panel_plugin_external_wrapper_remote_events_end ();
+
+  xfce_panel_exported_service_complete_plugin_events (skeleton, invocation,
+                                                      g_variant_builder_end (&succeed));
+
+  panel_debug_trace_end (PANEL_DEBUG_APPLICATION, "dbus-plugin-events", -1);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+panel_dbus_service_dump_trace (XfcePanelExportedService *skeleton,
+                               GDBusMethodInvocation    *invocation,
+                               PanelDBusService         *service)
+{
+  gchar *trace;
+
+  panel_return_val_if_fail (PANEL_IS_DBUS_SERVICE (service), FALSE);
+
+  trace = panel_debug_trace_to_json ();
+  if (trace == NULL)
+    {
+      g_dbus_method_invocation_return_error (invocation, G_DBUS_ERROR,
+                                             G_DBUS_ERROR_NOT_SUPPORTED,
+                                             "Tracing is disabled, start the panel "
+                                             "with PANEL_DEBUG=trace");
+      return TRUE;
+    }
+
+  xfce_panel_exported_service_complete_dump_trace (skeleton, invocation, trace);
+  g_free (trace);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+panel_dbus_service_get_plugin_metrics (XfcePanelExportedService *skeleton,
+                                       GDBusMethodInvocation    *invocation,
+                                       PanelDBusService         *service)
+{
+  PanelModuleFactory *factory;
+
+  panel_return_val_if_fail (PANEL_IS_DBUS_SERVICE (service), FALSE);
+
+  factory = panel_module_factory_get ();
+  xfce_panel_exported_service_complete_get_plugin_metrics (skeleton, invocation,
+                                                           panel_module_factory_get_metrics (factory));
+  g_object_unref (G_OBJECT (factory));
+
   return TRUE;
+}
 
+
+
+static gboolean
+panel_dbus_service_get_stalls (XfcePanelExportedService *skeleton,
+                               GDBusMethodInvocation    *invocation,
+                               PanelDBusService         *service)
+{
+  GVariant *histogram;
+  GVariant *stalls;
+
+  panel_return_val_if_fail (PANEL_IS_DBUS_SERVICE (service), FALSE);
+
+  if (!panel_debug_watchdog_enabled ())
+    {
+      g_dbus_method_invocation_return_error (invocation, G_DBUS_ERROR,
+                                             G_DBUS_ERROR_NOT_SUPPORTED,
+                                             "The watchdog is disabled, start the panel "
+                                             "with --watchdog or PANEL_DEBUG=watchdog");
+      return TRUE;
+    }
+
+  panel_debug_watchdog_get_stalls (&histogram, &stalls);
+  xfce_panel_exported_service_complete_get_stalls (skeleton, invocation, histogram, stalls);
+
+  return TRUE;
 }
 
 
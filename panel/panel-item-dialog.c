@@ -82,11 +82,14 @@ static void         panel_item_dialog_drag_data_received     (GtkWidget
                                                               guint               info,
                                                               guint               drag_time,
                                                               PanelItemDialog    *dialog);
+static void         panel_item_dialog_search_free            (gpointer            data);
 static void         panel_item_dialog_populate_store         (PanelItemDialog    *dialog);
 static gint         panel_item_dialog_compare_func           (GtkTreeModel       *model,
                                                               GtkTreeIter        *a,
                                                               GtkTreeIter        *b,
                                                               gpointer            user_data);
+static void         panel_item_dialog_search_changed         (GtkEntry           *entry,
+                                                              PanelItemDialog    *dialog);
 static gboolean     panel_item_dialog_visible_func           (GtkTreeModel       *model,
                                                               GtkTreeIter        *iter,
                                                               gpointer            user_data);
@@ -115,15 +118,31 @@ struct _PanelItemDialog
 
   /* pointers to list */
   GtkListStore       *store;
+  GtkTreeModel       *filter;
   GtkTreeView        *treeview;
   GtkWidget          *add_button;
+
+  /* casefolded strings of the modules, so refiltering
+   * does not need to normalize anything per row */
+  GPtrArray          *search_index;
+
+  /* casefolded text in the search entry, %NULL if empty */
+  gchar              *search_text;
 };
 
+typedef struct
+{
+  gchar *name;
+  gchar *comment;
+}
+PanelItemDialogSearch;
+
 enum
 {
   COLUMN_ICON_NAME,
   COLUMN_MODULE,
   COLUMN_SENSITIVE,
+  COLUMN_SEARCH,
   N_COLUMNS
 };
 
@@ -188,6 +207,9 @@ panel_item_dialog_init (PanelItemDialog *dialog)
 
   dialog->factory = panel_module_factory_get ();
 
+  dialog->search_index = g_ptr_array_new_with_free_func (panel_item_dialog_search_free);
+  dialog->search_text = NULL;
+
   /* monitor unique changes */
   g_signal_connect (G_OBJECT (dialog->factory), "unique-changed",
       G_CALLBACK (panel_item_dialog_unique_changed), dialog);
@@ -248,14 +270,15 @@ panel_item_dialog_init (PanelItemDialog *dialog)
   gtk_widget_show (scroll);
 
   /* create the store and automatically sort it */
-  dialog->store = gtk_list_store_new (N_COLUMNS, G_TYPE_STRING, G_TYPE_OBJECT, G_TYPE_BOOLEAN);
+  dialog->store = gtk_list_store_new (N_COLUMNS, G_TYPE_STRING, G_TYPE_OBJECT, G_TYPE_BOOLEAN, G_TYPE_POINTER);
   gtk_tree_sortable_set_sort_func (GTK_TREE_SORTABLE (dialog->store), COLUMN_MODULE, panel_item_dialog_compare_func, NULL, NULL);
   gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (dialog->store), COLUMN_MODULE, GTK_SORT_ASCENDING);
 
   /* create treemodel with filter */
   filter = gtk_tree_model_filter_new (GTK_TREE_MODEL (dialog->store), NULL);
-  gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER (filter), panel_item_dialog_visible_func, entry, NULL);
-  g_signal_connect_swapped (G_OBJECT (entry), "changed", G_CALLBACK (gtk_tree_model_filter_refilter), filter);
+  dialog->filter = filter;
+  gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER (filter), panel_item_dialog_visible_func, dialog, NULL);
+  g_signal_connect (G_OBJECT (entry), "changed", G_CALLBACK (panel_item_dialog_search_changed), dialog);
 
   /* treeview */
   treeview = gtk_tree_view_new_with_model (filter);
@@ -317,6 +340,8 @@ panel_item_dialog_finalize (GObject *object)
 
   g_object_unref (G_OBJECT (dialog->store));
   g_object_unref (G_OBJECT (dialog->factory));
+  g_ptr_array_free (dialog->search_index, TRUE);
+  g_free (dialog->search_text);
   g_object_unref (G_OBJECT (dialog->application));
 
   (*G_OBJECT_CLASS (panel_item_dialog_parent_class)->finalize) (object);
@@ -607,13 +632,44 @@ panel_item_dialog_drag_data_received (GtkWidget        *treeview,
 
 
 
+static gchar *
+panel_item_dialog_casefold (const gchar *text)
+{
+  gchar *normalized;
+  gchar *casefolded;
+
+  if (text == NULL)
+    return NULL;
+
+  normalized = g_utf8_normalize (text, -1, G_NORMALIZE_ALL);
+  casefolded = g_utf8_casefold (normalized, -1);
+  g_free (normalized);
+
+  return casefolded;
+}
+
+
+
+static void
+panel_item_dialog_search_free (gpointer data)
+{
+  PanelItemDialogSearch *search = data;
+
+  g_free (search->name);
+  g_free (search->comment);
+  g_slice_free (PanelItemDialogSearch, search);
+}
+
+
+
 static void
 panel_item_dialog_populate_store (PanelItemDialog *dialog)
 {
-  GList       *modules, *li;
-  gint         n;
-  GtkTreeIter  iter;
-  PanelModule *module;
+  GList                 *modules, *li;
+  gint                   n;
+  GtkTreeIter            iter;
+  PanelModule           *module;
+  PanelItemDialogSearch *search;
 
   panel_return_if_fail (PANEL_IS_ITEM_DIALOG (dialog));
   panel_return_if_fail (PANEL_IS_MODULE_FACTORY (dialog->factory));
@@ -625,8 +681,15 @@ panel_item_dialog_populate_store (PanelItemDialog *dialog)
     {
       module = PANEL_MODULE (li->data);
 
+      /* casefold the strings we search in once */
+      search = g_slice_new (PanelItemDialogSearch);
+      search->name = panel_item_dialog_casefold (panel_module_get_display_name (module));
+      search->comment = panel_item_dialog_casefold (panel_module_get_comment (module));
+      g_ptr_array_add (dialog->search_index, search);
+
       gtk_list_store_insert_with_values (dialog->store, &iter, n,
           COLUMN_MODULE, module,
+          COLUMN_SEARCH, search,
           COLUMN_ICON_NAME, panel_module_get_icon_name (module),
           COLUMN_SENSITIVE, panel_module_is_usable (module,
               gtk_widget_get_screen (GTK_WIDGET (dialog))), -1);
@@ -712,72 +775,54 @@ panel_item_dialog_compare_func (GtkTreeModel *model,
 
 
 
-static gboolean
-panel_item_dialog_visible_func (GtkTreeModel *model,
-                                GtkTreeIter  *iter,
-                                gpointer      user_data)
+static void
+panel_item_dialog_search_changed (GtkEntry        *entry,
+                                  PanelItemDialog *dialog)
 {
+  const gchar *text;
 
-  GtkEntry    *entry = GTK_ENTRY (user_data);
-  const gchar *text, *name, *comment;
-  PanelModule *module;
-  gchar       *normalized;
-  gchar       *text_casefolded;
-  gchar       *name_casefolded;
-  gchar       *comment_casefolded;
-  gboolean     visible = FALSE;
+  panel_return_if_fail (GTK_IS_ENTRY (entry));
+  panel_return_if_fail (PANEL_IS_ITEM_DIALOG (dialog));
 
-  /* search string from dialog */
+  /* casefold the search text once for all rows */
+  g_free (dialog->search_text);
   text = gtk_entry_get_text (entry);
   if (G_UNLIKELY (panel_str_is_empty (text)))
-    return TRUE;
-
-  gtk_tree_model_get (model, iter, COLUMN_MODULE, &module, -1);
-
-  /* hide separator when searching */
-  if (G_UNLIKELY (module == NULL))
-    return FALSE;
+    dialog->search_text = NULL;
+  else
+    dialog->search_text = panel_item_dialog_casefold (text);
 
-  /* casefold the search text */
-  normalized = g_utf8_normalize (text, -1, G_NORMALIZE_ALL);
-  text_casefolded = g_utf8_casefold (normalized, -1);
-  g_free (normalized);
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (dialog->filter));
+}
 
-  name = panel_module_get_display_name (module);
-  if (G_LIKELY (name != NULL))
-    {
-      /* casefold the name */
-      normalized = g_utf8_normalize (name, -1, G_NORMALIZE_ALL);
-      name_casefolded = g_utf8_casefold (normalized, -1);
-      g_free (normalized);
 
-      /* search */
-      visible = (strstr (name_casefolded, text_casefolded) != NULL);
 
-      g_free (name_casefolded);
-    }
+static gboolean
+panel_item_dialog_visible_func (GtkTreeModel *model,
+                                GtkTreeIter  *iter,
+                                gpointer      user_data)
+{
+  PanelItemDialog       *dialog = PANEL_ITEM_DIALOG (user_data);
+  PanelItemDialogSearch *search;
 
-  if (!visible)
-    {
-      comment = panel_module_get_comment (module);
-      if (comment != NULL)
-        {
-          /* casefold the comment */
-          normalized = g_utf8_normalize (comment, -1, G_NORMALIZE_ALL);
-          comment_casefolded = g_utf8_casefold (normalized, -1);
-          g_free (normalized);
+  /* search string from dialog */
+  if (G_UNLIKELY (dialog->search_text == NULL))
+    return TRUE;
 
-          /* search */
-          visible = (strstr (comment_casefolded, text_casefolded) != NULL);
+  /* the pointer column is not copied, so this does not allocate */
+  gtk_tree_model_get (model, iter, COLUMN_SEARCH, &search, -1);
 
-          g_free (comment_casefolded);
-        }
-    }
+  /* hide separator when searching */
+  if (G_UNLIKELY (search == NULL))
+    return FALSE;
 
-  g_free (text_casefolded);
-  g_object_unref (G_OBJECT (module));
+  /* search */
+  if (search->name != NULL
+      && strstr (search->name, dialog->search_text) != NULL)
+    return TRUE;
 
-  return visible;
+  return search->comment != NULL
+         && strstr (search->comment, dialog->search_text) != NULL;
 }
 
 
@@ -25,7 +25,9 @@
 #include <gtk/gtk.h>
 
 #include <common/panel-private.h>
+#include <common/panel-debug.h>
 #include <libxfce4panel/libxfce4panel.h>
+#include <libxfce4panel/xfce-panel-plugin-provider.h>
 
 #include <panel/panel-itembar.h>
 
@@ -60,6 +62,7 @@ static void               panel_itembar_size_allocate        (GtkWidget       *w
                                                               GtkAllocation   *allocation);
 static gboolean           panel_itembar_draw                 (GtkWidget *widget,
                                                               cairo_t   *cr);
+static void               panel_itembar_map                  (GtkWidget       *widget);
 static void               panel_itembar_add                  (GtkContainer    *container,
                                                               GtkWidget       *child);
 static void               panel_itembar_remove               (GtkContainer    *container,
@@ -81,6 +84,9 @@ static void               panel_itembar_get_child_property   (GtkContainer    *c
                                                               GParamSpec      *pspec);
 static PanelItembarChild *panel_itembar_get_child            (PanelItembar    *itembar,
                                                               GtkWidget       *widget);
+static const gchar       *panel_itembar_construct_begin      (GtkWidget       *widget);
+static void               panel_itembar_construct_end        (GtkWidget       *widget,
+                                                              const gchar     *saved_label);
 
 
 
@@ -173,6 +179,7 @@ panel_itembar_class_init (PanelItembarClass *klass)
   gtkwidget_class->get_preferred_height = panel_itembar_get_preferred_height;
   gtkwidget_class->size_allocate = panel_itembar_size_allocate;
   gtkwidget_class->draw = panel_itembar_draw;
+  gtkwidget_class->map = panel_itembar_map;
 
   gtkcontainer_class = GTK_CONTAINER_CLASS (klass);
   gtkcontainer_class->add = panel_itembar_add;
@@ -492,6 +499,8 @@ panel_itembar_size_allocate (GtkWidget     *widget,
     if (G_UNLIKELY ((child_len) < 1)) \
       (child_len) = 1;
 
+  panel_debug_trace_begin (PANEL_DEBUG_POSITIONING, "itembar-size-allocate", -1);
+
   /* the maximum allocation is limited by that of the
    * panel window, so take over the assigned allocation */
   gtk_widget_set_allocation (widget, allocation);
@@ -771,6 +780,8 @@ panel_itembar_size_allocate (GtkWidget     *widget,
 
       gtk_widget_size_allocate (child->widget, &child_alloc);
     }
+
+  panel_debug_trace_end (PANEL_DEBUG_POSITIONING, "itembar-size-allocate", -1);
 }
 
 
@@ -819,6 +830,35 @@ panel_itembar_draw (GtkWidget *widget,
 
 
 
+static void
+panel_itembar_map (GtkWidget *widget)
+{
+  PanelItembar      *itembar = PANEL_ITEMBAR (widget);
+  PanelItembarChild *child;
+  GSList            *li;
+  const gchar       *saved_label;
+
+  /* realize the plugins added before the itembar was realized here, and
+   * not in the container map, so their construct is measured */
+  for (li = itembar->children; li != NULL; li = g_slist_next (li))
+    {
+      child = li->data;
+      if (child == NULL
+          || !XFCE_IS_PANEL_PLUGIN (child->widget)
+          || !gtk_widget_get_visible (child->widget)
+          || gtk_widget_get_realized (child->widget))
+        continue;
+
+      saved_label = panel_itembar_construct_begin (child->widget);
+      gtk_widget_realize (child->widget);
+      panel_itembar_construct_end (child->widget, saved_label);
+    }
+
+  (*GTK_WIDGET_CLASS (panel_itembar_parent_class)->map) (widget);
+}
+
+
+
 static void
 panel_itembar_add (GtkContainer *container,
                    GtkWidget    *child)
@@ -1000,6 +1040,39 @@ panel_itembar_get_child (PanelItembar *itembar,
 
 
 
+static const gchar *
+panel_itembar_construct_begin (GtkWidget *widget)
+{
+  XfcePanelPluginProvider *provider = XFCE_PANEL_PLUGIN_PROVIDER (widget);
+  const gchar             *saved_label = NULL;
+  gint                     unique_id;
+
+  /* object plugins run their construct function on the first realize */
+  unique_id = xfce_panel_plugin_provider_get_unique_id (provider);
+  panel_debug_trace_begin (PANEL_DEBUG_MODULE, "plugin-construct", unique_id);
+  panel_debug_trace_set_label ("plugin-construct", unique_id,
+                               xfce_panel_plugin_provider_get_name (provider));
+  panel_debug_watchdog_enter (panel_debug_watchdog_intern ("%s-%d construct",
+                                                           xfce_panel_plugin_provider_get_name (provider),
+                                                           unique_id),
+                              saved_label);
+
+  return saved_label;
+}
+
+
+
+static void
+panel_itembar_construct_end (GtkWidget   *widget,
+                             const gchar *saved_label)
+{
+  panel_debug_watchdog_leave (saved_label);
+  panel_debug_trace_end (PANEL_DEBUG_MODULE, "plugin-construct",
+                         xfce_panel_plugin_provider_get_unique_id (XFCE_PANEL_PLUGIN_PROVIDER (widget)));
+}
+
+
+
 GtkWidget *
 panel_itembar_new (void)
 {
@@ -1014,6 +1087,7 @@ panel_itembar_insert (PanelItembar *itembar,
                       gint          position)
 {
   PanelItembarChild *child;
+  const gchar       *saved_label;
 
   panel_return_if_fail (PANEL_IS_ITEMBAR (itembar));
   panel_return_if_fail (GTK_IS_WIDGET (widget));
@@ -1024,7 +1098,17 @@ panel_itembar_insert (PanelItembar *itembar,
   child->option = CHILD_OPTION_NONE;
 
   itembar->children = g_slist_insert (itembar->children, child, position);
-  gtk_widget_set_parent (widget, GTK_WIDGET (itembar));
+
+  /* the plugin is realized in set_parent if the itembar is realized */
+  if (XFCE_IS_PANEL_PLUGIN (widget)
+      && gtk_widget_get_realized (GTK_WIDGET (itembar)))
+    {
+      saved_label = panel_itembar_construct_begin (widget);
+      gtk_widget_set_parent (widget, GTK_WIDGET (itembar));
+      panel_itembar_construct_end (widget, saved_label);
+    }
+  else
+    gtk_widget_set_parent (widget, GTK_WIDGET (itembar));
 
   gtk_widget_queue_resize (GTK_WIDGET (itembar));
   g_signal_emit (G_OBJECT (itembar), itembar_signals[CHANGED], 0);
@@ -37,6 +37,7 @@
 
 #include <panel/panel-module.h>
 #include <panel/panel-module-factory.h>
+#include <panel/panel-plugin-external.h>
 
 #define PANEL_PLUGINS_DATA_DIR     (DATADIR G_DIR_SEPARATOR_S "panel" G_DIR_SEPARATOR_S "plugins")
 #define PANEL_PLUGINS_DATA_DIR_OLD (DATADIR G_DIR_SEPARATOR_S "panel-plugins")
@@ -51,6 +52,17 @@ static gboolean panel_module_factory_modules_cleanup (gpointer
                                                       gpointer                  user_data);
 static void     panel_module_factory_remove_plugin   (gpointer                  user_data,
                                                       GObject                  *where_the_object_was);
+static gboolean panel_module_factory_draw            (GtkWidget                *widget,
+                                                      cairo_t                  *cr,
+                                                      gpointer                  user_data);
+static gboolean panel_module_factory_draw_after      (GtkWidget                *widget,
+                                                      cairo_t                  *cr,
+                                                      gpointer                  user_data);
+static void     panel_module_factory_allocate        (GtkWidget                *widget,
+                                                      GtkAllocation            *allocation,
+                                                      gpointer                  user_data);
+static void     panel_module_factory_event_handler   (GdkEvent                 *event,
+                                                      gpointer                  user_data);
 
 
 
@@ -72,8 +84,11 @@ struct _PanelModuleFactory
   /* relation for name -> PanelModule */
   GHashTable *modules;
 
-  /* all plugins in all windows */
-  GSList     *plugins;
+  /* all plugins in all windows, indexed by unique id and by name,
+   * both are kept up to date in panel_module_factory_new_plugin()
+   * and panel_module_factory_remove_plugin() */
+  GHashTable *plugins_by_id;
+  GHashTable *plugins_by_name;
 
   /* if the factory contains the launcher plugin */
   guint       has_launcher : 1;
@@ -81,8 +96,32 @@ struct _PanelModuleFactory
 
 
 
+typedef struct
+{
+  PanelModuleFactory *factory;
+  gint                unique_id;
+  gchar              *name;
+
+  /* counters for panel_module_factory_get_metrics(), times
+   * are in microseconds */
+  gint64              draw_begin;
+  gint64              draw_time;
+  gint64              event_time;
+  guint               n_draws;
+  guint               n_allocates;
+
+  /* watchdog labels, only set if the watchdog runs */
+  const gchar        *draw_label;
+  const gchar        *event_label;
+  const gchar        *draw_saved_label;
+}
+FactoryPlugin;
+
+
+
 static guint    factory_signals[LAST_SIGNAL];
 static gboolean force_all_external = FALSE;
+static GQuark   factory_plugin_quark = 0;
 
 
 
@@ -108,6 +147,8 @@ panel_module_factory_class_init (PanelModuleFactoryClass *klass)
                   0, NULL, NULL,
                   g_cclosure_marshal_VOID__OBJECT,
                   G_TYPE_NONE, 1, PANEL_TYPE_MODULE);
+
+  factory_plugin_quark = g_quark_from_static_string ("panel-module-factory-plugin");
 }
 
 
@@ -118,9 +159,15 @@ panel_module_factory_init (PanelModuleFactory *factory)
   factory->has_launcher = FALSE;
   factory->modules = g_hash_table_new_full (g_str_hash, g_str_equal,
                                             g_free, g_object_unref);
+  factory->plugins_by_id = g_hash_table_new (g_direct_hash, g_direct_equal);
+  factory->plugins_by_name = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                    g_free, NULL);
 
   /* load all the modules */
   panel_module_factory_load_modules (factory, TRUE);
+
+  /* time the events of internal plugins where gtk dispatches them */
+  gdk_event_handler_set (panel_module_factory_event_handler, factory, NULL);
 }
 
 
@@ -129,9 +176,17 @@ static void
 panel_module_factory_finalize (GObject *object)
 {
   PanelModuleFactory *factory = PANEL_MODULE_FACTORY (object);
+  GHashTableIter      iter;
+  gpointer            plugins;
+
+  gdk_event_handler_set ((GdkEventFunc) (void (*)(void)) gtk_main_do_event, NULL, NULL);
 
   g_hash_table_destroy (factory->modules);
-  g_slist_free (factory->plugins);
+  g_hash_table_destroy (factory->plugins_by_id);
+  g_hash_table_iter_init (&iter, factory->plugins_by_name);
+  while (g_hash_table_iter_next (&iter, NULL, &plugins))
+    g_slist_free (plugins);
+  g_hash_table_destroy (factory->plugins_by_name);
 
   (*G_OBJECT_CLASS (panel_module_factory_parent_class)->finalize) (object);
 }
@@ -224,9 +279,13 @@ panel_module_factory_load_modules (PanelModuleFactory *factory,
 {
   panel_return_if_fail (PANEL_IS_MODULE_FACTORY (factory));
 
+  panel_debug_trace_begin (PANEL_DEBUG_MODULE_FACTORY, "load-modules", -1);
+
   /* load from the new and old location */
   panel_module_factory_load_modules_dir (factory, PANEL_PLUGINS_DATA_DIR, warn_if_known);
   panel_module_factory_load_modules_dir (factory, PANEL_PLUGINS_DATA_DIR_OLD, warn_if_known);
+
+  panel_debug_trace_end (PANEL_DEBUG_MODULE_FACTORY, "load-modules", -1);
 }
 
 
@@ -261,30 +320,143 @@ static void
 panel_module_factory_remove_plugin (gpointer  user_data,
                                     GObject  *where_the_object_was)
 {
-  PanelModuleFactory *factory = PANEL_MODULE_FACTORY (user_data);
+  FactoryPlugin      *plugin = user_data;
+  PanelModuleFactory *factory = plugin->factory;
+  GSList             *plugins;
+
+  /* remove the plugin from the indexes, the provider is already
+   * finalized so use the name and id we stored on insert */
+  if (g_hash_table_lookup (factory->plugins_by_id,
+                           GINT_TO_POINTER (plugin->unique_id)) == where_the_object_was)
+    g_hash_table_remove (factory->plugins_by_id, GINT_TO_POINTER (plugin->unique_id));
+
+  plugins = g_hash_table_lookup (factory->plugins_by_name, plugin->name);
+  plugins = g_slist_remove (plugins, where_the_object_was);
+  if (plugins != NULL)
+    g_hash_table_replace (factory->plugins_by_name, g_strdup (plugin->name), plugins);
+  else
+    g_hash_table_remove (factory->plugins_by_name, plugin->name);
 
-  /* remove the plugin from the internal list */
-  factory->plugins = g_slist_remove (factory->plugins, where_the_object_was);
+  g_free (plugin->name);
+  g_slice_free (FactoryPlugin, plugin);
 }
 
 
 
-static inline gboolean
-panel_module_factory_unique_id_exists (PanelModuleFactory *factory,
-                                       gint                unique_id)
+static gboolean
+panel_module_factory_draw (GtkWidget *widget,
+                           cairo_t   *cr,
+                           gpointer   user_data)
+{
+  FactoryPlugin *plugin = user_data;
+
+  plugin->draw_begin = g_get_monotonic_time ();
+  panel_debug_watchdog_enter (plugin->draw_label, plugin->draw_saved_label);
+
+  return FALSE;
+}
+
+
+
+static gboolean
+panel_module_factory_draw_after (GtkWidget *widget,
+                                 cairo_t   *cr,
+                                 gpointer   user_data)
 {
-  GSList *li;
+  FactoryPlugin *plugin = user_data;
 
-  for (li = factory->plugins; li != NULL; li = li->next)
-    if (xfce_panel_plugin_provider_get_unique_id (
-        XFCE_PANEL_PLUGIN_PROVIDER (li->data)) == unique_id)
-      return TRUE;
+  panel_debug_watchdog_leave (plugin->draw_saved_label);
+
+  /* a handler can stop the emission before we get here, in
+   * that case the draw is simply not counted */
+  if (G_LIKELY (plugin->draw_begin > 0))
+    {
+      plugin->draw_time += g_get_monotonic_time () - plugin->draw_begin;
+      plugin->draw_begin = 0;
+      plugin->n_draws++;
+    }
 
   return FALSE;
 }
 
 
 
+static void
+panel_module_factory_allocate (GtkWidget     *widget,
+                               GtkAllocation *allocation,
+                               gpointer       user_data)
+{
+  FactoryPlugin *plugin = user_data;
+
+  plugin->n_allocates++;
+}
+
+
+
+static void
+panel_module_factory_event_handler (GdkEvent *event,
+                                    gpointer  user_data)
+{
+  static guint   depth = 0;
+  GtkWidget     *widget;
+  FactoryPlugin *plugin = NULL;
+  gint64         begin;
+  const gchar   *saved_label = NULL;
+
+  /* events in a recursive main loop of a plugin, like a dialog, are
+   * already part of the time of the outer event */
+  if (depth > 0)
+    {
+      gtk_main_do_event (event);
+      return;
+    }
+
+  /* gtk delivers the event to the innermost widget, like a button in
+   * the plugin, so look for the plugin among its ancestors */
+  for (widget = gtk_get_event_widget (event);
+       widget != NULL;
+       widget = gtk_widget_get_parent (widget))
+    {
+      plugin = g_object_get_qdata (G_OBJECT (widget), factory_plugin_quark);
+      if (plugin != NULL)
+        break;
+    }
+
+  /* external plugins handle their events in the wrapper */
+  if (plugin == NULL || PANEL_IS_PLUGIN_EXTERNAL (widget))
+    {
+      gtk_main_do_event (event);
+      return;
+    }
+
+  /* the plugin data is released when the plugin is finalized, keep
+   * it alive if the plugin is removed by the event */
+  g_object_ref (G_OBJECT (widget));
+
+  begin = g_get_monotonic_time ();
+  panel_debug_watchdog_enter (plugin->event_label, saved_label);
+
+  depth++;
+  gtk_main_do_event (event);
+  depth--;
+
+  panel_debug_watchdog_leave (saved_label);
+  plugin->event_time += g_get_monotonic_time () - begin;
+
+  g_object_unref (G_OBJECT (widget));
+}
+
+
+
+static inline gboolean
+panel_module_factory_unique_id_exists (PanelModuleFactory *factory,
+                                       gint                unique_id)
+{
+  return g_hash_table_contains (factory->plugins_by_id, GINT_TO_POINTER (unique_id));
+}
+
+
+
 PanelModuleFactory *
 panel_module_factory_get (void)
 {
@@ -380,34 +552,40 @@ GSList *
 panel_module_factory_get_plugins (PanelModuleFactory *factory,
                                   const gchar        *plugin_name)
 {
-  GSList *li, *plugins = NULL;
-  gchar  *unique_name;
+  GSList      *plugins;
+  const gchar *dash;
+  gchar       *end;
+  gint64       unique_id;
+  gpointer     provider;
 
   panel_return_val_if_fail (PANEL_IS_MODULE_FACTORY (factory), NULL);
   panel_return_val_if_fail (plugin_name != NULL, NULL);
 
   /* first assume a global plugin name is provided (ie. no name with id) */
-  for (li = factory->plugins; li != NULL; li = li->next)
-    {
-      panel_return_val_if_fail (XFCE_IS_PANEL_PLUGIN_PROVIDER (li->data), NULL);
-      if (strcmp (xfce_panel_plugin_provider_get_name (li->data), plugin_name) == 0)
-        plugins = g_slist_prepend (plugins, li->data);
-    }
+  plugins = g_hash_table_lookup (factory->plugins_by_name, plugin_name);
+  if (plugins != NULL)
+    return g_slist_copy (plugins);
 
   /* try the unique plugin name (with id) if nothing is found */
-  for (li = factory->plugins; plugins == NULL && li != NULL; li = li->next)
-    {
-      panel_return_val_if_fail (XFCE_IS_PANEL_PLUGIN_PROVIDER (li->data), NULL);
-      unique_name = g_strdup_printf ("%s-%d", xfce_panel_plugin_provider_get_name (li->data),
-                                     xfce_panel_plugin_provider_get_unique_id (li->data));
+  dash = strrchr (plugin_name, '-');
+  if (dash == NULL || !g_ascii_isdigit (dash[1]))
+    return NULL;
 
-      if (strcmp (unique_name, plugin_name) == 0)
-        plugins = g_slist_prepend (plugins, li->data);
+  unique_id = g_ascii_strtoll (dash + 1, &end, 10);
+  if (*end != '\0' || unique_id < 1 || unique_id > G_MAXINT)
+    return NULL;
 
-      g_free (unique_name);
-    }
+  provider = g_hash_table_lookup (factory->plugins_by_id, GINT_TO_POINTER ((gint) unique_id));
+  if (provider == NULL)
+    return NULL;
 
-  return plugins;
+  /* check if the name part matches too */
+  panel_return_val_if_fail (XFCE_IS_PANEL_PLUGIN_PROVIDER (provider), NULL);
+  if (strncmp (xfce_panel_plugin_provider_get_name (provider), plugin_name, dash - plugin_name) != 0
+      || xfce_panel_plugin_provider_get_name (provider)[dash - plugin_name] != '\0')
+    return NULL;
+
+  return g_slist_prepend (NULL, provider);
 }
 
 
@@ -420,9 +598,11 @@ panel_module_factory_new_plugin (PanelModuleFactory  *factory,
                                  gchar              **arguments,
                                  gint                *return_unique_id)
 {
-  PanelModule *module;
-  GtkWidget   *provider;
-  static gint  unique_id_counter = 0;
+  PanelModule   *module;
+  GtkWidget     *provider;
+  static gint    unique_id_counter = 0;
+  FactoryPlugin *plugin;
+  GSList        *plugins;
 
   panel_return_val_if_fail (PANEL_IS_MODULE_FACTORY (factory), NULL);
   panel_return_val_if_fail (GDK_IS_SCREEN (screen), NULL);
@@ -448,11 +628,38 @@ panel_module_factory_new_plugin (PanelModuleFactory  *factory,
   /* create the new module */
   provider = panel_module_new_plugin (module, screen, unique_id, arguments);
 
-  /* insert plugin in the list */
+  /* insert plugin in the indexes */
   if (G_LIKELY (provider))
     {
-      factory->plugins = g_slist_prepend (factory->plugins, provider);
-      g_object_weak_ref (G_OBJECT (provider), panel_module_factory_remove_plugin, factory);
+      plugin = g_slice_new0 (FactoryPlugin);
+      plugin->factory = factory;
+      plugin->unique_id = unique_id;
+      plugin->name = g_strdup (name);
+
+      if (panel_debug_watchdog_enabled ())
+        {
+          plugin->draw_label = panel_debug_watchdog_intern ("%s-%d draw", name, unique_id);
+          plugin->event_label = panel_debug_watchdog_intern ("%s-%d event", name, unique_id);
+        }
+
+      g_hash_table_insert (factory->plugins_by_id, GINT_TO_POINTER (unique_id), provider);
+
+      plugins = g_hash_table_lookup (factory->plugins_by_name, name);
+      g_hash_table_replace (factory->plugins_by_name, g_strdup (name),
+                            g_slist_prepend (plugins, provider));
+
+      g_object_weak_ref (G_OBJECT (provider), panel_module_factory_remove_plugin, plugin);
+      g_object_set_qdata (G_OBJECT (provider), factory_plugin_quark, plugin);
+
+      /* cheap counters for the health metrics, only a few clock
+       * reads per frame */
+      g_signal_connect (G_OBJECT (provider), "draw",
+          G_CALLBACK (panel_module_factory_draw), plugin);
+      g_signal_connect_after (G_OBJECT (provider), "draw",
+          G_CALLBACK (panel_module_factory_draw_after), plugin);
+      g_signal_connect (G_OBJECT (provider), "size-allocate",
+          G_CALLBACK (panel_module_factory_allocate), plugin);
+
     }
 
   /* emit unique-changed if the plugin is unique */
@@ -461,3 +668,58 @@ panel_module_factory_new_plugin (PanelModuleFactory  *factory,
 
   return provider;
 }
+
+
+
+static gint
+panel_module_factory_compare_ids (gconstpointer a,
+                                  gconstpointer b)
+{
+  return GPOINTER_TO_INT (a) - GPOINTER_TO_INT (b);
+}
+
+
+
+GVariant *
+panel_module_factory_get_metrics (PanelModuleFactory *factory)
+{
+  GVariantBuilder  builder;
+  GVariantDict     dict;
+  GList           *ids, *li;
+  GObject         *provider;
+  FactoryPlugin   *plugin;
+  gboolean         external;
+
+  panel_return_val_if_fail (PANEL_IS_MODULE_FACTORY (factory), NULL);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(sia{sv})"));
+
+  ids = g_list_sort (g_hash_table_get_keys (factory->plugins_by_id),
+                     panel_module_factory_compare_ids);
+  for (li = ids; li != NULL; li = li->next)
+    {
+      provider = g_hash_table_lookup (factory->plugins_by_id, li->data);
+      plugin = g_object_get_qdata (provider, factory_plugin_quark);
+      panel_assert (plugin != NULL);
+
+      external = PANEL_IS_PLUGIN_EXTERNAL (provider);
+
+      g_variant_dict_init (&dict, NULL);
+      g_variant_dict_insert (&dict, "external", "b", external);
+      g_variant_dict_insert (&dict, "draws", "u", plugin->n_draws);
+      g_variant_dict_insert (&dict, "draw-time", "t", (guint64) plugin->draw_time);
+      g_variant_dict_insert (&dict, "size-allocates", "u", plugin->n_allocates);
+
+      if (external)
+        panel_plugin_external_get_metrics (PANEL_PLUGIN_EXTERNAL (provider), &dict);
+      else
+        g_variant_dict_insert (&dict, "callback-time", "t",
+                               (guint64) (plugin->draw_time + plugin->event_time));
+
+      g_variant_builder_add (&builder, "(si@a{sv})", plugin->name,
+                             plugin->unique_id, g_variant_dict_end (&dict));
+    }
+  g_list_free (ids);
+
+  return g_variant_builder_end (&builder);
+}
@@ -64,6 +64,8 @@ GtkWidget          *panel_module_factory_new_plugin          (PanelModuleFactory
                                                               gchar              **arguments,
                                                               gint                *return_unique_id) G_GNUC_MALLOC;
 
+GVariant           *panel_module_factory_get_metrics         (PanelModuleFactory  *factory);
+
 G_END_DECLS
 
 #endif /* !__PANEL_MODULE_FACTORY_H__ */
@@ -441,6 +441,7 @@ panel_module_new_plugin (PanelModule  *module,
 {
   GtkWidget   *plugin = NULL;
   const gchar *debug_type = NULL;
+  const gchar *saved_label = NULL;
 
   panel_return_val_if_fail (PANEL_IS_MODULE (module), NULL);
   panel_return_val_if_fail (G_IS_TYPE_MODULE (module), NULL);
@@ -452,6 +453,15 @@ panel_module_new_plugin (PanelModule  *module,
   if (G_UNLIKELY (!panel_module_is_usable (module, screen)))
     return NULL;
 
+  /* this only covers the instantiation, object plugins run their
+   * construct on realize, see panel_itembar_construct_begin() */
+  panel_debug_trace_begin (PANEL_DEBUG_MODULE, "plugin-new", unique_id);
+  panel_debug_trace_set_label ("plugin-new", unique_id, panel_module_get_name (module));
+  panel_debug_watchdog_enter (panel_debug_watchdog_intern ("%s-%d new",
+                                                           panel_module_get_name (module),
+                                                           unique_id),
+                              saved_label);
+
   switch (module->mode)
     {
     case INTERNAL:
@@ -525,6 +535,9 @@ panel_module_new_plugin (PanelModule  *module,
       g_object_set_qdata (G_OBJECT (plugin), module_quark, module);
     }
 
+  panel_debug_watchdog_leave (saved_label);
+  panel_debug_trace_end (PANEL_DEBUG_MODULE, "plugin-new", unique_id);
+
   return plugin;
 }
 
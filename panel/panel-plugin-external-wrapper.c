@@ -75,6 +75,10 @@ static gboolean   panel_plugin_external_wrapper_dbus_remote_event_result (XfcePa
                                                                           guint                           handle,
                                                                           gboolean                        result,
                                                                           PanelPluginExternalWrapper     *wrapper);
+static gboolean   panel_plugin_external_wrapper_dbus_remote_event_results (XfcePanelPluginWrapperExported *skeleton,
+                                                                           GDBusMethodInvocation          *invocation,
+                                                                           GVariant                       *results,
+                                                                           PanelPluginExternalWrapper     *wrapper);
 
 
 
@@ -92,6 +96,10 @@ struct _PanelPluginExternalWrapper
 
   GDBusConnection                *connection;
 
+  /* remote events queued during a batch, see
+   * panel_plugin_external_wrapper_remote_events_begin() */
+  GVariantBuilder                *remote_events;
+
   gboolean                        exported : 1;
 
 };
@@ -106,6 +114,10 @@ enum
 
 static guint external_signals[LAST_SIGNAL];
 
+/* wrappers with queued remote events */
+static guint   remote_events_batch_depth = 0;
+static GSList *remote_events_batch = NULL;
+
 
 
 G_DEFINE_TYPE (PanelPluginExternalWrapper, panel_plugin_external_wrapper, PANEL_TYPE_PLUGIN_EXTERNAL)
@@ -180,6 +192,8 @@ panel_plugin_external_wrapper_constructed (GObject *object)
                             G_CALLBACK (panel_plugin_external_wrapper_dbus_provider_signal), wrapper);
           g_signal_connect (wrapper->skeleton, "handle_remote_event_result",
                             G_CALLBACK (panel_plugin_external_wrapper_dbus_remote_event_result), wrapper);
+          g_signal_connect (wrapper->skeleton, "handle_remote_event_results",
+                            G_CALLBACK (panel_plugin_external_wrapper_dbus_remote_event_results), wrapper);
           panel_debug (PANEL_DEBUG_EXTERNAL, "register dbus path %s", path);
 
           wrapper->exported = TRUE;
@@ -204,6 +218,9 @@ panel_plugin_external_wrapper_finalize (GObject *object)
 
   wrapper = PANEL_PLUGIN_EXTERNAL_WRAPPER (object);
 
+  /* the batch holds a reference, so nothing can be queued here */
+  panel_assert (wrapper->remote_events == NULL);
+
   if (wrapper->exported)
     {
       g_object_unref (wrapper->skeleton);
@@ -374,16 +391,33 @@ panel_plugin_external_wrapper_remote_event (PanelPluginExternal *external,
       variant = g_variant_new_variant (g_variant_new_byte ('\0'));
     }
 
-  g_dbus_connection_emit_signal (wrapper->connection,
-                                 NULL,
-                                 g_dbus_interface_skeleton_get_object_path (G_DBUS_INTERFACE_SKELETON (wrapper->skeleton)),
-                                 "org.xfce.Panel.Wrapper",
-                                 "RemoteEvent",
-                                 g_variant_new ("(svu)",
-                                                name,
-                                                variant,
-                                                *handle),
-                                 NULL);
+  if (remote_events_batch_depth > 0)
+    {
+      /* send the event with the others in the batch */
+      if (wrapper->remote_events == NULL)
+        {
+          wrapper->remote_events = g_variant_builder_new (G_VARIANT_TYPE ("a(svu)"));
+          remote_events_batch = g_slist_prepend (remote_events_batch, g_object_ref (wrapper));
+        }
+
+      g_variant_builder_add (wrapper->remote_events, "(svu)", name, variant, *handle);
+    }
+  else
+    {
+      g_dbus_connection_emit_signal (wrapper->connection,
+                                     NULL,
+                                     g_dbus_interface_skeleton_get_object_path (G_DBUS_INTERFACE_SKELETON (wrapper->skeleton)),
+                                     "org.xfce.Panel.Wrapper",
+                                     "RemoteEvent",
+                                     g_variant_new ("(svu)",
+                                                    name,
+                                                    variant,
+                                                    *handle),
+                                     NULL);
+    }
+
+  /* finished when the wrapper returns the result */
+  panel_debug_trace_async_begin (PANEL_DEBUG_EXTERNAL, "remote-event", *handle);
 
   return TRUE;
 }
@@ -431,6 +465,9 @@ panel_plugin_external_wrapper_dbus_remote_event_result (XfcePanelPluginWrapperEx
 {
   panel_return_val_if_fail (PANEL_IS_PLUGIN_EXTERNAL (wrapper), FALSE);
 
+  panel_debug_trace_async_end (PANEL_DEBUG_EXTERNAL, "remote-event", handle);
+  panel_plugin_external_remote_event_result (PANEL_PLUGIN_EXTERNAL (wrapper), handle);
+
   g_signal_emit (G_OBJECT (wrapper), external_signals[REMOTE_EVENT_RESULT], 0,
                  handle, result);
 
@@ -441,6 +478,35 @@ panel_plugin_external_wrapper_dbus_remote_event_result (XfcePanelPluginWrapperEx
 
 
 
+static gboolean
+panel_plugin_external_wrapper_dbus_remote_event_results (XfcePanelPluginWrapperExported *skeleton,
+                                                         GDBusMethodInvocation          *invocation,
+                                                         GVariant                       *results,
+                                                         PanelPluginExternalWrapper     *wrapper)
+{
+  GVariantIter iter;
+  guint        handle;
+  gboolean     result;
+
+  panel_return_val_if_fail (PANEL_IS_PLUGIN_EXTERNAL (wrapper), FALSE);
+
+  g_variant_iter_init (&iter, results);
+  while (g_variant_iter_next (&iter, "(ub)", &handle, &result))
+    {
+      panel_debug_trace_async_end (PANEL_DEBUG_EXTERNAL, "remote-event", handle);
+      panel_plugin_external_remote_event_result (PANEL_PLUGIN_EXTERNAL (wrapper), handle);
+
+      g_signal_emit (G_OBJECT (wrapper), external_signals[REMOTE_EVENT_RESULT], 0,
+                     handle, result);
+    }
+
+  xfce_panel_plugin_wrapper_exported_complete_remote_event_results (skeleton, invocation);
+
+  return TRUE;
+}
+
+
+
 GtkWidget *
 panel_plugin_external_wrapper_new (PanelModule  *module,
                                    gint          unique_id,
@@ -454,3 +520,54 @@ panel_plugin_external_wrapper_new (PanelModule  *module,
                        "unique-id", unique_id,
                        "arguments", arguments, NULL);
 }
+
+
+
+/**
+ * panel_plugin_external_wrapper_remote_events_begin:
+ *
+ * Queue the remote events for external plugins until
+ * panel_plugin_external_wrapper_remote_events_end() is called, so
+ * each wrapper receives them in a single RemoteEvents signal. Calls
+ * can be nested.
+ **/
+void
+panel_plugin_external_wrapper_remote_events_begin (void)
+{
+  remote_events_batch_depth++;
+}
+
+
+
+void
+panel_plugin_external_wrapper_remote_events_end (void)
+{
+  GSList                     *li;
+  PanelPluginExternalWrapper *wrapper;
+
+  panel_return_if_fail (remote_events_batch_depth > 0);
+
+  if (--remote_events_batch_depth > 0)
+    return;
+
+  for (li = remote_events_batch; li != NULL; li = li->next)
+    {
+      wrapper = PANEL_PLUGIN_EXTERNAL_WRAPPER (li->data);
+
+      g_dbus_connection_emit_signal (wrapper->connection,
+                                     NULL,
+                                     g_dbus_interface_skeleton_get_object_path (G_DBUS_INTERFACE_SKELETON (wrapper->skeleton)),
+                                     "org.xfce.Panel.Wrapper",
+                                     "RemoteEvents",
+                                     g_variant_new ("(a(svu))", wrapper->remote_events),
+                                     NULL);
+
+      g_variant_builder_unref (wrapper->remote_events);
+      wrapper->remote_events = NULL;
+
+      g_object_unref (G_OBJECT (wrapper));
+    }
+
+  g_slist_free (remote_events_batch);
+  remote_events_batch = NULL;
+}
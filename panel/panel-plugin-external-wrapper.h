@@ -42,6 +42,10 @@ GtkWidget *panel_plugin_external_wrapper_new      (PanelModule  *module,
                                                    gint          unique_id,
                                                    gchar       **arguments) G_GNUC_MALLOC;
 
+void       panel_plugin_external_wrapper_remote_events_begin (void);
+
+void       panel_plugin_external_wrapper_remote_events_end   (void);
+
 G_END_DECLS
 
 #endif /* !__PANEL_PLUGIN_EXTERNAL_WRAPPER_H__ */
@@ -29,6 +29,12 @@
 #ifdef HAVE_SYS_WAIT_H
 #include <sys/wait.h>
 #endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
 
 #include <gdk/gdk.h>
 #include <gdk/gdkx.h>
@@ -128,6 +134,13 @@ struct _PanelPluginExternalPrivate
 
   /* delayed spawning */
   guint       spawn_timeout_id;
+
+  /* health counters, see panel_plugin_external_get_metrics() */
+  guint       n_respawns;
+  GHashTable *remote_event_times;
+  guint       n_remote_events;
+  gint64      remote_event_latency;
+  gint64      remote_event_latency_max;
 };
 
 enum
@@ -210,6 +223,11 @@ panel_plugin_external_init (PanelPluginExternal *external)
   external->priv->embedded = FALSE;
   external->priv->pid = 0;
   external->priv->spawn_timeout_id = 0;
+  external->priv->n_respawns = 0;
+  external->priv->remote_event_times = NULL;
+  external->priv->n_remote_events = 0;
+  external->priv->remote_event_latency = 0;
+  external->priv->remote_event_latency_max = 0;
 
   /* signal to pass gtk_widget_set_sensitive() changes to the remote window */
   g_signal_connect (G_OBJECT (external), "notify::sensitive",
@@ -265,6 +283,9 @@ panel_plugin_external_finalize (GObject *object)
   if (external->priv->restart_timer != NULL)
     g_timer_destroy (external->priv->restart_timer);
 
+  if (external->priv->remote_event_times != NULL)
+    g_hash_table_destroy (external->priv->remote_event_times);
+
   g_object_unref (G_OBJECT (external->module));
 
   (*G_OBJECT_CLASS (panel_plugin_external_parent_class)->finalize) (object);
@@ -389,6 +410,9 @@ panel_plugin_external_plug_added (GtkSocket *socket)
 
   external->priv->embedded = TRUE;
 
+  panel_debug_trace_instant (PANEL_DEBUG_EXTERNAL, "plugin-embedded", external->unique_id);
+  panel_debug_trace_async_end (PANEL_DEBUG_EXTERNAL, "plugin-embed", external->unique_id);
+
   panel_debug (PANEL_DEBUG_EXTERNAL,
                "%s-%d: child is embedded; %d properties in queue",
                panel_module_get_name (external->module),
@@ -608,9 +632,13 @@ panel_plugin_external_child_spawn (PanelPluginExternal *external)
     }
 
   /* spawn the proccess */
+  panel_debug_trace_set_label ("plugin-spawn", external->unique_id, panel_module_get_name (external->module));
+  panel_debug_trace_set_label ("plugin-embed", external->unique_id, panel_module_get_name (external->module));
+  panel_debug_trace_begin (PANEL_DEBUG_EXTERNAL, "plugin-spawn", external->unique_id);
   succeed = g_spawn_async (NULL, argv, NULL, G_SPAWN_DO_NOT_REAP_CHILD,
                            panel_plugin_external_child_spawn_child_setup,
                            external, &pid, &error);
+  panel_debug_trace_end (PANEL_DEBUG_EXTERNAL, "plugin-spawn", external->unique_id);
 
   panel_debug (PANEL_DEBUG_EXTERNAL,
                "%s-%d: child spawned; pid=%d, argc=%d",
@@ -619,6 +647,9 @@ panel_plugin_external_child_spawn (PanelPluginExternal *external)
 
   if (G_LIKELY (succeed))
     {
+      /* spawn to embed latency of the wrapper */
+      panel_debug_trace_async_begin (PANEL_DEBUG_EXTERNAL, "plugin-embed", external->unique_id);
+
       /* watch the child */
       external->priv->pid = pid;
       external->priv->watch_id = g_child_watch_add_full (G_PRIORITY_LOW, pid,
@@ -665,6 +696,8 @@ panel_plugin_external_child_respawn (gpointer user_data)
   panel_return_val_if_fail (PANEL_IS_WINDOW (window), FALSE);
   panel_window_set_povider_info (PANEL_WINDOW (window), GTK_WIDGET (external), FALSE);
 
+  external->priv->n_respawns++;
+
   panel_plugin_external_child_spawn (external);
 
   /* stop timeout */
@@ -715,6 +748,10 @@ panel_plugin_external_child_watch (GPid     pid,
   external->priv->pid = 0;
   external->priv->embedded = FALSE;
 
+  /* pending remote events will never return a result */
+  if (external->priv->remote_event_times != NULL)
+    g_hash_table_remove_all (external->priv->remote_event_times);
+
   panel_debug (PANEL_DEBUG_EXTERNAL,
                "%s-%d: child exited with status %d",
                panel_module_get_name (external->module),
@@ -1062,8 +1099,28 @@ panel_plugin_external_remote_event (XfcePanelPluginProvider *provider,
                                     const GValue            *value,
                                     guint                   *handle)
 {
-  return (*PANEL_PLUGIN_EXTERNAL_GET_CLASS (provider)->remote_event) (PANEL_PLUGIN_EXTERNAL (provider),
-                                                                      name, value, handle);
+  PanelPluginExternal *external = PANEL_PLUGIN_EXTERNAL (provider);
+  gboolean             result;
+  gint64              *start_time;
+
+  result = (*PANEL_PLUGIN_EXTERNAL_GET_CLASS (provider)->remote_event) (external,
+                                                                        name, value, handle);
+
+  /* remember when the event was sent, the latency is recorded when
+   * the implementation calls panel_plugin_external_remote_event_result() */
+  if (*handle > 0)
+    {
+      if (external->priv->remote_event_times == NULL)
+        external->priv->remote_event_times = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                                                    NULL, g_free);
+
+      start_time = g_new (gint64, 1);
+      *start_time = g_get_monotonic_time ();
+      g_hash_table_replace (external->priv->remote_event_times,
+                            GUINT_TO_POINTER (*handle), start_time);
+    }
+
+  return result;
 }
 
 
@@ -1230,3 +1287,81 @@ panel_plugin_external_get_pid (PanelPluginExternal *external)
   panel_return_val_if_fail (PANEL_IS_PLUGIN_EXTERNAL (external), 0);
   return external->priv->pid;
 }
+
+
+
+void
+panel_plugin_external_remote_event_result (PanelPluginExternal *external,
+                                           guint                handle)
+{
+  gint64 *start_time;
+  gint64  latency;
+
+  panel_return_if_fail (PANEL_IS_PLUGIN_EXTERNAL (external));
+
+  if (external->priv->remote_event_times == NULL)
+    return;
+
+  start_time = g_hash_table_lookup (external->priv->remote_event_times,
+                                    GUINT_TO_POINTER (handle));
+  if (G_UNLIKELY (start_time == NULL))
+    return;
+
+  latency = g_get_monotonic_time () - *start_time;
+  g_hash_table_remove (external->priv->remote_event_times, GUINT_TO_POINTER (handle));
+
+  external->priv->n_remote_events++;
+  external->priv->remote_event_latency += latency;
+  external->priv->remote_event_latency_max = MAX (external->priv->remote_event_latency_max,
+                                                  latency);
+}
+
+
+
+void
+panel_plugin_external_get_metrics (PanelPluginExternal *external,
+                                   GVariantDict        *dict)
+{
+  PanelPluginExternalPrivate *priv;
+  gchar                      *filename;
+  gchar                      *contents;
+  const gchar                *p;
+  guint64                     resident;
+
+  panel_return_if_fail (PANEL_IS_PLUGIN_EXTERNAL (external));
+  panel_return_if_fail (dict != NULL);
+
+  priv = external->priv;
+
+  g_variant_dict_insert (dict, "respawns", "u", priv->n_respawns);
+  g_variant_dict_insert (dict, "remote-events", "u", priv->n_remote_events);
+  g_variant_dict_insert (dict, "remote-event-latency", "t",
+                         priv->n_remote_events > 0 ?
+                         (guint64) (priv->remote_event_latency / priv->n_remote_events) : 0);
+  g_variant_dict_insert (dict, "remote-event-latency-max", "t",
+                         (guint64) priv->remote_event_latency_max);
+
+  if (priv->pid == 0)
+    return;
+
+  g_variant_dict_insert (dict, "pid", "i", (gint32) priv->pid);
+
+  /* the resident set of the wrapper is only read on request, the
+   * second field in statm is the number of resident pages */
+  filename = g_strdup_printf ("/proc/%d/statm", (gint) priv->pid);
+  if (g_file_get_contents (filename, &contents, NULL, NULL))
+    {
+      p = strchr (contents, ' ');
+      if (p != NULL)
+        {
+          resident = g_ascii_strtoull (p + 1, NULL, 10);
+#ifdef HAVE_UNISTD_H
+          g_variant_dict_insert (dict, "rss", "t", resident * (guint64) sysconf (_SC_PAGESIZE));
+#else
+          g_variant_dict_insert (dict, "rss", "t", resident * 4096);
+#endif
+        }
+      g_free (contents);
+    }
+  g_free (filename);
+}
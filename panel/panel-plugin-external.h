@@ -97,6 +97,12 @@ void         panel_plugin_external_set_background_image (PanelPluginExternal  *e
 
 GPid         panel_plugin_external_get_pid              (PanelPluginExternal  *external);
 
+void         panel_plugin_external_remote_event_result  (PanelPluginExternal  *external,
+                                                         guint                 handle);
+
+void         panel_plugin_external_get_metrics          (PanelPluginExternal  *external,
+                                                         GVariantDict         *dict);
+
 G_END_DECLS
 
 #endif /* !__PANEL_PLUGIN_EXTERNAL_H__ */
@@ -84,7 +84,16 @@ static void                     panel_preferences_dialog_panel_switch
                                                                                  PanelPreferencesDialog *dialog);
 static XfcePanelPluginProvider *panel_preferences_dialog_item_get_selected      (PanelPreferencesDialog *dialog,
                                                                                  GtkTreeIter            *return_iter);
-static void                     panel_preferences_dialog_item_store_rebuild     (GtkWidget              *itembar,
+static gboolean                 panel_preferences_dialog_item_store_find        (PanelPreferencesDialog *dialog,
+                                                                                 gpointer                provider,
+                                                                                 GtkTreeIter            *iter);
+static gchar                   *panel_preferences_dialog_item_tooltip           (gpointer                provider);
+static void                     panel_preferences_dialog_item_store_insert      (PanelPreferencesDialog *dialog,
+                                                                                 GtkTreeIter            *sibling,
+                                                                                 gpointer                provider);
+static void                     panel_preferences_dialog_item_store_sync        (GtkWidget              *itembar,
+                                                                                 PanelPreferencesDialog *dialog);
+static void                     panel_preferences_dialog_item_plug_added        (GtkSocket              *socket,
                                                                                  PanelPreferencesDialog *dialog);
 static void                     panel_preferences_dialog_item_move              (GtkWidget              *button,
                                                                                  PanelPreferencesDialog *dialog);
@@ -846,14 +855,14 @@ panel_preferences_dialog_panel_combobox_changed (GtkComboBox            *combobo
       itembar = gtk_bin_get_child (GTK_BIN (dialog->active));
       dialog->items_changed_handler_id =
           g_signal_connect (G_OBJECT (itembar), "changed",
-                            G_CALLBACK (panel_preferences_dialog_item_store_rebuild),
+                            G_CALLBACK (panel_preferences_dialog_item_store_sync),
                             dialog);
 
       /* rebind the dialog bindings */
       panel_preferences_dialog_bindings_update (dialog);
 
       /* update the items treeview */
-      panel_preferences_dialog_item_store_rebuild (itembar, dialog);
+      panel_preferences_dialog_item_store_sync (itembar, dialog);
     }
 
   panel_preferences_dialog_panel_sensitive (dialog);
@@ -1123,91 +1132,203 @@ panel_preferences_dialog_item_get_selected (PanelPreferencesDialog *dialog,
 
 
 
+static gboolean
+panel_preferences_dialog_item_store_find (PanelPreferencesDialog *dialog,
+                                          gpointer                provider,
+                                          GtkTreeIter            *iter)
+{
+  GtkTreeModel *model = GTK_TREE_MODEL (dialog->store);
+  GObject      *row_provider;
+  gboolean      valid;
+
+  /* look for the row of provider, starting at iter */
+  for (valid = TRUE; valid; valid = gtk_tree_model_iter_next (model, iter))
+    {
+      gtk_tree_model_get (model, iter, ITEM_COLUMN_PROVIDER, &row_provider, -1);
+      if (row_provider != NULL)
+        g_object_unref (row_provider);
+
+      if (row_provider == provider)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+
+
+static gchar *
+panel_preferences_dialog_item_tooltip (gpointer provider)
+{
+  if (PANEL_IS_PLUGIN_EXTERNAL (provider))
+    {
+      /* I18N: tooltip in preferences dialog when hovering an item in the list
+       * for external plugins */
+      return g_strdup_printf (_("Internal name: %s-%d\n"
+                                "PID: %d"),
+                              xfce_panel_plugin_provider_get_name (provider),
+                              xfce_panel_plugin_provider_get_unique_id (provider),
+                              panel_plugin_external_get_pid (PANEL_PLUGIN_EXTERNAL (provider)));
+    }
+
+  /* I18N: tooltip in preferences dialog when hovering an item in the list
+   * for internal plugins */
+  return g_strdup_printf (_("Internal name: %s-%d"),
+                          xfce_panel_plugin_provider_get_name (provider),
+                          xfce_panel_plugin_provider_get_unique_id (provider));
+}
+
+
+
 static void
-panel_preferences_dialog_item_store_rebuild (GtkWidget              *itembar,
-                                             PanelPreferencesDialog *dialog)
+panel_preferences_dialog_item_store_insert (PanelPreferencesDialog *dialog,
+                                            GtkTreeIter            *sibling,
+                                            gpointer                provider)
 {
-  GList                   *items, *li;
-  guint                    i;
-  PanelModule             *module;
-  gchar                   *tooltip, *display_name;
-  XfcePanelPluginProvider *selected_provider;
-  GtkTreeIter              iter;
-  GtkTreePath             *path;
-  GObject                 *treeview;
+  PanelModule *module;
+  gchar       *tooltip, *display_name;
+  GtkTreeIter  iter;
+
+  /* get the panel module from the plugin */
+  module = panel_module_get_from_plugin_provider (provider);
+
+  if (PANEL_IS_PLUGIN_EXTERNAL (provider))
+    {
+      /* I18N: append (external) in the preferences dialog if the plugin
+       * runs external */
+      display_name = g_strdup_printf (_("%s <span color=\"grey\" size=\"small\">(external)</span>"),
+                                      panel_module_get_display_name (module));
+
+      /* the pid in the tooltip changes when the plugin is respawned,
+       * connect once, the row could have been inserted before */
+      g_signal_handlers_disconnect_by_func (G_OBJECT (provider),
+          G_CALLBACK (panel_preferences_dialog_item_plug_added), dialog);
+      g_signal_connect_object (G_OBJECT (provider), "plug-added",
+          G_CALLBACK (panel_preferences_dialog_item_plug_added), dialog, 0);
+    }
+  else
+    {
+      display_name = g_strdup (panel_module_get_display_name (module));
+    }
+
+  tooltip = panel_preferences_dialog_item_tooltip (provider);
+
+  gtk_list_store_insert_before (dialog->store, &iter, sibling);
+  gtk_list_store_set (dialog->store, &iter,
+                      ITEM_COLUMN_ICON_NAME,
+                      panel_module_get_icon_name (module),
+                      ITEM_COLUMN_DISPLAY_NAME,
+                      display_name,
+                      ITEM_COLUMN_TOOLTIP,
+                      tooltip,
+                      ITEM_COLUMN_PROVIDER, provider, -1);
+
+  g_free (tooltip);
+  g_free (display_name);
+}
+
+
+
+static void
+panel_preferences_dialog_item_store_sync (GtkWidget              *itembar,
+                                          PanelPreferencesDialog *dialog)
+{
+  GList            *items, *li;
+  GtkTreeModel     *model;
+  GtkTreeIter       iter, iter_b;
+  gboolean          valid;
+  GObject          *provider;
+  GObject          *treeview;
+  GtkTreeSelection *selection;
 
   panel_return_if_fail (PANEL_IS_PREFERENCES_DIALOG (dialog));
   panel_return_if_fail (GTK_IS_LIST_STORE (dialog->store));
   panel_return_if_fail (PANEL_IS_ITEMBAR (itembar));
 
-  /* memorize selected item */
-  selected_provider = panel_preferences_dialog_item_get_selected (dialog, NULL);
-
-  gtk_list_store_clear (dialog->store);
+  model = GTK_TREE_MODEL (dialog->store);
 
   g_signal_handlers_block_by_func (G_OBJECT (dialog->store),
       G_CALLBACK (panel_preferences_dialog_item_row_changed), dialog);
 
-  /* add items to the store */
+  /* walk the items and the store side by side, so only rows of
+   * added, removed or moved items are touched and the other rows
+   * (and the selection) stay as they are */
+  valid = gtk_tree_model_get_iter_first (model, &iter);
   items = gtk_container_get_children (GTK_CONTAINER (itembar));
-  for (li = items, i = 0; li != NULL; li = li->next, i++)
+  for (li = items; li != NULL; li = li->next)
     {
-      /* get the panel module from the plugin */
-      module = panel_module_get_from_plugin_provider (li->data);
-
-      if (PANEL_IS_PLUGIN_EXTERNAL (li->data))
-        {
-          /* I18N: append (external) in the preferences dialog if the plugin
-           * runs external */
-          display_name = g_strdup_printf (_("%s <span color=\"grey\" size=\"small\">(external)</span>"),
-                                          panel_module_get_display_name (module));
-
-          /* I18N: tooltip in preferences dialog when hovering an item in the list
-           * for external plugins */
-          tooltip = g_strdup_printf (_("Internal name: %s-%d\n"
-                                       "PID: %d"),
-                                     xfce_panel_plugin_provider_get_name (li->data),
-                                     xfce_panel_plugin_provider_get_unique_id (li->data),
-                                     panel_plugin_external_get_pid (PANEL_PLUGIN_EXTERNAL (li->data)));
-        }
-      else
+      if (valid)
         {
-          display_name = g_strdup (panel_module_get_display_name (module));
+          gtk_tree_model_get (model, &iter, ITEM_COLUMN_PROVIDER, &provider, -1);
+          if (provider != NULL)
+            g_object_unref (provider);
 
-          /* I18N: tooltip in preferences dialog when hovering an item in the list
-           * for internal plugins */
-          tooltip = g_strdup_printf (_("Internal name: %s-%d"),
-                                     xfce_panel_plugin_provider_get_name (li->data),
-                                     xfce_panel_plugin_provider_get_unique_id (li->data));
-        }
+          /* row is already at the right position */
+          if (provider == li->data)
+            {
+              valid = gtk_tree_model_iter_next (model, &iter);
+              continue;
+            }
 
-      gtk_list_store_insert_with_values (dialog->store, &iter, i,
-                                         ITEM_COLUMN_ICON_NAME,
-                                         panel_module_get_icon_name (module),
-                                         ITEM_COLUMN_DISPLAY_NAME,
-                                         display_name,
-                                         ITEM_COLUMN_TOOLTIP,
-                                         tooltip,
-                                         ITEM_COLUMN_PROVIDER, li->data, -1);
-
-      /* reconstruct selection */
-      if (selected_provider == li->data)
-        {
-          path = gtk_tree_model_get_path (GTK_TREE_MODEL (dialog->store), &iter);
-          treeview = gtk_builder_get_object (GTK_BUILDER (dialog), "item-treeview");
-          if (GTK_IS_WIDGET (treeview))
-            gtk_tree_view_set_cursor (GTK_TREE_VIEW (treeview), path, NULL, FALSE);
-          gtk_tree_path_free (path);
+          /* the item was moved up on the panel */
+          iter_b = iter;
+          if (gtk_tree_model_iter_next (model, &iter_b)
+              && panel_preferences_dialog_item_store_find (dialog, li->data, &iter_b))
+            {
+              gtk_list_store_move_before (dialog->store, &iter_b, &iter);
+              continue;
+            }
         }
 
-      g_free (tooltip);
-      g_free (display_name);
+      /* new item on the panel */
+      panel_preferences_dialog_item_store_insert (dialog, valid ? &iter : NULL, li->data);
     }
 
   g_list_free (items);
 
+  /* remaining rows are items that were removed from the panel */
+  while (valid)
+    valid = gtk_list_store_remove (dialog->store, &iter);
+
+  g_signal_handlers_unblock_by_func (G_OBJECT (dialog->store),
+      G_CALLBACK (panel_preferences_dialog_item_row_changed), dialog);
+
+  /* the position of the selected item might have changed */
+  treeview = gtk_builder_get_object (GTK_BUILDER (dialog), "item-treeview");
+  if (GTK_IS_WIDGET (treeview))
+    {
+      selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
+      panel_preferences_dialog_item_selection_changed (selection, dialog);
+    }
+}
+
+
+
+static void
+panel_preferences_dialog_item_plug_added (GtkSocket              *socket,
+                                          PanelPreferencesDialog *dialog)
+{
+  GtkTreeIter  iter;
+  gchar       *tooltip;
+
+  panel_return_if_fail (PANEL_IS_PLUGIN_EXTERNAL (socket));
+  panel_return_if_fail (PANEL_IS_PREFERENCES_DIALOG (dialog));
+
+  /* the plugin might not be on the active panel anymore */
+  if (!gtk_tree_model_get_iter_first (GTK_TREE_MODEL (dialog->store), &iter)
+      || !panel_preferences_dialog_item_store_find (dialog, socket, &iter))
+    return;
+
+  /* the plugin was (re)spawned, update the pid in the tooltip */
+  tooltip = panel_preferences_dialog_item_tooltip (socket);
+
+  g_signal_handlers_block_by_func (G_OBJECT (dialog->store),
+      G_CALLBACK (panel_preferences_dialog_item_row_changed), dialog);
+  gtk_list_store_set (dialog->store, &iter, ITEM_COLUMN_TOOLTIP, tooltip, -1);
   g_signal_handlers_unblock_by_func (G_OBJECT (dialog->store),
       G_CALLBACK (panel_preferences_dialog_item_row_changed), dialog);
+
+  g_free (tooltip);
 }
 
 
@@ -1217,8 +1338,7 @@ panel_preferences_dialog_item_move (GtkWidget              *button,
                                     PanelPreferencesDialog *dialog)
 {
   GObject                 *treeview, *object;
-  GtkTreeSelection        *selection;
-  GtkTreeIter              iter_a, iter_b;
+  GtkTreeIter              iter;
   XfcePanelPluginProvider *provider;
   GtkWidget               *itembar;
   gint                     position;
@@ -1232,21 +1352,18 @@ panel_preferences_dialog_item_move (GtkWidget              *button,
   panel_return_if_fail (GTK_IS_WIDGET (object));
   direction = G_OBJECT (button) == object ? -1 : 1;
 
-  provider = panel_preferences_dialog_item_get_selected (dialog, &iter_a);
+  provider = panel_preferences_dialog_item_get_selected (dialog, &iter);
   if (G_LIKELY (provider != NULL))
     {
       /* get the provider position on the panel */
       itembar = gtk_bin_get_child (GTK_BIN (dialog->active));
       position = panel_itembar_get_child_index (PANEL_ITEMBAR (itembar),
                                                 GTK_WIDGET (provider));
-      path = gtk_tree_model_get_path (GTK_TREE_MODEL (dialog->store), &iter_a);
 
       if (G_LIKELY (position != -1))
         {
-          /* block the changed signal */
-          g_signal_handler_block (G_OBJECT (itembar), dialog->items_changed_handler_id);
-
-          /* move the item on the panel */
+          /* move the item on the panel, the changed signal of
+           * the itembar moves the row in the list */
           panel_itembar_reorder_child (PANEL_ITEMBAR (itembar),
                                        GTK_WIDGET (provider),
                                        position + direction);
@@ -1256,43 +1373,14 @@ panel_preferences_dialog_item_move (GtkWidget              *button,
                                          dialog->active,
                                          SAVE_PLUGIN_IDS);
 
-          /* unblock the changed signal */
-          g_signal_handler_unblock (G_OBJECT (itembar), dialog->items_changed_handler_id);
-
-          /* move the item up or down in the list */
-          if (direction == 1)
-            {
-              /* swap the items in the list */
-              iter_b = iter_a;
-              if (gtk_tree_model_iter_next (GTK_TREE_MODEL (dialog->store), &iter_b))
-                {
-                  gtk_list_store_swap (dialog->store, &iter_a, &iter_b);
-                  gtk_tree_path_next (path);
-                }
-            }
-          else
-            {
-              /* get the previous item in the list */
-              if (gtk_tree_path_prev (path))
-                {
-                  /* swap the items in the list */
-                  gtk_tree_model_get_iter (GTK_TREE_MODEL (dialog->store), &iter_b, path);
-                  gtk_list_store_swap (dialog->store, &iter_a, &iter_b);
-                }
-            }
-
-          /* fake update the selection */
+          /* make the new selected position visible if moved out of area */
           treeview = gtk_builder_get_object (GTK_BUILDER (dialog), "item-treeview");
           panel_return_if_fail (GTK_IS_WIDGET (treeview));
-          selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview));
-          panel_preferences_dialog_item_selection_changed (selection, dialog);
-
-          /* make the new selected position visible if moved out of area */
+          path = gtk_tree_model_get_path (GTK_TREE_MODEL (dialog->store), &iter);
           gtk_tree_view_scroll_to_cell (GTK_TREE_VIEW (treeview), path, NULL, FALSE, 0, 0);
           gtk_tree_view_set_cursor (GTK_TREE_VIEW (treeview), path, NULL, FALSE);
-
+          gtk_tree_path_free (path);
         }
-      gtk_tree_path_free (path);
     }
 }
 
@@ -1437,12 +1525,15 @@ panel_preferences_dialog_item_row_changed (GtkTreeModel           *model,
   if (position < store_position)
     store_position--;
 
-  /* move the item on the panel */
+  /* move the item on the panel, the list is updated by the
+   * drag and drop itself */
   if (position != store_position)
     {
+      g_signal_handler_block (G_OBJECT (itembar), dialog->items_changed_handler_id);
       panel_itembar_reorder_child (PANEL_ITEMBAR (itembar),
                                    GTK_WIDGET (provider),
                                    store_position);
+      g_signal_handler_unblock (G_OBJECT (itembar), dialog->items_changed_handler_id);
 
       panel_application_save_window (dialog->application,
                                      dialog->active,
@@ -44,6 +44,7 @@
 #include <common/panel-private.h>
 #include <common/panel-debug.h>
 #include <common/panel-utils.h>
+#include <common/panel-xfconf.h>
 #include <libxfce4panel/libxfce4panel.h>
 #include <libxfce4panel/xfce-panel-plugin-provider.h>
 #include <panel/panel-base-window.h>
@@ -140,6 +141,7 @@ static void         panel_window_screen_changed                       (GtkWidget
                                                                        GdkScreen        *previous_screen);
 static void         panel_window_style_updated                        (GtkWidget        *widget);
 static void         panel_window_realize                              (GtkWidget        *widget);
+static void         panel_window_map                                  (GtkWidget        *widget);
 static StrutsEgde   panel_window_screen_struts_edge                   (PanelWindow      *window);
 static void         panel_window_screen_struts_set                    (PanelWindow      *window);
 static void         panel_window_screen_update_borders                (PanelWindow      *window);
@@ -168,6 +170,12 @@ static void         panel_window_menu_popup                           (PanelWind
                                                                        gboolean          show_tic_tac_toe);
 static void         panel_window_plugins_update                       (PanelWindow      *window,
                                                                        PluginProp        prop);
+static void         panel_window_plugins_freeze_geometry              (PanelWindow      *window,
+                                                                       gboolean          freeze);
+static void         panel_window_plugin_freeze_geometry               (GtkWidget        *widget,
+                                                                       gpointer          user_data);
+static void         panel_window_plugin_thaw_geometry                 (GtkWidget        *widget,
+                                                                       gpointer          user_data);
 static void         panel_window_plugin_set_mode                      (GtkWidget        *widget,
                                                                        gpointer          user_data);
 static void         panel_window_plugin_set_size                      (GtkWidget        *widget,
@@ -400,6 +408,7 @@ panel_window_class_init (PanelWindowClass *klass)
   gtkwidget_class->screen_changed = panel_window_screen_changed;
   gtkwidget_class->style_updated = panel_window_style_updated;
   gtkwidget_class->realize = panel_window_realize;
+  gtkwidget_class->map = panel_window_map;
 
   g_object_class_install_property (gobject_class,
                                    PROP_ID,
@@ -664,6 +673,10 @@ panel_window_set_property (GObject      *object,
 
     case PROP_MODE:
       val_mode = g_value_get_enum (value);
+
+      /* internal plugins get a single geometry-changed for the flip */
+      panel_window_plugins_freeze_geometry (window, TRUE);
+
       if (window->mode != val_mode)
         {
           window->mode = val_mode;
@@ -673,6 +686,8 @@ panel_window_set_property (GObject      *object,
       /* send the new orientation and screen position to the panel plugins */
       panel_window_plugins_update (window, PLUGIN_PROP_MODE);
       panel_window_plugins_update (window, PLUGIN_PROP_SCREEN_POSITION);
+
+      panel_window_plugins_freeze_geometry (window, FALSE);
       break;
 
     case PROP_SIZE:
@@ -779,10 +794,14 @@ panel_window_set_property (GObject      *object,
           window->base_x = MAX (x, 0);
           window->base_y = MAX (y, 0);
 
+          panel_window_plugins_freeze_geometry (window, TRUE);
+
           panel_window_screen_layout_changed (window->screen, window);
 
           /* send the new screen position to the panel plugins */
           panel_window_plugins_update (window, PLUGIN_PROP_SCREEN_POSITION);
+
+          panel_window_plugins_freeze_geometry (window, FALSE);
         }
       else
         {
@@ -1616,6 +1635,20 @@ panel_window_realize (GtkWidget *widget)
 
 
 
+static void
+panel_window_map (GtkWidget *widget)
+{
+  PanelWindow *window = PANEL_WINDOW (widget);
+
+  panel_debug_trace_begin (PANEL_DEBUG_POSITIONING, "panel-map", window->id);
+
+  (*GTK_WIDGET_CLASS (panel_window_parent_class)->map) (widget);
+
+  panel_debug_trace_end (PANEL_DEBUG_POSITIONING, "panel-map", window->id);
+}
+
+
+
 static StrutsEgde
 panel_window_screen_struts_edge (PanelWindow *window)
 {
@@ -2852,6 +2885,46 @@ panel_window_plugins_update (PanelWindow *window,
 
 
 
+static void
+panel_window_plugins_freeze_geometry (PanelWindow *window,
+                                      gboolean     freeze)
+{
+  GtkWidget *itembar;
+
+  panel_return_if_fail (PANEL_IS_WINDOW (window));
+
+  /* defer the geometry signals of the internal plugins while several
+   * properties are sent, external plugins batch them in the wrapper */
+  itembar = gtk_bin_get_child (GTK_BIN (window));
+  if (G_LIKELY (itembar != NULL))
+    gtk_container_foreach (GTK_CONTAINER (itembar),
+                           freeze ? panel_window_plugin_freeze_geometry
+                                  : panel_window_plugin_thaw_geometry,
+                           NULL);
+}
+
+
+
+static void
+panel_window_plugin_freeze_geometry (GtkWidget *widget,
+                                     gpointer   user_data)
+{
+  if (XFCE_IS_PANEL_PLUGIN (widget))
+    xfce_panel_plugin_freeze_geometry (XFCE_PANEL_PLUGIN (widget));
+}
+
+
+
+static void
+panel_window_plugin_thaw_geometry (GtkWidget *widget,
+                                   gpointer   user_data)
+{
+  if (XFCE_IS_PANEL_PLUGIN (widget))
+    xfce_panel_plugin_thaw_geometry (XFCE_PANEL_PLUGIN (widget));
+}
+
+
+
 static void
 panel_window_plugin_set_mode (GtkWidget *widget,
                               gpointer   user_data)
@@ -3054,11 +3127,18 @@ panel_window_set_povider_info (PanelWindow *window,
         }
     }
 
+  /* emit the geometry signals of internal plugins once for the batch */
+  if (XFCE_IS_PANEL_PLUGIN (provider))
+    xfce_panel_plugin_freeze_geometry (XFCE_PANEL_PLUGIN (provider));
+
   panel_window_plugin_set_mode (provider, window);
   panel_window_plugin_set_screen_position (provider, window);
   panel_window_plugin_set_size (provider, window);
   panel_window_plugin_set_icon_size (provider, window);
   panel_window_plugin_set_nrows (provider, window);
+
+  if (XFCE_IS_PANEL_PLUGIN (provider))
+    xfce_panel_plugin_thaw_geometry (XFCE_PANEL_PLUGIN (provider));
 }
 
 
@@ -3173,13 +3253,13 @@ panel_window_migrate_autohide_property (PanelWindow   *window,
   old_property = g_strdup_printf ("%s/autohide", property_base);
 
   /* check if we have an old "autohide" property for this panel */
-  if (xfconf_channel_has_property (xfconf, old_property))
+  if (panel_properties_has_property (xfconf, old_property))
     {
       new_property = g_strdup_printf ("%s/autohide-behavior", property_base);
 
       /* migrate from old "autohide" to new "autohide-behavior" if the latter
        * isn't set already */
-      if (!xfconf_channel_has_property (xfconf, new_property))
+      if (!panel_properties_has_property (xfconf, new_property))
         {
           /* find out whether or not autohide was enabled in the old config */
           autohide = xfconf_channel_get_bool (xfconf, old_property, FALSE);
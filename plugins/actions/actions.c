@@ -39,6 +39,8 @@
 
 #define DEFAULT_ICON_SIZE (16)
 #define DEFAULT_TIMEOUT   (30)
+#define PROBE_TIMEOUT     (5000)    /* ms, for each capability query */
+#define PROBE_TTL         (5 * 60)  /* seconds before the capabilities are probed again */
 
 
 
@@ -61,6 +63,7 @@ static void       actions_plugin_pack                (ActionsPlugin         *plu
 static GPtrArray *actions_plugin_default_array       (void);
 static void       actions_plugin_menu                (GtkWidget             *button,
                                                       ActionsPlugin         *plugin);
+static void       actions_plugin_actions_probe       (ActionsPlugin         *plugin);
 
 
 
@@ -103,6 +106,14 @@ struct _ActionsPlugin
   guint           invert_orientation : 1;
   guint           ask_confirmation : 1;
   guint           pack_idle_id;
+
+  /* cached capabilities of the session manager, probed async */
+  guint           allowed_types;
+  GDBusProxy     *session_proxy;
+  GCancellable   *probe_cancellable;
+  guint           probe_pending;
+  guint           probe_types;
+  gint64          probe_time;
 };
 
 typedef enum
@@ -402,6 +413,9 @@ actions_plugin_construct (XfcePanelPlugin *panel_plugin)
   /* show the properties dialog */
   xfce_panel_plugin_menu_show_configure (XFCE_PANEL_PLUGIN (plugin));
 
+  /* query the session manager in the background */
+  actions_plugin_actions_probe (plugin);
+
   /* bind all properties */
   panel_properties_bind (NULL, G_OBJECT (plugin),
                          xfce_panel_plugin_get_property_base (panel_plugin),
@@ -424,6 +438,19 @@ actions_plugin_free_data (XfcePanelPlugin *panel_plugin)
   if (plugin->pack_idle_id != 0)
     g_source_remove (plugin->pack_idle_id);
 
+  /* abort pending capability queries */
+  if (plugin->probe_cancellable != NULL)
+    {
+      g_cancellable_cancel (plugin->probe_cancellable);
+      g_object_unref (G_OBJECT (plugin->probe_cancellable));
+    }
+
+  if (plugin->session_proxy != NULL)
+    {
+      g_signal_handlers_disconnect_by_data (G_OBJECT (plugin->session_proxy), plugin);
+      g_object_unref (G_OBJECT (plugin->session_proxy));
+    }
+
   if (plugin->items != NULL)
     g_ptr_array_unref (plugin->items);
 
@@ -864,45 +891,30 @@ actions_plugin_action_dbus_xfsm (const gchar  *method,
 
 
 
-static gboolean
-actions_plugin_action_dbus_can (GDBusProxy  *proxy,
-                                const gchar *method)
+typedef struct
 {
-  GVariant *retval;
-  gboolean allowed = FALSE;
-  GError *error = NULL;
-
-  retval = g_dbus_proxy_call_sync (proxy, method,
-                                   NULL,
-                                   G_DBUS_CALL_FLAGS_NONE,
-                                   -1,
-                                   NULL,
-                                   &error);
-
-  if (G_LIKELY (retval))
-    {
-      g_variant_get (retval, "(b)", &allowed);
-      g_variant_unref (retval);
-    }
-  else if (error)
-    {
-      g_warning ("Calling %s failed %s", method, error->message);
-      g_error_free (error);
-    }
-
-  return allowed;
+  ActionsPlugin *plugin;
+  ActionType     type;
+  const gchar   *method;
 }
+ActionProbe;
+
+static const ActionProbe action_probes[] =
+{
+  { NULL, ACTION_TYPE_SHUTDOWN, "CanShutdown" },
+  { NULL, ACTION_TYPE_RESTART, "CanRestart" },
+  { NULL, ACTION_TYPE_SUSPEND, "CanSuspend" },
+  { NULL, ACTION_TYPE_HIBERNATE, "CanHibernate" },
+  { NULL, ACTION_TYPE_HYBRID_SLEEP, "CanHybridSleep" }
+};
 
 
 
 static ActionType
-actions_plugin_actions_allowed (void)
+actions_plugin_actions_allowed_local (void)
 {
-  GDBusConnection *conn;
-  ActionType       allow_mask = ACTION_TYPE_SEPARATOR;
-  gchar           *path;
-  GDBusProxy      *proxy;
-  GError          *error = NULL;
+  ActionType  allow_mask = ACTION_TYPE_SEPARATOR;
+  gchar      *path;
 
   /* check for commands we use */
   path = g_find_program_in_path ("dm-tool");
@@ -923,42 +935,222 @@ actions_plugin_actions_allowed (void)
     PANEL_SET_FLAG (allow_mask, ACTION_TYPE_LOCK_SCREEN);
   g_free (path);
 
-  /* session bus for querying the managers */
-  conn = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, &error);
-  if (conn != NULL)
+  return allow_mask;
+}
+
+
+
+static void
+actions_plugin_actions_update_sensitive (ActionsPlugin *plugin)
+{
+  GtkWidget   *child;
+  GList       *children = NULL, *li;
+  ActionEntry *entry;
+
+  child = gtk_bin_get_child (GTK_BIN (plugin));
+  if (plugin->type == APPEARANCE_TYPE_BUTTONS && GTK_IS_BOX (child))
+    children = gtk_container_get_children (GTK_CONTAINER (child));
+
+  if (plugin->menu != NULL)
+    children = g_list_concat (children,
+        gtk_container_get_children (GTK_CONTAINER (plugin->menu)));
+
+  /* update the buttons and menu items in place */
+  for (li = children; li != NULL; li = li->next)
     {
-      /* xfce4-session */
-      proxy = actions_plugin_action_dbus_proxy_session (conn);
-      if (G_LIKELY (proxy != NULL))
-        {
-          /* when xfce4-session is connected, we can logout */
-          PANEL_SET_FLAG (allow_mask, ACTION_TYPE_LOGOUT | ACTION_TYPE_LOGOUT_DIALOG);
+      entry = g_object_get_qdata (G_OBJECT (li->data), action_quark);
+      if (entry != NULL && entry->type != ACTION_TYPE_SEPARATOR)
+        gtk_widget_set_sensitive (GTK_WIDGET (li->data),
+                                  PANEL_HAS_FLAG (plugin->allowed_types, entry->type));
+    }
 
-          if (actions_plugin_action_dbus_can (proxy, "CanShutdown"))
-            PANEL_SET_FLAG (allow_mask, ACTION_TYPE_SHUTDOWN);
+  g_list_free (children);
+}
 
-          if (actions_plugin_action_dbus_can (proxy, "CanRestart"))
-            PANEL_SET_FLAG (allow_mask, ACTION_TYPE_RESTART);
 
-          if (actions_plugin_action_dbus_can (proxy, "CanSuspend"))
-            PANEL_SET_FLAG (allow_mask, ACTION_TYPE_SUSPEND);
 
-          if (actions_plugin_action_dbus_can (proxy, "CanHibernate"))
-            PANEL_SET_FLAG (allow_mask, ACTION_TYPE_HIBERNATE);
+static void
+actions_plugin_actions_probe_finished (GObject      *source_object,
+                                       GAsyncResult *res,
+                                       gpointer      user_data)
+{
+  ActionProbe   *probe = user_data;
+  ActionsPlugin *plugin;
+  GVariant      *retval;
+  gboolean       allowed = FALSE;
+  GError        *error = NULL;
+
+  retval = g_dbus_proxy_call_finish (G_DBUS_PROXY (source_object), res, &error);
+  if (retval == NULL
+      && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+      /* plugin is gone */
+      g_error_free (error);
+      g_slice_free (ActionProbe, probe);
+      return;
+    }
 
-          if (actions_plugin_action_dbus_can (proxy, "CanHybridSleep"))
-            PANEL_SET_FLAG (allow_mask, ACTION_TYPE_HYBRID_SLEEP);
+  plugin = probe->plugin;
+  panel_return_if_fail (XFCE_IS_ACTIONS_PLUGIN (plugin));
 
-          g_object_unref (G_OBJECT (proxy));
-        }
+  if (G_LIKELY (retval != NULL))
+    {
+      g_variant_get (retval, "(b)", &allowed);
+      g_variant_unref (retval);
     }
   else
     {
-      g_critical ("Unable to open DBus session bus: %s", error->message);
+      g_warning ("Calling %s failed %s", probe->method, error->message);
       g_error_free (error);
     }
 
-  return allow_mask;
+  if (allowed)
+    PANEL_SET_FLAG (plugin->probe_types, probe->type);
+
+  g_slice_free (ActionProbe, probe);
+
+  panel_return_if_fail (plugin->probe_pending > 0);
+  if (--plugin->probe_pending > 0)
+    return;
+
+  /* all queries returned, publish the new capabilities */
+  plugin->probe_time = g_get_monotonic_time ();
+  if (plugin->allowed_types != plugin->probe_types)
+    {
+      plugin->allowed_types = plugin->probe_types;
+      actions_plugin_actions_update_sensitive (plugin);
+    }
+}
+
+
+
+static void
+actions_plugin_actions_probe_proxy (ActionsPlugin *plugin)
+{
+  ActionProbe *probe;
+  guint        i;
+
+  panel_return_if_fail (G_IS_DBUS_PROXY (plugin->session_proxy));
+
+  if (plugin->probe_pending > 0)
+    return;
+
+  /* when xfce4-session is connected, we can logout */
+  plugin->probe_types = actions_plugin_actions_allowed_local ()
+                        | ACTION_TYPE_LOGOUT | ACTION_TYPE_LOGOUT_DIALOG;
+
+  /* issue all the queries at once, instead of waiting for each reply */
+  for (i = 0; i < G_N_ELEMENTS (action_probes); i++)
+    {
+      probe = g_slice_dup (ActionProbe, &action_probes[i]);
+      probe->plugin = plugin;
+      plugin->probe_pending++;
+
+      g_dbus_proxy_call (plugin->session_proxy, probe->method,
+                         NULL,
+                         G_DBUS_CALL_FLAGS_NONE,
+                         PROBE_TIMEOUT,
+                         plugin->probe_cancellable,
+                         actions_plugin_actions_probe_finished,
+                         probe);
+    }
+}
+
+
+
+static void
+actions_plugin_actions_name_owner_changed (GDBusProxy    *proxy,
+                                           GParamSpec    *pspec,
+                                           ActionsPlugin *plugin)
+{
+  gchar *name_owner;
+
+  /* the session manager was (re)started, query it again */
+  name_owner = g_dbus_proxy_get_name_owner (proxy);
+  if (name_owner != NULL)
+    actions_plugin_actions_probe_proxy (plugin);
+  g_free (name_owner);
+}
+
+
+
+static void
+actions_plugin_actions_proxy_ready (GObject      *source_object,
+                                    GAsyncResult *res,
+                                    gpointer      user_data)
+{
+  ActionsPlugin *plugin;
+  GDBusProxy    *proxy;
+  GError        *error = NULL;
+
+  proxy = g_dbus_proxy_new_for_bus_finish (res, &error);
+  if (proxy == NULL)
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          g_critical ("Unable to open DBus session bus: %s", error->message);
+
+          /* only use the local checks */
+          plugin = XFCE_ACTIONS_PLUGIN (user_data);
+          plugin->probe_time = g_get_monotonic_time ();
+        }
+
+      g_error_free (error);
+      return;
+    }
+
+  plugin = XFCE_ACTIONS_PLUGIN (user_data);
+  plugin->session_proxy = proxy;
+  g_signal_connect (G_OBJECT (proxy), "notify::g-name-owner",
+      G_CALLBACK (actions_plugin_actions_name_owner_changed), plugin);
+
+  actions_plugin_actions_probe_proxy (plugin);
+}
+
+
+
+static void
+actions_plugin_actions_probe (ActionsPlugin *plugin)
+{
+  panel_return_if_fail (XFCE_IS_ACTIONS_PLUGIN (plugin));
+
+  if (plugin->session_proxy != NULL)
+    {
+      actions_plugin_actions_probe_proxy (plugin);
+      return;
+    }
+
+  if (plugin->probe_cancellable != NULL)
+    return;
+
+  /* until the session manager replies, only allow what we can check locally */
+  plugin->allowed_types = actions_plugin_actions_allowed_local ();
+  plugin->probe_cancellable = g_cancellable_new ();
+
+  g_dbus_proxy_new_for_bus (G_BUS_TYPE_SESSION,
+                            G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES
+                            | G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS,
+                            NULL,
+                            "org.xfce.SessionManager",
+                            "/org/xfce/SessionManager",
+                            "org.xfce.Session.Manager",
+                            plugin->probe_cancellable,
+                            actions_plugin_actions_proxy_ready,
+                            plugin);
+}
+
+
+
+static ActionType
+actions_plugin_actions_allowed (ActionsPlugin *plugin)
+{
+  /* refresh the cache in the background if it is outdated, the
+   * widgets are updated when the replies arrive */
+  if (plugin->probe_time > 0
+      && g_get_monotonic_time () - plugin->probe_time > PROBE_TTL * G_USEC_PER_SEC)
+    actions_plugin_actions_probe (plugin);
+
+  return plugin->allowed_types;
 }
 
 
@@ -1171,7 +1363,7 @@ actions_plugin_pack_idle (gpointer data)
   if (plugin->items == NULL)
     plugin->items = actions_plugin_default_array ();
 
-  allowed_types = actions_plugin_actions_allowed ();
+  allowed_types = actions_plugin_actions_allowed (plugin);
 
   if (plugin->type == APPEARANCE_TYPE_BUTTONS)
     {
@@ -1346,7 +1538,7 @@ actions_plugin_menu (GtkWidget     *button,
           G_CALLBACK (actions_plugin_menu_deactivate), button);
       g_object_add_weak_pointer (G_OBJECT (plugin->menu), (gpointer) &plugin->menu);
 
-      allowed_types = actions_plugin_actions_allowed ();
+      allowed_types = actions_plugin_actions_allowed (plugin);
 
       for (i = 0; i < plugin->items->len; i++)
         {
@@ -35,6 +35,17 @@
 #define TICKS_TO_RADIANS(x)   (G_PI - (G_PI / 30.0) * (x))
 #define HOURS_TO_RADIANS(x,y) (G_PI - (G_PI / 6.0) * (((x) > 12 ? (x) - 12 : (x)) + (y) / 60.0))
 
+/* angle of a pointer that is not drawn */
+#define POINTER_HIDDEN (G_MAXDOUBLE)
+
+enum
+{
+  POINTER_SECOND,
+  POINTER_MINUTE,
+  POINTER_HOUR,
+  N_POINTERS
+};
+
 
 
 static void      xfce_clock_analog_set_property  (GObject              *object,
@@ -59,6 +70,15 @@ static void      xfce_clock_analog_draw_pointer  (cairo_t              *cr,
                                                   gdouble               angle,
                                                   gdouble               scale,
                                                   gboolean              line);
+static void      xfce_clock_analog_get_angles    (XfceClockAnalog      *analog,
+                                                  GDateTime            *time,
+                                                  gdouble              *angles);
+static void      xfce_clock_analog_pointer_area  (gdouble               xc,
+                                                  gdouble               yc,
+                                                  gdouble               radius,
+                                                  gdouble               angle,
+                                                  gdouble               scale,
+                                                  GdkRectangle         *area);
 static gboolean  xfce_clock_analog_update        (XfceClockAnalog      *analog,
                                                   ClockTime            *time);
 
@@ -86,8 +106,21 @@ struct _XfceClockAnalog
 
   guint               show_seconds : 1;
   ClockTime          *time;
+
+  /* pre-rendered tick marks for the current size and scale */
+  cairo_surface_t    *face;
+  gint                face_width;
+  gint                face_height;
+  gint                face_scale;
+
+  /* geometry and pointer angles of the last draw */
+  gdouble             xc, yc, radius;
+  gdouble             angles[N_POINTERS];
 };
 
+/* length of the second, minute and hour pointer */
+static const gdouble pointer_scales[N_POINTERS] = { 0.7, 0.8, 0.5 };
+
 
 
 XFCE_PANEL_DEFINE_TYPE (XfceClockAnalog, xfce_clock_analog, GTK_TYPE_IMAGE)
@@ -137,6 +170,8 @@ static void
 xfce_clock_analog_init (XfceClockAnalog *analog)
 {
   analog->show_seconds = FALSE;
+  analog->face = NULL;
+  analog->radius = 0.0;
 }
 
 
@@ -203,22 +238,54 @@ xfce_clock_analog_finalize (GObject *object)
   /* stop the timeout */
   clock_time_timeout_free (XFCE_CLOCK_ANALOG (object)->timeout);
 
+  if (XFCE_CLOCK_ANALOG (object)->face != NULL)
+    cairo_surface_destroy (XFCE_CLOCK_ANALOG (object)->face);
+
   (*G_OBJECT_CLASS (xfce_clock_analog_parent_class)->finalize) (object);
 }
 
 
 
+static cairo_surface_t *
+xfce_clock_analog_face_new (gint width,
+                            gint height,
+                            gint scale)
+{
+  cairo_surface_t *surface;
+  cairo_t         *cr;
+  gdouble          xc, yc;
+
+  /* render the ticks as an alpha mask, so the color is
+   * applied when painting and not part of the cache */
+  surface = cairo_image_surface_create (CAIRO_FORMAT_A8, width * scale, height * scale);
+  cairo_surface_set_device_scale (surface, scale, scale);
+
+  cr = cairo_create (surface);
+
+  xc = (width / 2.0);
+  yc = (height / 2.0);
+  xfce_clock_analog_draw_ticks (cr, xc, yc, MIN (xc, yc));
+
+  cairo_destroy (cr);
+
+  return surface;
+}
+
+
+
 static gboolean
 xfce_clock_analog_draw (GtkWidget *widget,
                         cairo_t   *cr)
 {
   XfceClockAnalog *analog = XFCE_CLOCK_ANALOG (widget);
   gdouble          xc, yc;
-  gdouble          angle, radius;
+  gdouble          radius;
   GDateTime       *time;
   GtkAllocation    allocation;
   GtkStyleContext *ctx;
   GdkRGBA          fg_rgba;
+  gint             scale;
+  guint            i;
 
   panel_return_val_if_fail (XFCE_CLOCK_IS_ANALOG (analog), FALSE);
   panel_return_val_if_fail (cr != NULL, FALSE);
@@ -238,23 +305,37 @@ xfce_clock_analog_draw (GtkWidget *widget,
   gtk_style_context_get_color (ctx, gtk_widget_get_state_flags (widget), &fg_rgba);
   gdk_cairo_set_source_rgba (cr, &fg_rgba);
 
-  /* draw the ticks */
-  xfce_clock_analog_draw_ticks (cr, xc, yc, radius);
-
-  if (analog->show_seconds)
+  /* render the ticks again when the size or scale changed */
+  scale = gtk_widget_get_scale_factor (widget);
+  if (analog->face == NULL
+      || analog->face_width != allocation.width
+      || analog->face_height != allocation.height
+      || analog->face_scale != scale)
     {
-      /* second pointer */
-      angle = TICKS_TO_RADIANS (g_date_time_get_second (time));
-      xfce_clock_analog_draw_pointer (cr, xc, yc, radius, angle, 0.7, TRUE);
+      if (analog->face != NULL)
+        cairo_surface_destroy (analog->face);
+
+      analog->face = xfce_clock_analog_face_new (allocation.width, allocation.height, scale);
+      analog->face_width = allocation.width;
+      analog->face_height = allocation.height;
+      analog->face_scale = scale;
     }
 
-  /* minute pointer */
-  angle = TICKS_TO_RADIANS (g_date_time_get_minute (time) + g_date_time_get_second (time) / 60.0);
-  xfce_clock_analog_draw_pointer (cr, xc, yc, radius, angle, 0.8, FALSE);
+  /* draw the ticks */
+  cairo_mask_surface (cr, analog->face, 0, 0);
 
-  /* hour pointer */
-  angle = HOURS_TO_RADIANS (g_date_time_get_hour (time), g_date_time_get_minute (time));
-  xfce_clock_analog_draw_pointer (cr, xc, yc, radius, angle, 0.5, FALSE);
+  /* remember the pointers so the update only redraws their area */
+  analog->xc = xc;
+  analog->yc = yc;
+  analog->radius = radius;
+  xfce_clock_analog_get_angles (analog, time, analog->angles);
+
+  for (i = 0; i < N_POINTERS; i++)
+    {
+      if (analog->angles[i] != POINTER_HIDDEN)
+        xfce_clock_analog_draw_pointer (cr, xc, yc, radius, analog->angles[i],
+                                        pointer_scales[i], i == POINTER_SECOND);
+    }
 
   /* cleanup */
   g_date_time_unref (time);
@@ -264,6 +345,26 @@ xfce_clock_analog_draw (GtkWidget *widget,
 
 
 
+static void
+xfce_clock_analog_get_angles (XfceClockAnalog *analog,
+                              GDateTime       *time,
+                              gdouble         *angles)
+{
+  /* second pointer */
+  if (analog->show_seconds)
+    angles[POINTER_SECOND] = TICKS_TO_RADIANS (g_date_time_get_second (time));
+  else
+    angles[POINTER_SECOND] = POINTER_HIDDEN;
+
+  /* minute pointer */
+  angles[POINTER_MINUTE] = TICKS_TO_RADIANS (g_date_time_get_minute (time) + g_date_time_get_second (time) / 60.0);
+
+  /* hour pointer */
+  angles[POINTER_HOUR] = HOURS_TO_RADIANS (g_date_time_get_hour (time), g_date_time_get_minute (time));
+}
+
+
+
 static void
 xfce_clock_analog_draw_ticks (cairo_t *cr,
                               gdouble  xc,
@@ -364,18 +465,80 @@ xfce_clock_analog_draw_pointer (cairo_t *cr,
 
 
 
+static void
+xfce_clock_analog_pointer_area (gdouble       xc,
+                                gdouble       yc,
+                                gdouble       radius,
+                                gdouble       angle,
+                                gdouble       scale,
+                                GdkRectangle *area)
+{
+  gdouble xt, yt;
+  gdouble rc;
+
+  /* bounding box of the center arc and the tip, with some
+   * room for the line width and antialiasing */
+  xt = xc + sin (angle) * radius * scale;
+  yt = yc + cos (angle) * radius * scale;
+  rc = radius * CLOCK_SCALE;
+
+  area->x = floor (MIN (xc - rc, xt)) - 2;
+  area->y = floor (MIN (yc - rc, yt)) - 2;
+  area->width = ceil (MAX (xc + rc, xt)) + 2 - area->x;
+  area->height = ceil (MAX (yc + rc, yt)) + 2 - area->y;
+}
+
+
+
 static gboolean
 xfce_clock_analog_update (XfceClockAnalog *analog,
                           ClockTime       *time)
 {
-  GtkWidget *widget = GTK_WIDGET (analog);
+  GtkWidget    *widget = GTK_WIDGET (analog);
+  GDateTime    *date_time;
+  gdouble       angles[N_POINTERS];
+  GdkRectangle  area;
+  guint         i;
 
   panel_return_val_if_fail (XFCE_CLOCK_IS_ANALOG (analog), FALSE);
   panel_return_val_if_fail (XFCE_IS_CLOCK_TIME (time), FALSE);
 
   /* update if the widget if visible */
-  if (G_LIKELY (gtk_widget_get_visible (widget)))
-    gtk_widget_queue_draw (widget);
+  if (G_UNLIKELY (!gtk_widget_get_visible (widget)))
+    return TRUE;
+
+  /* redraw everything if nothing was drawn yet */
+  if (analog->radius <= 0.0)
+    {
+      gtk_widget_queue_draw (widget);
+      return TRUE;
+    }
+
+  date_time = clock_time_get_time (time);
+  xfce_clock_analog_get_angles (analog, date_time, angles);
+  g_date_time_unref (date_time);
+
+  /* only redraw the old and new area of the pointers that moved,
+   * the ticks are painted from the cached face */
+  for (i = 0; i < N_POINTERS; i++)
+    {
+      if (angles[i] == analog->angles[i])
+        continue;
+
+      if (analog->angles[i] != POINTER_HIDDEN)
+        {
+          xfce_clock_analog_pointer_area (analog->xc, analog->yc, analog->radius,
+                                          analog->angles[i], pointer_scales[i], &area);
+          gtk_widget_queue_draw_area (widget, area.x, area.y, area.width, area.height);
+        }
+
+      if (angles[i] != POINTER_HIDDEN)
+        {
+          xfce_clock_analog_pointer_area (analog->xc, analog->yc, analog->radius,
+                                          angles[i], pointer_scales[i], &area);
+          gtk_widget_queue_draw_area (widget, area.x, area.y, area.width, area.height);
+        }
+    }
 
   return TRUE;
 }
@@ -31,21 +31,28 @@
 #include "clock-time.h"
 #include "clock-binary.h"
 
+/* 3 rows of 6 bits or 6 columns of 4 bits */
+#define BINARY_MAX_LEDS (24)
 
 
-static void      xfce_clock_binary_set_property  (GObject              *object,
-                                                  guint                 prop_id,
-                                                  const GValue         *value,
-                                                  GParamSpec           *pspec);
-static void      xfce_clock_binary_get_property  (GObject              *object,
-                                                  guint                 prop_id,
-                                                  GValue               *value,
-                                                  GParamSpec           *pspec);
-static void      xfce_clock_binary_finalize      (GObject              *object);
-static gboolean  xfce_clock_binary_draw          (GtkWidget            *widget,
-                                                  cairo_t              *cr);
-static gboolean  xfce_clock_binary_update        (XfceClockBinary      *binary,
-                                                  ClockTime            *time);
+
+static void      xfce_clock_binary_set_property        (GObject              *object,
+                                                        guint                 prop_id,
+                                                        const GValue         *value,
+                                                        GParamSpec           *pspec);
+static void      xfce_clock_binary_get_property        (GObject              *object,
+                                                        guint                 prop_id,
+                                                        GValue               *value,
+                                                        GParamSpec           *pspec);
+static void      xfce_clock_binary_finalize            (GObject              *object);
+static void      xfce_clock_binary_style_updated       (GtkWidget            *widget);
+static void      xfce_clock_binary_state_flags_changed (GtkWidget            *widget,
+                                                        GtkStateFlags         previous_state);
+static gboolean  xfce_clock_binary_draw                (GtkWidget            *widget,
+                                                        cairo_t              *cr);
+static void      xfce_clock_binary_background_free     (XfceClockBinary      *binary);
+static gboolean  xfce_clock_binary_update              (XfceClockBinary      *binary,
+                                                        ClockTime            *time);
 
 
 
@@ -78,6 +85,17 @@ struct _XfceClockBinary
   guint     show_grid : 1;
 
   ClockTime *time;
+
+  /* pre-rendered grid and inactive leds */
+  cairo_surface_t *background;
+  gint             background_width;
+  gint             background_height;
+  gint             background_scale;
+
+  /* led positions and active leds of the last draw */
+  GdkRectangle     leds[BINARY_MAX_LEDS];
+  guint            n_leds;
+  guint32          active;
 };
 
 
@@ -99,6 +117,8 @@ xfce_clock_binary_class_init (XfceClockBinaryClass *klass)
 
   gtkwidget_class = GTK_WIDGET_CLASS (klass);
   gtkwidget_class->draw = xfce_clock_binary_draw;
+  gtkwidget_class->style_updated = xfce_clock_binary_style_updated;
+  gtkwidget_class->state_flags_changed = xfce_clock_binary_state_flags_changed;
 
   g_object_class_install_property (gobject_class,
                                    PROP_SIZE_RATIO,
@@ -153,7 +173,9 @@ xfce_clock_binary_init (XfceClockBinary *binary)
   binary->true_binary = FALSE;
   binary->show_inactive = TRUE;
   binary->show_grid = FALSE;
-
+  binary->background = NULL;
+  binary->n_leds = 0;
+  binary->active = 0;
 }
 
 
@@ -194,6 +216,9 @@ xfce_clock_binary_set_property (GObject      *object,
       break;
     }
 
+  /* render the grid and inactive leds again */
+  xfce_clock_binary_background_free (binary);
+
   /* reschedule the timeout and resize */
   clock_time_timeout_set_interval (binary->timeout,
       binary->show_seconds ? CLOCK_INTERVAL_SECOND : CLOCK_INTERVAL_MINUTE);
@@ -251,194 +276,146 @@ xfce_clock_binary_finalize (GObject *object)
   /* stop the timeout */
   clock_time_timeout_free (XFCE_CLOCK_BINARY (object)->timeout);
 
+  xfce_clock_binary_background_free (XFCE_CLOCK_BINARY (object));
+
   (*G_OBJECT_CLASS (xfce_clock_binary_parent_class)->finalize) (object);
 }
 
 
 
 static void
-xfce_clock_binary_draw_true_binary (XfceClockBinary *binary,
-                                    cairo_t         *cr,
-                                    GtkAllocation   *alloc)
+xfce_clock_binary_style_updated (GtkWidget *widget)
 {
-  GDateTime        *time;
-  gint              row, rows;
-  static gint       binary_table[] = { 32, 16, 8, 4, 2, 1 };
-  gint              col, cols = G_N_ELEMENTS (binary_table);
-  gint              remain_h, remain_w;
-  gint              offset_x, offset_y;
-  gint              w, h, x;
-  gint              ticks;
-  GtkStyleContext  *ctx;
-  GdkRGBA           active_rgba, inactive_rgba;
+  (*GTK_WIDGET_CLASS (xfce_clock_binary_parent_class)->style_updated) (widget);
 
-  ctx = gtk_widget_get_style_context (GTK_WIDGET (gtk_widget_get_parent (GTK_WIDGET (binary))));
+  /* the colors might have changed */
+  xfce_clock_binary_background_free (XFCE_CLOCK_BINARY (widget));
+}
 
-  if (G_UNLIKELY (gtk_widget_get_state_flags (GTK_WIDGET (binary)) & GTK_STATE_FLAG_INSENSITIVE))
-    {
-      gtk_style_context_get_color (ctx, GTK_STATE_FLAG_INSENSITIVE,
-                                   &inactive_rgba);
-      inactive_rgba.alpha = 0.2;
-      gtk_style_context_get_color (ctx, GTK_STATE_FLAG_INSENSITIVE,
-                                   &active_rgba);
-      active_rgba.alpha = 1.0;
-    }
-  else
+
+
+static void
+xfce_clock_binary_state_flags_changed (GtkWidget     *widget,
+                                       GtkStateFlags  previous_state)
+{
+  (*GTK_WIDGET_CLASS (xfce_clock_binary_parent_class)->state_flags_changed) (widget, previous_state);
+
+  /* insensitive leds use other colors */
+  xfce_clock_binary_background_free (XFCE_CLOCK_BINARY (widget));
+}
+
+
+
+static void
+xfce_clock_binary_background_free (XfceClockBinary *binary)
+{
+  if (binary->background != NULL)
     {
-      gtk_style_context_get_color (ctx, GTK_STATE_FLAG_NORMAL,
-                                   &inactive_rgba);
-      inactive_rgba.alpha = 0.2;
-      gtk_style_context_get_color (ctx, GTK_STATE_FLAG_ACTIVE,
-                                   &active_rgba);
-      active_rgba.alpha = 1.0;
+      cairo_surface_destroy (binary->background);
+      binary->background = NULL;
     }
+}
 
-  time = clock_time_get_time (binary->time);
 
-  /* init sizes */
-  remain_h = alloc->height;
-  offset_y = alloc->y;
 
-  rows = binary->show_seconds ? 3 : 2;
-  for (row = 0; row < rows; row++)
-    {
-      /* get the time this row represents */
-      if (row == 0)
-        ticks = g_date_time_get_hour (time);
-      else if (row == 1)
-        ticks = g_date_time_get_minute (time);
-      else
-        ticks = g_date_time_get_second (time);
+static void
+xfce_clock_binary_get_colors (XfceClockBinary *binary,
+                              GdkRGBA         *active_rgba,
+                              GdkRGBA         *inactive_rgba)
+{
+  GtkStyleContext  *ctx;
+  GtkStateFlags     state;
 
-      /* reset sizes */
-      remain_w = alloc->width;
-      offset_x = alloc->x;
-      h = remain_h / (rows - row);
-      remain_h -= h;
+  state = gtk_widget_get_state_flags (GTK_WIDGET (binary));
 
-      for (col = 0; col < cols; col++)
-        {
-          /* update sizes */
-          w = remain_w / (cols - col);
-          x = offset_x;
-          remain_w -= w;
-          offset_x += w;
-
-          if (ticks >= binary_table[col])
-            {
-              gdk_cairo_set_source_rgba (cr, &active_rgba);
-              ticks -= binary_table[col];
-            }
-          else if (binary->show_inactive)
-            {
-              gdk_cairo_set_source_rgba (cr, &inactive_rgba);
-            }
-          else
-            {
-              continue;
-            }
+  if (binary->true_binary)
+    {
+      ctx = gtk_widget_get_style_context (GTK_WIDGET (gtk_widget_get_parent (GTK_WIDGET (binary))));
 
-          /* draw the dot */
-          cairo_rectangle (cr, x, offset_y, w - 1, h - 1);
-          cairo_fill (cr);
+      if (G_UNLIKELY (state & GTK_STATE_FLAG_INSENSITIVE))
+        {
+          gtk_style_context_get_color (ctx, GTK_STATE_FLAG_INSENSITIVE, inactive_rgba);
+          gtk_style_context_get_color (ctx, GTK_STATE_FLAG_INSENSITIVE, active_rgba);
+        }
+      else
+        {
+          gtk_style_context_get_color (ctx, GTK_STATE_FLAG_NORMAL, inactive_rgba);
+          gtk_style_context_get_color (ctx, GTK_STATE_FLAG_ACTIVE, active_rgba);
         }
+    }
+  else
+    {
+      ctx = gtk_widget_get_style_context (GTK_WIDGET (binary));
 
-      /* advance offset */
-      offset_y += h;
+      gtk_style_context_get_color (ctx, state, inactive_rgba);
+      gtk_style_context_get_color (ctx, state, active_rgba);
     }
 
-  g_date_time_unref (time);
+  inactive_rgba->alpha = 0.2;
+  active_rgba->alpha = 1.0;
 }
 
 
 
 static void
-xfce_clock_binary_draw_binary (XfceClockBinary *binary,
-                                     cairo_t         *cr,
-                                     GtkAllocation   *alloc)
+xfce_clock_binary_layout (XfceClockBinary *binary,
+                          GtkAllocation   *alloc)
 {
-  static gint       binary_table[] = { 80, 40, 20, 10, 8, 4, 2, 1 };
-  GDateTime        *time;
-  gint              row, rows = G_N_ELEMENTS (binary_table) / 2;
-  gint              col, cols;
-  gint              digit;
-  gint              remain_h, remain_w;
-  gint              offset_x, offset_y;
-  gint              w, h, y;
-  gint              ticks = 0;
-  GtkStyleContext  *ctx;
-  GdkRGBA           active_rgba, inactive_rgba;
-
-  ctx = gtk_widget_get_style_context (GTK_WIDGET (binary));
+  gint          row, rows;
+  gint          col, cols;
+  gint          remain_h, remain_w;
+  gint          offset_x, offset_y;
+  gint          w, h;
+  GdkRectangle *led;
 
-  if (G_UNLIKELY (gtk_widget_get_state_flags (GTK_WIDGET (binary)) & GTK_STATE_INSENSITIVE))
+  if (binary->true_binary)
     {
-      gtk_style_context_get_color (ctx, gtk_widget_get_state_flags (GTK_WIDGET (binary)),
-                                   &inactive_rgba);
-      inactive_rgba.alpha = 0.2;
-      gtk_style_context_get_color (ctx, gtk_widget_get_state_flags (GTK_WIDGET (binary)),
-                                   &active_rgba);
-      active_rgba.alpha = 1.0;
+      /* a row of 6 bits for the hours, minutes and seconds */
+      rows = binary->show_seconds ? 3 : 2;
+      cols = 6;
     }
   else
     {
-      gtk_style_context_get_color (ctx, gtk_widget_get_state_flags (GTK_WIDGET (binary)),
-                                   &inactive_rgba);
-      inactive_rgba.alpha = 0.2;
-      gtk_style_context_get_color (ctx, gtk_widget_get_state_flags (GTK_WIDGET (binary)),
-                                   &active_rgba);
-      active_rgba.alpha = 1.0;
+      /* a column of 4 bits for each digit */
+      rows = 4;
+      cols = binary->show_seconds ? 6 : 4;
     }
 
-  time = clock_time_get_time (binary->time);
+  binary->n_leds = rows * cols;
+  panel_assert (binary->n_leds <= BINARY_MAX_LEDS);
 
   remain_w = alloc->width;
   offset_x = alloc->x;
 
-  /* make sure the cols are all equal */
-  cols = binary->show_seconds ? 6 : 4;
   for (col = 0; col < cols; col++)
     {
-      /* get the time this row represents */
-      if (col == 0)
-        ticks = g_date_time_get_hour (time);
-      else if (col == 2)
-        ticks = g_date_time_get_minute (time);
-      else if (col == 4)
-        ticks = g_date_time_get_second (time);
+      /* update sizes */
+      w = remain_w / (cols - col);
+      remain_w -= w;
 
       /* reset sizes */
       remain_h = alloc->height;
       offset_y = alloc->y;
-      w = remain_w / (cols - col);
-      remain_w -= w;
 
       for (row = 0; row < rows; row++)
         {
           /* update sizes */
           h = remain_h / (rows - row);
           remain_h -= h;
-          y = offset_y;
-          offset_y += h;
 
-          digit = row + (4 * (col % 2));
-          if (ticks >= binary_table[digit])
-            {
-              gdk_cairo_set_source_rgba (cr, &active_rgba);
-              ticks -= binary_table[digit];
-            }
-          else if (binary->show_inactive)
-            {
-              gdk_cairo_set_source_rgba (cr, &inactive_rgba);
-            }
+          /* leds are indexed by row for the true binary
+           * clock and by column (digit) otherwise */
+          if (binary->true_binary)
+            led = &binary->leds[row * cols + col];
           else
-            {
-              continue;
-            }
+            led = &binary->leds[col * rows + row];
+
+          led->x = offset_x;
+          led->y = offset_y;
+          led->width = w - 1;
+          led->height = h - 1;
 
-          /* draw the dot */
-          cairo_rectangle (cr, offset_x, y, w - 1, h - 1);
-          cairo_fill (cr);
+          offset_y += h;
         }
 
       /* advance offset */
@@ -448,22 +425,157 @@ xfce_clock_binary_draw_binary (XfceClockBinary *binary,
 
 
 
-static gboolean
-xfce_clock_binary_draw (GtkWidget *widget,
-                        cairo_t   *cr)
+static guint32
+xfce_clock_binary_get_active (XfceClockBinary *binary,
+                              GDateTime       *time)
 {
-  XfceClockBinary  *binary = XFCE_CLOCK_BINARY (widget);
+  guint32 active = 0;
+  gint    ticks[3];
+  gint    row, rows;
+  gint    col, cols;
+  gint    digit;
+
+  ticks[0] = g_date_time_get_hour (time);
+  ticks[1] = g_date_time_get_minute (time);
+  ticks[2] = g_date_time_get_second (time);
+
+  if (binary->true_binary)
+    {
+      /* 6 bits per row, most significant bit first */
+      rows = binary->show_seconds ? 3 : 2;
+      for (row = 0; row < rows; row++)
+        for (col = 0; col < 6; col++)
+          if (ticks[row] & (32 >> col))
+            active |= 1 << (row * 6 + col);
+    }
+  else
+    {
+      /* a bcd digit per column, most significant bit first */
+      cols = binary->show_seconds ? 6 : 4;
+      for (col = 0; col < cols; col++)
+        {
+          if (col % 2 == 0)
+            digit = ticks[col / 2] / 10;
+          else
+            digit = ticks[col / 2] % 10;
+
+          for (row = 0; row < 4; row++)
+            if (digit & (8 >> row))
+              active |= 1 << (col * 4 + row);
+        }
+    }
+
+  return active;
+}
+
+
+
+static void
+xfce_clock_binary_draw_grid (XfceClockBinary *binary,
+                             cairo_t         *cr,
+                             GtkAllocation   *alloc)
+{
+  GtkWidget        *widget = GTK_WIDGET (binary);
   gint              col, cols;
   gint              row, rows;
-  GtkAllocation     alloc;
   gdouble           remain_w, x;
   gdouble           remain_h, y;
   gint              w, h;
+  GtkStyleContext  *ctx;
+  GdkRGBA           grid_rgba;
+
+  cols = binary->true_binary ? 6 : (binary->show_seconds ? 6 : 4);
+  rows = binary->true_binary ? (binary->show_seconds ? 3 : 2) : 4;
+
+  ctx = gtk_widget_get_style_context (widget);
+  gtk_style_context_get_color (ctx, gtk_widget_get_state_flags (widget),
+                               &grid_rgba);
+  grid_rgba.alpha = 0.4;
+  gdk_cairo_set_source_rgba (cr, &grid_rgba);
+  cairo_set_line_width (cr, 1);
+
+  remain_w = alloc->width;
+  remain_h = alloc->height;
+  x = alloc->x - 0.5;
+  y = alloc->y - 0.5;
+
+  cairo_rectangle (cr, x, y, alloc->width, alloc->height);
+  cairo_stroke (cr);
+
+  for (col = 0; col < cols - 1; col++)
+    {
+      w = remain_w / (cols - col);
+      x += w; remain_w -= w;
+      cairo_move_to (cr, x, alloc->y);
+      cairo_rel_line_to (cr, 0, alloc->height);
+      cairo_stroke (cr);
+    }
+
+  for (row = 0; row < rows - 1; row++)
+    {
+      h = remain_h / (rows - row);
+      y += h; remain_h -= h;
+      cairo_move_to (cr, alloc->x, y);
+      cairo_rel_line_to (cr, alloc->width, 0);
+      cairo_stroke (cr);
+    }
+}
+
+
+
+static cairo_surface_t *
+xfce_clock_binary_background_new (XfceClockBinary *binary,
+                                  GtkAllocation   *alloc,
+                                  gint             width,
+                                  gint             height)
+{
+  cairo_surface_t *surface;
+  cairo_t         *cr;
+  GdkRGBA          active_rgba, inactive_rgba;
+  guint            i;
+
+  surface = gdk_window_create_similar_surface (gtk_widget_get_window (GTK_WIDGET (binary)),
+                                               CAIRO_CONTENT_COLOR_ALPHA,
+                                               width, height);
+  cr = cairo_create (surface);
+
+  if (binary->show_grid)
+    xfce_clock_binary_draw_grid (binary, cr, alloc);
+
+  /* draw all leds inactive, the active ones are painted
+   * opaque on top of them */
+  if (binary->show_inactive)
+    {
+      xfce_clock_binary_get_colors (binary, &active_rgba, &inactive_rgba);
+      gdk_cairo_set_source_rgba (cr, &inactive_rgba);
+
+      for (i = 0; i < binary->n_leds; i++)
+        gdk_cairo_rectangle (cr, &binary->leds[i]);
+      cairo_fill (cr);
+    }
+
+  cairo_destroy (cr);
+
+  return surface;
+}
+
+
+
+static gboolean
+xfce_clock_binary_draw (GtkWidget *widget,
+                        cairo_t   *cr)
+{
+  XfceClockBinary  *binary = XFCE_CLOCK_BINARY (widget);
+  gint              cols, rows;
+  GtkAllocation     alloc;
   gint              pad_x, pad_y;
   gint              diff;
+  gint              width, height, scale;
+  guint             i;
   GtkStyleContext  *ctx;
-  GdkRGBA           grid_rgba;
   GtkBorder         padding;
+  GDateTime        *time;
+  GdkRGBA           active_rgba, inactive_rgba;
 
   panel_return_val_if_fail (XFCE_CLOCK_IS_BINARY (binary), FALSE);
   //panel_return_val_if_fail (gtk_widget_get_has_window (widget), FALSE);
@@ -475,6 +587,8 @@ xfce_clock_binary_draw (GtkWidget *widget,
   pad_y = MAX (padding.top, padding.bottom);
 
   gtk_widget_get_allocation (widget, &alloc);
+  width = alloc.width;
+  height = alloc.height;
   alloc.width -= 1 + 2 * pad_x;
   alloc.height -= 1 + 2 * pad_y;
   alloc.x = pad_x + 1;
@@ -492,45 +606,38 @@ xfce_clock_binary_draw (GtkWidget *widget,
   alloc.height -= diff;
   alloc.y += diff / 2;
 
-  if (binary->show_grid)
-    {
-      gtk_style_context_get_color (ctx, gtk_widget_get_state_flags (widget),
-                                   &grid_rgba);
-      grid_rgba.alpha = 0.4;
-      gdk_cairo_set_source_rgba (cr, &grid_rgba);
-      cairo_set_line_width (cr, 1);
-
-      remain_w = alloc.width;
-      remain_h = alloc.height;
-      x = alloc.x - 0.5;
-      y = alloc.y - 0.5;
-
-      cairo_rectangle (cr, x, y, alloc.width, alloc.height);
-      cairo_stroke (cr);
+  xfce_clock_binary_layout (binary, &alloc);
 
-      for (col = 0; col < cols - 1; col++)
-        {
-          w = remain_w / (cols - col);
-          x += w; remain_w -= w;
-          cairo_move_to (cr, x, alloc.y);
-          cairo_rel_line_to (cr, 0, alloc.height);
-          cairo_stroke (cr);
-        }
+  /* render the grid and inactive leds again when the size or scale changed */
+  scale = gtk_widget_get_scale_factor (widget);
+  if (binary->background == NULL
+      || binary->background_width != width
+      || binary->background_height != height
+      || binary->background_scale != scale)
+    {
+      xfce_clock_binary_background_free (binary);
 
-      for (row = 0; row < rows - 1; row++)
-        {
-          h = remain_h / (rows - row);
-          y += h; remain_h -= h;
-          cairo_move_to (cr, alloc.x, y);
-          cairo_rel_line_to (cr, alloc.width, 0);
-          cairo_stroke (cr);
-        }
+      binary->background = xfce_clock_binary_background_new (binary, &alloc, width, height);
+      binary->background_width = width;
+      binary->background_height = height;
+      binary->background_scale = scale;
     }
 
-  if (binary->true_binary)
-    xfce_clock_binary_draw_true_binary (binary, cr, &alloc);
-  else
-    xfce_clock_binary_draw_binary (binary, cr, &alloc);
+  cairo_set_source_surface (cr, binary->background, 0, 0);
+  cairo_paint (cr);
+
+  /* draw the active leds on top */
+  time = clock_time_get_time (binary->time);
+  binary->active = xfce_clock_binary_get_active (binary, time);
+  g_date_time_unref (time);
+
+  xfce_clock_binary_get_colors (binary, &active_rgba, &inactive_rgba);
+  gdk_cairo_set_source_rgba (cr, &active_rgba);
+
+  for (i = 0; i < binary->n_leds; i++)
+    if (binary->active & (1 << i))
+      gdk_cairo_rectangle (cr, &binary->leds[i]);
+  cairo_fill (cr);
 
   return FALSE;
 }
@@ -542,12 +649,33 @@ xfce_clock_binary_update (XfceClockBinary     *binary,
                           ClockTime           *time)
 {
   GtkWidget *widget = GTK_WIDGET (binary);
+  GDateTime *date_time;
+  guint32    changed;
+  guint      i;
 
   panel_return_val_if_fail (XFCE_CLOCK_IS_BINARY (binary), FALSE);
 
   /* update if the widget if visible */
-  if (G_LIKELY (gtk_widget_get_visible (widget)))
-    gtk_widget_queue_draw (widget);
+  if (G_UNLIKELY (!gtk_widget_get_visible (widget)))
+    return TRUE;
+
+  /* redraw everything if nothing was drawn yet */
+  if (binary->n_leds == 0)
+    {
+      gtk_widget_queue_draw (widget);
+      return TRUE;
+    }
+
+  date_time = clock_time_get_time (time);
+  changed = binary->active ^ xfce_clock_binary_get_active (binary, date_time);
+  g_date_time_unref (date_time);
+
+  /* only redraw the leds that toggled */
+  for (i = 0; i < binary->n_leds; i++)
+    if (changed & (1 << i))
+      gtk_widget_queue_draw_area (widget,
+                                  binary->leds[i].x, binary->leds[i].y,
+                                  binary->leds[i].width, binary->leds[i].height);
 
   return TRUE;
 }
@@ -64,6 +64,7 @@ struct _XfceClockDigital
   ClockTimeTimeout   *timeout;
 
   gchar *format;
+  ClockTimeFormat    *compiled;
 };
 
 
@@ -111,6 +112,7 @@ static void
 xfce_clock_digital_init (XfceClockDigital *digital)
 {
   digital->format = g_strdup (DEFAULT_DIGITAL_FORMAT);
+  digital->compiled = NULL;
 
   gtk_label_set_justify (GTK_LABEL (digital), GTK_JUSTIFY_CENTER);
 }
@@ -136,6 +138,10 @@ xfce_clock_digital_set_property (GObject      *object,
     case PROP_DIGITAL_FORMAT:
       g_free (digital->format);
       digital->format = g_value_dup_string (value);
+
+      /* parse the new format on the next update */
+      clock_time_format_free (digital->compiled);
+      digital->compiled = NULL;
       break;
 
     default:
@@ -186,6 +192,7 @@ xfce_clock_digital_finalize (GObject *object)
   clock_time_timeout_free (digital->timeout);
 
   g_free (digital->format);
+  clock_time_format_free (digital->compiled);
 
   (*G_OBJECT_CLASS (xfce_clock_digital_parent_class)->finalize) (object);
 }
@@ -196,15 +203,17 @@ static gboolean
 xfce_clock_digital_update (XfceClockDigital *digital,
                            ClockTime        *time)
 {
-  gchar            *string;
-
   panel_return_val_if_fail (XFCE_CLOCK_IS_DIGITAL (digital), FALSE);
   panel_return_val_if_fail (XFCE_IS_CLOCK_TIME (time), FALSE);
 
-  /* set time string */
-  string = clock_time_strdup_strftime (digital->time, digital->format);
-  gtk_label_set_markup (GTK_LABEL (digital), string);
-  g_free (string);
+  if (G_UNLIKELY (digital->compiled == NULL))
+    digital->compiled = clock_time_format_new (digital->format);
+
+  /* set time string, only when the text changed so the
+   * label is not laid out again on every tick */
+  if (clock_time_format_update (digital->compiled, digital->time))
+    gtk_label_set_markup (GTK_LABEL (digital),
+                          clock_time_format_get_text (digital->compiled));
 
   return TRUE;
 }
@@ -35,6 +35,31 @@
 #define RELATIVE_DIGIT (5 * RELATIVE_SPACE)
 #define RELATIVE_DOTS  (3 * RELATIVE_SPACE)
 
+/* glyphs 0-9 are the digits, followed by A, P and the dots */
+#define LCD_GLYPH_DOTS  (12)
+#define LCD_N_GLYPHS    (13)
+#define LCD_GLYPH_NONE  (-1)
+
+/* hours, 2x dots and 2 digits, meridiem */
+#define LCD_N_CELLS     (9)
+
+
+
+typedef struct
+{
+  gdouble x;
+  gdouble y;
+}
+LcdPoint;
+
+typedef struct
+{
+  gint glyph;
+  gint x;
+  gint y;
+}
+LcdCell;
+
 
 
 static void      xfce_clock_lcd_set_property (GObject           *object,
@@ -58,6 +83,13 @@ static gdouble   xfce_clock_lcd_draw_digit   (cairo_t           *cr,
                                               gdouble            size,
                                               gdouble            offset_x,
                                               gdouble            offset_y);
+static void      xfce_clock_lcd_glyphs_free  (XfceClockLcd      *lcd);
+static guint     xfce_clock_lcd_layout       (XfceClockLcd      *lcd,
+                                              GDateTime         *time,
+                                              gdouble            size,
+                                              gdouble            offset_x,
+                                              gdouble            offset_y,
+                                              LcdCell           *cells);
 static gboolean  xfce_clock_lcd_update       (XfceClockLcd      *lcd,
                                               ClockTime         *time);
 
@@ -92,14 +124,19 @@ struct _XfceClockLcd
   guint               flash_separators : 1;
 
   ClockTime          *time;
-};
 
-typedef struct
-{
-  gdouble x;
-  gdouble y;
-}
-LcdPoint;
+  /* pre-rendered glyph masks for the current size and scale */
+  cairo_surface_t    *glyphs[LCD_N_GLYPHS];
+  gdouble             glyphs_size;
+  gint                glyphs_scale;
+
+  /* glyphs drawn during the last draw, to only redraw what changed */
+  LcdCell             cells[LCD_N_CELLS];
+  guint               n_cells;
+  gdouble             cells_size;
+  gdouble             cells_offset_x;
+  gdouble             cells_offset_y;
+};
 
 
 
@@ -174,6 +211,9 @@ xfce_clock_lcd_init (XfceClockLcd *lcd)
   lcd->show_meridiem = FALSE;
   lcd->show_military = TRUE;
   lcd->flash_separators = FALSE;
+  lcd->glyphs_size = 0.0;
+  lcd->glyphs_scale = 0;
+  lcd->n_cells = 0;
 }
 
 
@@ -270,18 +310,72 @@ xfce_clock_lcd_finalize (GObject *object)
   /* stop the timeout */
   clock_time_timeout_free (XFCE_CLOCK_LCD (object)->timeout);
 
+  xfce_clock_lcd_glyphs_free (XFCE_CLOCK_LCD (object));
+
   (*G_OBJECT_CLASS (xfce_clock_lcd_parent_class)->finalize) (object);
 }
 
 
 
+static void
+xfce_clock_lcd_glyphs_free (XfceClockLcd *lcd)
+{
+  guint i;
+
+  for (i = 0; i < LCD_N_GLYPHS; i++)
+    {
+      if (lcd->glyphs[i] != NULL)
+        {
+          cairo_surface_destroy (lcd->glyphs[i]);
+          lcd->glyphs[i] = NULL;
+        }
+    }
+}
+
+
+
+static cairo_surface_t *
+xfce_clock_lcd_glyph_new (gint    glyph,
+                          gdouble size,
+                          gint    scale)
+{
+  cairo_surface_t *surface;
+  cairo_t         *cr;
+  gint             width, height;
+
+  width = ceil (size * RELATIVE_DIGIT) + 1;
+  height = ceil (size) + 1;
+
+  /* render the glyph as an alpha mask, so the color is
+   * applied when painting and not part of the cache */
+  surface = cairo_image_surface_create (CAIRO_FORMAT_A8, width * scale, height * scale);
+  cairo_surface_set_device_scale (surface, scale, scale);
+
+  cr = cairo_create (surface);
+
+  /* width of the clear line */
+  cairo_set_line_width (cr, MAX (size * 0.05, 1.5));
+
+  if (glyph == LCD_GLYPH_DOTS)
+    xfce_clock_lcd_draw_dots (cr, size, 0.00, 0.00);
+  else
+    xfce_clock_lcd_draw_digit (cr, glyph, size, 0.00, 0.00);
+
+  cairo_destroy (cr);
+
+  return surface;
+}
+
+
+
 static gboolean
 xfce_clock_lcd_draw (GtkWidget *widget,
                      cairo_t   *cr)
 {
   XfceClockLcd *lcd = XFCE_CLOCK_LCD (widget);
   gdouble       offset_x, offset_y;
-  gint          ticks, i;
+  gint          ticks, scale, glyph;
+  guint         i;
   gdouble       size;
   gdouble       ratio;
   GDateTime    *time;
@@ -312,24 +406,13 @@ xfce_clock_lcd_draw (GtkWidget *widget,
   offset_x = MAX (0.00, offset_x);
   offset_y = MAX (0.00, offset_y);
 
-  cairo_push_group (cr);
-
-  /* width of the clear line */
-  cairo_set_line_width (cr, MAX (size * 0.05, 1.5));
-
   /* get the local time */
   time = clock_time_get_time (lcd->time);
 
-  /* draw the hours */
   ticks = g_date_time_get_hour (time);
-
-  /* convert 24h clock to 12h clock */
   if (!lcd->show_military && ticks > 12)
     ticks -= 12;
 
-  if (ticks == 1 || (ticks >= 10 && ticks < 20))
-    offset_x -= size * (RELATIVE_SPACE * 4);
-
   /* queue a resize when the number of hour digits changed,
    * because we might miss the exact second (due to slightly delayed
    * timeout) we queue a resize the first 3 seconds or anything in
@@ -338,14 +421,93 @@ xfce_clock_lcd_draw (GtkWidget *widget,
       && (!lcd->show_seconds || g_date_time_get_second (time) < 3))
     g_object_notify (G_OBJECT (lcd), "size-ratio");
 
+  /* drop the cached glyphs when the size or scale changed */
+  scale = gtk_widget_get_scale_factor (widget);
+  if (lcd->glyphs_size != size || lcd->glyphs_scale != scale)
+    {
+      xfce_clock_lcd_glyphs_free (lcd);
+      lcd->glyphs_size = size;
+      lcd->glyphs_scale = scale;
+    }
+
+  /* position the glyphs */
+  lcd->cells_size = size;
+  lcd->cells_offset_x = offset_x;
+  lcd->cells_offset_y = offset_y;
+  lcd->n_cells = xfce_clock_lcd_layout (lcd, time, size, offset_x, offset_y, lcd->cells);
+
+  g_date_time_unref (time);
+
+  /* paint the glyphs, rendering them the first time they are used */
+  for (i = 0; i < lcd->n_cells; i++)
+    {
+      glyph = lcd->cells[i].glyph;
+      if (glyph == LCD_GLYPH_NONE)
+        continue;
+
+      if (lcd->glyphs[glyph] == NULL)
+        lcd->glyphs[glyph] = xfce_clock_lcd_glyph_new (glyph, size, scale);
+
+      cairo_mask_surface (cr, lcd->glyphs[glyph], lcd->cells[i].x, lcd->cells[i].y);
+    }
+
+  return FALSE;
+}
+
+
+
+static gdouble
+xfce_clock_lcd_layout_cell (LcdCell *cell,
+                            gint     glyph,
+                            gdouble  size,
+                            gdouble  offset_x,
+                            gdouble  offset_y)
+{
+  cell->glyph = glyph;
+  cell->x = rint (offset_x);
+  cell->y = rint (offset_y);
+
+  /* return the offset of the next glyph */
+  if (glyph == LCD_GLYPH_DOTS || glyph == LCD_GLYPH_NONE)
+    return (offset_x + size * RELATIVE_SPACE * 2);
+  else
+    return (offset_x + size * (RELATIVE_DIGIT + RELATIVE_SPACE));
+}
+
+
+
+static guint
+xfce_clock_lcd_layout (XfceClockLcd *lcd,
+                       GDateTime    *time,
+                       gdouble       size,
+                       gdouble       offset_x,
+                       gdouble       offset_y,
+                       LcdCell      *cells)
+{
+  guint n_cells = 0;
+  gint  ticks, i;
+  gint  glyph;
+
+  /* draw the hours */
+  ticks = g_date_time_get_hour (time);
+
+  /* convert 24h clock to 12h clock */
+  if (!lcd->show_military && ticks > 12)
+    ticks -= 12;
+
+  if (ticks == 1 || (ticks >= 10 && ticks < 20))
+    offset_x -= size * (RELATIVE_SPACE * 4);
+
   if (ticks >= 10)
     {
       /* draw the number and increase the offset */
-      offset_x = xfce_clock_lcd_draw_digit (cr, ticks >= 20 ? 2 : 1, size, offset_x, offset_y);
+      offset_x = xfce_clock_lcd_layout_cell (&cells[n_cells++], ticks >= 20 ? 2 : 1,
+                                             size, offset_x, offset_y);
     }
 
   /* draw the other number of the hour and increase the offset */
-  offset_x = xfce_clock_lcd_draw_digit (cr, ticks % 10, size, offset_x, offset_y);
+  offset_x = xfce_clock_lcd_layout_cell (&cells[n_cells++], ticks % 10,
+                                         size, offset_x, offset_y);
 
   for (i = 0; i < 2; i++)
     {
@@ -367,15 +529,19 @@ xfce_clock_lcd_draw (GtkWidget *widget,
 
       /* draw the dots */
       if (lcd->flash_separators && (g_date_time_get_second (time) % 2) == 1)
-        offset_x += size * RELATIVE_SPACE * 2;
+        glyph = LCD_GLYPH_NONE;
       else
-        offset_x = xfce_clock_lcd_draw_dots (cr, size, offset_x, offset_y);
+        glyph = LCD_GLYPH_DOTS;
+      offset_x = xfce_clock_lcd_layout_cell (&cells[n_cells++], glyph,
+                                             size, offset_x, offset_y);
 
       /* draw the first digit */
-      offset_x = xfce_clock_lcd_draw_digit (cr, (ticks - (ticks % 10)) / 10, size, offset_x, offset_y);
+      offset_x = xfce_clock_lcd_layout_cell (&cells[n_cells++], (ticks - (ticks % 10)) / 10,
+                                             size, offset_x, offset_y);
 
       /* draw the second digit */
-      offset_x = xfce_clock_lcd_draw_digit (cr, ticks % 10, size, offset_x, offset_y);
+      offset_x = xfce_clock_lcd_layout_cell (&cells[n_cells++], ticks % 10,
+                                             size, offset_x, offset_y);
     }
 
   if (lcd->show_meridiem)
@@ -384,15 +550,12 @@ xfce_clock_lcd_draw (GtkWidget *widget,
       ticks = g_date_time_get_hour (time) >= 12 ? 11 : 10;
 
       /* draw the digit */
-      offset_x = xfce_clock_lcd_draw_digit (cr, ticks, size, offset_x, offset_y);
+      xfce_clock_lcd_layout_cell (&cells[n_cells++], ticks, size, offset_x, offset_y);
     }
 
-  /* drop the pushed group */
-  g_date_time_unref (time);
-  cairo_pop_group_to_source (cr);
-  cairo_paint (cr);
+  panel_assert (n_cells <= LCD_N_CELLS);
 
-  return FALSE;
+  return n_cells;
 }
 
 
@@ -586,12 +749,49 @@ xfce_clock_lcd_update (XfceClockLcd *lcd,
                        ClockTime    *time)
 {
   GtkWidget *widget = GTK_WIDGET (lcd);
+  GDateTime *date_time;
+  LcdCell    cells[LCD_N_CELLS];
+  guint      n_cells, i;
+  gint       width, height;
 
   panel_return_val_if_fail (XFCE_CLOCK_IS_LCD (lcd), FALSE);
 
   /* update if the widget if visible */
-  if (G_LIKELY (gtk_widget_get_visible (widget)))
-    gtk_widget_queue_draw (widget);
+  if (G_UNLIKELY (!gtk_widget_get_visible (widget)))
+    return TRUE;
+
+  if (lcd->n_cells > 0)
+    {
+      date_time = clock_time_get_time (time);
+      n_cells = xfce_clock_lcd_layout (lcd, date_time, lcd->cells_size,
+                                       lcd->cells_offset_x, lcd->cells_offset_y,
+                                       cells);
+      g_date_time_unref (date_time);
+
+      /* if the glyphs are at the same positions, only redraw
+       * the ones that changed since the last draw */
+      if (n_cells == lcd->n_cells)
+        {
+          for (i = 0; i < n_cells; i++)
+            if (cells[i].x != lcd->cells[i].x)
+              break;
+
+          if (i == n_cells)
+            {
+              width = ceil (lcd->cells_size * RELATIVE_DIGIT) + 1;
+              height = ceil (lcd->cells_size) + 1;
+
+              for (i = 0; i < n_cells; i++)
+                if (cells[i].glyph != lcd->cells[i].glyph)
+                  gtk_widget_queue_draw_area (widget, cells[i].x, cells[i].y,
+                                              width, height);
+
+              return TRUE;
+            }
+        }
+    }
+
+  gtk_widget_queue_draw (widget);
 
   return TRUE;
 }
@@ -17,25 +17,46 @@
  */
 
 
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
 #include <glib.h>
 
 #include "clock-time.h"
 #include "clock.h"
 
-static void                 clock_time_finalize       (GObject          *object);
-static void                 clock_time_get_property   (GObject          *object,
-                                                       guint             prop_id,
-                                                       GValue           *value,
-                                                       GParamSpec       *pspec);
-static void                 clock_time_set_property   (GObject          *object,
-                                                       guint             prop_id,
-                                                       const GValue     *value,
-                                                       GParamSpec       *pspec);
+
+
+typedef struct _ClockTimeZone ClockTimeZone;
+
+
+
+static void                 clock_time_finalize         (GObject          *object);
+static void                 clock_time_get_property     (GObject          *object,
+                                                         guint             prop_id,
+                                                         GValue           *value,
+                                                         GParamSpec       *pspec);
+static void                 clock_time_set_property     (GObject          *object,
+                                                         guint             prop_id,
+                                                         const GValue     *value,
+                                                         GParamSpec       *pspec);
+static ClockTimeZone       *clock_time_zone_get         (const gchar      *name);
+static void                 clock_time_zone_release     (ClockTimeZone    *zone);
+static void                 clock_time_timeout_schedule (ClockTimeTimeout *timeout);
 
 
 
 #define DEFAULT_TIMEZONE ""
 
+/* longest single wakeup, the main loop timers do not advance
+ * while the system is suspended */
+#define MAX_WAKEUP_DELAY (15 * 60)
+
 enum
 {
   PROP_0,
@@ -52,16 +73,63 @@ struct _ClockTime
   GObject             __parent__;
 
   gchar              *timezone_name;
+  ClockTimeZone      *zone;
+
+  /* running timeouts, stopped while suspended */
+  GSList             *timeouts;
+  guint               suspended : 1;
+};
+
+struct _ClockTimeFormat
+{
+  /* parsed format */
+  GArray             *items;
+  guint               interval;
+
+  /* text of the last render and the buffer for the next one */
+  GString            *text;
+  GString            *scratch;
+
+  /* timezone, utc offset and interval of the last render */
+  gchar              *timezone_name;
+  gint64              utc_offset;
+  gint64              stamp;
+};
+
+typedef struct
+{
+  /* conversion rendered natively, 0 for literal text
+   * and FORMAT_ITEM_GLIB for anything else */
+  gchar               conversion;
+
+  /* the literal text or the glib specifier */
+  gchar              *text;
+}
+ClockTimeFormatItem;
+
+#define FORMAT_ITEM_GLIB '*'
+
+struct _ClockTimeZone
+{
+  gchar              *name;
   GTimeZone          *timezone;
+  guint               ref_count;
+
+  /* date time shared by all clocks in this timezone
+   * during the current second */
+  GDateTime          *date_time;
+  gint64              date_time_second;
 };
 
 struct _ClockTimeTimeout
 {
   guint       interval;
   guint       timeout_id;
-  guint       restart : 1;
   ClockTime  *time;
   guint       time_changed_id;
+
+  /* unix time of the next change of the visible fields */
+  gint64      next_change;
 };
 
 enum
@@ -72,6 +140,9 @@ enum
 
 static guint clock_time_signals[LAST_SIGNAL] = { 0, };
 
+/* process-wide registry of timezones used by the clocks */
+static GHashTable *clock_time_zones = NULL;
+
 
 XFCE_PANEL_DEFINE_TYPE (ClockTime, clock_time, G_TYPE_OBJECT)
 
@@ -109,7 +180,9 @@ static void
 clock_time_init (ClockTime *time)
 {
   time->timezone_name = g_strdup (DEFAULT_TIMEZONE);
-  time->timezone = NULL;
+  time->zone = clock_time_zone_get (DEFAULT_TIMEZONE);
+  time->timeouts = NULL;
+  time->suspended = FALSE;
 }
 
 
@@ -121,8 +194,7 @@ clock_time_finalize (GObject *object)
 
   g_free (time->timezone_name);
 
-  if (time->timezone != NULL)
-    g_time_zone_unref (time->timezone);
+  clock_time_zone_release (time->zone);
 
   G_OBJECT_CLASS (clock_time_parent_class)->finalize (object);
 }
@@ -167,18 +239,13 @@ clock_time_set_property (GObject      *object,
       if (g_strcmp0 (time->timezone_name, str_value) != 0)
         {
           g_free (time->timezone_name);
-          if (time->timezone != NULL)
-            g_time_zone_unref (time->timezone);
           if (str_value == NULL || g_strcmp0 (str_value, "") == 0)
-            {
-              time->timezone_name = g_strdup (DEFAULT_TIMEZONE);
-              time->timezone = NULL;
-            }
+            time->timezone_name = g_strdup (DEFAULT_TIMEZONE);
           else
-            {
-              time->timezone_name = g_strdup (str_value);
-              time->timezone = g_time_zone_new (str_value);
-            }
+            time->timezone_name = g_strdup (str_value);
+
+          clock_time_zone_release (time->zone);
+          time->zone = clock_time_zone_get (time->timezone_name);
 
           g_signal_emit (G_OBJECT (time), clock_time_signals[TIME_CHANGED], 0);
         }
@@ -192,19 +259,86 @@ clock_time_set_property (GObject      *object,
 
 
 
+static ClockTimeZone *
+clock_time_zone_get (const gchar *name)
+{
+  ClockTimeZone *zone;
+
+  if (clock_time_zones == NULL)
+    clock_time_zones = g_hash_table_new (g_str_hash, g_str_equal);
+
+  zone = g_hash_table_lookup (clock_time_zones, name);
+  if (zone == NULL)
+    {
+      zone = g_slice_new0 (ClockTimeZone);
+      zone->name = g_strdup (name);
+      zone->timezone = panel_str_is_empty (name) ? NULL : g_time_zone_new (name);
+      zone->date_time = NULL;
+      zone->date_time_second = -1;
+
+      g_hash_table_insert (clock_time_zones, zone->name, zone);
+    }
+
+  zone->ref_count++;
+
+  return zone;
+}
+
+
+
+static void
+clock_time_zone_release (ClockTimeZone *zone)
+{
+  panel_return_if_fail (zone != NULL);
+  panel_return_if_fail (zone->ref_count > 0);
+
+  if (--zone->ref_count > 0)
+    return;
+
+  g_hash_table_remove (clock_time_zones, zone->name);
+  if (g_hash_table_size (clock_time_zones) == 0)
+    {
+      g_hash_table_destroy (clock_time_zones);
+      clock_time_zones = NULL;
+    }
+
+  if (zone->timezone != NULL)
+    g_time_zone_unref (zone->timezone);
+  if (zone->date_time != NULL)
+    g_date_time_unref (zone->date_time);
+  g_free (zone->name);
+
+  g_slice_free (ClockTimeZone, zone);
+}
+
+
+
 GDateTime *
 clock_time_get_time (ClockTime *time)
 {
-  GDateTime *date_time;
+  ClockTimeZone *zone;
 
   panel_return_val_if_fail (XFCE_IS_CLOCK_TIME (time), NULL);
 
-  if (time->timezone != NULL)
-    date_time = g_date_time_new_now (time->timezone);
-  else
-    date_time = g_date_time_new_now_local ();
+  zone = time->zone;
+
+  /* all clocks in the same timezone ticking in the same second
+   * share one date time, so it is only created once per tick */
+  if (zone->date_time == NULL
+      || zone->date_time_second != g_get_real_time () / G_USEC_PER_SEC)
+    {
+      if (zone->date_time != NULL)
+        g_date_time_unref (zone->date_time);
+
+      if (zone->timezone != NULL)
+        zone->date_time = g_date_time_new_now (zone->timezone);
+      else
+        zone->date_time = g_date_time_new_now_local ();
+
+      zone->date_time_second = g_date_time_to_unix (zone->date_time);
+    }
 
-  return date_time;
+  return g_date_time_ref (zone->date_time);
 }
 
 
@@ -237,15 +371,20 @@ guint
 clock_time_interval_from_format (const gchar *format)
 {
   const gchar *p;
+  guint        interval = CLOCK_INTERVAL_DAY;
 
   if (G_UNLIKELY (panel_str_is_empty (format)))
       return CLOCK_INTERVAL_MINUTE;
 
+  /* the interval of the fastest changing field in the format */
   for (p = format; *p != '\0'; ++p)
     {
       if (p[0] == '%' && p[1] != '\0')
         {
-          switch (*++p)
+          /* skip the flags and modifiers */
+          for (++p; strchr ("_-0^#EO:", *p) != NULL && p[1] != '\0'; ++p);
+
+          switch (*p)
             {
             case 'c':
             case 'N':
@@ -255,67 +394,446 @@ clock_time_interval_from_format (const gchar *format)
             case 'T':
             case 'X':
               return CLOCK_INTERVAL_SECOND;
+
+            case 'M':
+            case 'R':
+              interval = MIN (interval, CLOCK_INTERVAL_MINUTE);
+              break;
+
+            case 'H':
+            case 'I':
+            case 'k':
+            case 'l':
+            case 'p':
+            case 'P':
+              interval = MIN (interval, CLOCK_INTERVAL_HOUR);
+              break;
+
+            case 'a':
+            case 'A':
+            case 'b':
+            case 'B':
+            case 'C':
+            case 'd':
+            case 'D':
+            case 'e':
+            case 'F':
+            case 'g':
+            case 'G':
+            case 'h':
+            case 'j':
+            case 'm':
+            case 'u':
+            case 'U':
+            case 'V':
+            case 'w':
+            case 'W':
+            case 'x':
+            case 'y':
+            case 'Y':
+            case 'z':
+            case 'Z':
+            case '%':
+              /* changes once a day or on a timezone transition */
+              break;
+
+            default:
+              /* unknown, stay on the safe side */
+              interval = MIN (interval, CLOCK_INTERVAL_MINUTE);
+              break;
             }
         }
     }
 
-  return CLOCK_INTERVAL_MINUTE;
+  return interval;
+}
+
+
+
+static void
+clock_time_format_add_item (ClockTimeFormat *format,
+                            gchar            conversion,
+                            const gchar     *text,
+                            gsize            len)
+{
+  ClockTimeFormatItem item;
+
+  item.conversion = conversion;
+  item.text = text != NULL ? g_strndup (text, len) : NULL;
+
+  g_array_append_val (format->items, item);
+}
+
+
+
+ClockTimeFormat *
+clock_time_format_new (const gchar *format)
+{
+  ClockTimeFormat *compiled;
+  GString         *literal;
+  const gchar     *p, *start;
+
+  compiled = g_slice_new0 (ClockTimeFormat);
+  compiled->items = g_array_new (FALSE, FALSE, sizeof (ClockTimeFormatItem));
+  compiled->interval = clock_time_interval_from_format (format);
+  compiled->text = g_string_new (NULL);
+  compiled->scratch = g_string_new (NULL);
+  compiled->timezone_name = NULL;
+  compiled->stamp = -1;
+
+  if (G_UNLIKELY (format == NULL))
+    return compiled;
+
+  /* split the format once in literal text and conversions, so
+   * rendering does not have to parse it again on every tick */
+  literal = g_string_new (NULL);
+  for (p = format; *p != '\0'; ++p)
+    {
+      if (p[0] != '%' || p[1] == '\0')
+        {
+          g_string_append_c (literal, *p);
+          continue;
+        }
+
+      start = p++;
+
+      /* skip the flags and modifiers */
+      while (strchr ("_-0^#EO:", *p) != NULL && p[1] != '\0')
+        p++;
+
+      if (*p == '%' && p == start + 1)
+        {
+          g_string_append_c (literal, '%');
+          continue;
+        }
+
+      if (literal->len > 0)
+        {
+          clock_time_format_add_item (compiled, 0, literal->str, literal->len);
+          g_string_truncate (literal, 0);
+        }
+
+      /* plain numeric conversions are rendered natively, the
+       * rest is left to glib (names are locale dependent) */
+      if (p == start + 1 && strchr ("HIMSdmYy", *p) != NULL)
+        clock_time_format_add_item (compiled, *p, NULL, 0);
+      else
+        clock_time_format_add_item (compiled, FORMAT_ITEM_GLIB, start, p - start + 1);
+    }
+
+  if (literal->len > 0)
+    clock_time_format_add_item (compiled, 0, literal->str, literal->len);
+  g_string_free (literal, TRUE);
+
+  return compiled;
+}
+
+
+
+void
+clock_time_format_free (ClockTimeFormat *format)
+{
+  ClockTimeFormatItem *item;
+  guint                i;
+
+  if (format == NULL)
+    return;
+
+  for (i = 0; i < format->items->len; i++)
+    {
+      item = &g_array_index (format->items, ClockTimeFormatItem, i);
+      g_free (item->text);
+    }
+
+  g_array_free (format->items, TRUE);
+  g_string_free (format->text, TRUE);
+  g_string_free (format->scratch, TRUE);
+  g_free (format->timezone_name);
+
+  g_slice_free (ClockTimeFormat, format);
 }
 
 
 
 static gboolean
-clock_time_timeout_running (gpointer user_data)
+clock_time_format_render (ClockTimeFormat *format,
+                          GDateTime       *date_time,
+                          GString         *buffer)
 {
-  ClockTimeTimeout *timeout = user_data;
-  GDateTime        *time;
+  ClockTimeFormatItem *item;
+  guint                i;
+  gint                 hour;
+  gchar               *str;
 
-  g_signal_emit (G_OBJECT (timeout->time), clock_time_signals[TIME_CHANGED], 0);
+  g_string_truncate (buffer, 0);
+
+  for (i = 0; i < format->items->len; i++)
+    {
+      item = &g_array_index (format->items, ClockTimeFormatItem, i);
+      switch (item->conversion)
+        {
+        case 0:
+          g_string_append (buffer, item->text);
+          break;
+
+        case 'H':
+          g_string_append_printf (buffer, "%02d", g_date_time_get_hour (date_time));
+          break;
+
+        case 'I':
+          hour = g_date_time_get_hour (date_time) % 12;
+          g_string_append_printf (buffer, "%02d", hour == 0 ? 12 : hour);
+          break;
+
+        case 'M':
+          g_string_append_printf (buffer, "%02d", g_date_time_get_minute (date_time));
+          break;
+
+        case 'S':
+          g_string_append_printf (buffer, "%02d", g_date_time_get_second (date_time));
+          break;
+
+        case 'd':
+          g_string_append_printf (buffer, "%02d", g_date_time_get_day_of_month (date_time));
+          break;
+
+        case 'm':
+          g_string_append_printf (buffer, "%02d", g_date_time_get_month (date_time));
+          break;
+
+        case 'Y':
+          g_string_append_printf (buffer, "%d", g_date_time_get_year (date_time));
+          break;
+
+        case 'y':
+          g_string_append_printf (buffer, "%02d", g_date_time_get_year (date_time) % 100);
+          break;
+
+        default:
+          str = g_date_time_format (date_time, item->text);
+
+          /* a failing specifier fails the whole format, like
+           * clock_time_strdup_strftime() */
+          if (G_UNLIKELY (str == NULL))
+            {
+              g_string_truncate (buffer, 0);
+              return FALSE;
+            }
 
-  /* check if the timeout still runs in time if updating once a minute */
-  if (timeout->interval == CLOCK_INTERVAL_MINUTE)
+          g_string_append (buffer, str);
+          g_free (str);
+          break;
+        }
+    }
+
+  return TRUE;
+}
+
+
+
+/* renders the format for the current time, returns whether
+ * the text differs from the previous update */
+gboolean
+clock_time_format_update (ClockTimeFormat *format,
+                          ClockTime       *time)
+{
+  GDateTime *date_time;
+  gint64     stamp;
+  gint64     utc_offset;
+  gboolean   first;
+  GString   *tmp;
+
+  panel_return_val_if_fail (format != NULL, FALSE);
+  panel_return_val_if_fail (XFCE_IS_CLOCK_TIME (time), FALSE);
+
+  date_time = clock_time_get_time (time);
+
+  /* nothing to do when still in the same interval of the same
+   * timezone, the visible fields did not change */
+  utc_offset = g_date_time_get_utc_offset (date_time) / G_USEC_PER_SEC;
+  stamp = (g_date_time_to_unix (date_time) + utc_offset) / format->interval;
+
+  first = (format->timezone_name == NULL);
+  if (!first
+      && format->stamp == stamp
+      && format->utc_offset == utc_offset
+      && g_strcmp0 (format->timezone_name, time->timezone_name) == 0)
+    {
+      g_date_time_unref (date_time);
+      return FALSE;
+    }
+
+  format->stamp = stamp;
+  format->utc_offset = utc_offset;
+  if (g_strcmp0 (format->timezone_name, time->timezone_name) != 0)
     {
-      /* sync again when we don't run on time */
-      time = clock_time_get_time (timeout->time);
-      timeout->restart = (g_date_time_get_second (time) != 0);
+      g_free (format->timezone_name);
+      format->timezone_name = g_strdup (time->timezone_name);
     }
 
-  return !timeout->restart;
+  clock_time_format_render (format, date_time, format->scratch);
+  g_date_time_unref (date_time);
+
+  if (!first && g_string_equal (format->scratch, format->text))
+    return FALSE;
+
+  /* keep the new text, the old buffer is reused next time */
+  tmp = format->text;
+  format->text = format->scratch;
+  format->scratch = tmp;
+
+  return TRUE;
 }
 
 
 
-static void
-clock_time_timeout_destroyed (gpointer user_data)
+const gchar *
+clock_time_format_get_text (ClockTimeFormat *format)
 {
-  ClockTimeTimeout *timeout = user_data;
+  panel_return_val_if_fail (format != NULL, NULL);
 
-  timeout->timeout_id = 0;
+  return format->text->str;
+}
+
+
+
+static gint64
+clock_time_get_utc_offset (ClockTime *time,
+                           gint64     unix_time)
+{
+  GDateTime *utc, *date_time;
+  gint64     utc_offset;
 
-  if (G_UNLIKELY (timeout->restart))
-    clock_time_timeout_set_interval (timeout, timeout->interval);
+  if (time->zone->timezone != NULL)
+    {
+      utc = g_date_time_new_from_unix_utc (unix_time);
+      date_time = g_date_time_to_timezone (utc, time->zone->timezone);
+      g_date_time_unref (utc);
+    }
+  else
+    {
+      date_time = g_date_time_new_from_unix_local (unix_time);
+    }
+
+  utc_offset = g_date_time_get_utc_offset (date_time) / G_USEC_PER_SEC;
+  g_date_time_unref (date_time);
+
+  return utc_offset;
+}
+
+
+
+/* the unix time at which the fields changing every interval
+ * seconds get a new value, in the timezone of time */
+static gint64
+clock_time_get_next_change (ClockTime *time,
+                            guint      interval)
+{
+  GDateTime *date_time;
+  gint64     now, next, utc_offset;
+  gint64     low, high, mid;
+
+  date_time = clock_time_get_time (time);
+  now = g_date_time_to_unix (date_time);
+  utc_offset = g_date_time_get_utc_offset (date_time) / G_USEC_PER_SEC;
+  g_date_time_unref (date_time);
+
+  /* next interval boundary in local time */
+  next = ((now + utc_offset) / interval + 1) * interval - utc_offset;
+
+  /* the fields also change on a timezone transition (dst) before
+   * that boundary, look for the first second in the new offset */
+  if (interval > CLOCK_INTERVAL_MINUTE
+      && clock_time_get_utc_offset (time, next) != utc_offset)
+    {
+      low = now;
+      high = next;
+      while (high - low > 1)
+        {
+          mid = low + (high - low) / 2;
+          if (clock_time_get_utc_offset (time, mid) == utc_offset)
+            low = mid;
+          else
+            high = mid;
+        }
+
+      next = high;
+    }
+
+  return next;
 }
 
 
 
 static gboolean
-clock_time_timeout_sync (gpointer user_data)
+clock_time_timeout_running (gpointer user_data)
 {
   ClockTimeTimeout *timeout = user_data;
 
   g_signal_emit (G_OBJECT (timeout->time), clock_time_signals[TIME_CHANGED], 0);
 
-  /* start the real timeout */
-  timeout->timeout_id = g_timeout_add_seconds_full (G_PRIORITY_DEFAULT, timeout->interval,
-                                                    clock_time_timeout_running, timeout,
-                                                    clock_time_timeout_destroyed);
+  return TRUE;
+}
+
+
+
+static gboolean
+clock_time_timeout_wakeup (gpointer user_data)
+{
+  ClockTimeTimeout *timeout = user_data;
+
+  timeout->timeout_id = 0;
+
+  /* only notify when the change is due, not for intermediate
+   * wakeups of long delays */
+  if (g_get_real_time () >= timeout->next_change * G_USEC_PER_SEC)
+    g_signal_emit (G_OBJECT (timeout->time), clock_time_signals[TIME_CHANGED], 0);
+
+  /* schedule the next wakeup, unless a handler did that already */
+  if (timeout->timeout_id == 0)
+    clock_time_timeout_schedule (timeout);
 
-  /* stop the sync timeout */
   return FALSE;
 }
 
 
 
+static void
+clock_time_timeout_schedule (ClockTimeTimeout *timeout)
+{
+  gint64 delay;
+
+  panel_return_if_fail (timeout != NULL);
+
+  /* stop running timeout */
+  if (G_LIKELY (timeout->timeout_id != 0))
+    g_source_remove (timeout->timeout_id);
+  timeout->timeout_id = 0;
+
+  if (timeout->time->suspended)
+    return;
+
+  if (timeout->interval == CLOCK_INTERVAL_SECOND)
+    {
+      timeout->timeout_id = g_timeout_add_seconds_full (G_PRIORITY_DEFAULT, CLOCK_INTERVAL_SECOND,
+                                                        clock_time_timeout_running,
+                                                        timeout, NULL);
+    }
+  else
+    {
+      /* single wakeup just after the instant the fields change */
+      timeout->next_change = clock_time_get_next_change (timeout->time, timeout->interval);
+      delay = (timeout->next_change * G_USEC_PER_SEC - g_get_real_time ()) / 1000 + 1;
+      delay = CLAMP (delay, 1, MAX_WAKEUP_DELAY * 1000);
+
+      timeout->timeout_id = g_timeout_add_full (G_PRIORITY_DEFAULT, delay,
+                                                clock_time_timeout_wakeup,
+                                                timeout, NULL);
+    }
+}
+
+
+
 ClockTimeTimeout *
 clock_time_timeout_new (guint       interval,
                         ClockTime  *time,
@@ -331,7 +849,6 @@ clock_time_timeout_new (guint       interval,
   timeout = g_slice_new0 (ClockTimeTimeout);
   timeout->interval = 0;
   timeout->timeout_id = 0;
-  timeout->restart = FALSE;
   timeout->time = time;
 
   timeout->time_changed_id =
@@ -340,6 +857,8 @@ clock_time_timeout_new (guint       interval,
 
   g_object_ref (G_OBJECT (timeout->time));
 
+  time->timeouts = g_slist_prepend (time->timeouts, timeout);
+
   clock_time_timeout_set_interval (timeout, interval);
 
   return timeout;
@@ -351,55 +870,18 @@ void
 clock_time_timeout_set_interval (ClockTimeTimeout *timeout,
                                  guint             interval)
 {
-  GDateTime *time;
-  guint      next_interval;
-  gboolean   restart;
-
   panel_return_if_fail (timeout != NULL);
   panel_return_if_fail (interval > 0);
 
-  restart = timeout->restart;
-
-  /* leave if nothing changed and we're not restarting */
-  if (!restart && timeout->interval == interval)
+  /* leave if nothing changed */
+  if (timeout->interval == interval)
     return;
   timeout->interval = interval;
-  timeout->restart = FALSE;
-
-  /* stop running timeout */
-  if (G_LIKELY (timeout->timeout_id != 0))
-    g_source_remove (timeout->timeout_id);
-  timeout->timeout_id = 0;
 
-  /* run function when not restarting */
-  if (!restart)
-    g_signal_emit (G_OBJECT (timeout->time), clock_time_signals[TIME_CHANGED], 0);
-
-  /* get the seconds to the next internal */
-  if (interval == CLOCK_INTERVAL_MINUTE)
-    {
-      time = clock_time_get_time (timeout->time);
-      next_interval = 60 - g_date_time_get_second (time);
-    }
-  else
-    {
-      next_interval = 0;
-    }
+  /* run function */
+  g_signal_emit (G_OBJECT (timeout->time), clock_time_signals[TIME_CHANGED], 0);
 
-  if (next_interval > 0)
-    {
-      /* start the sync timeout */
-      timeout->timeout_id = g_timeout_add_seconds_full (G_PRIORITY_DEFAULT, next_interval,
-                                                        clock_time_timeout_sync,
-                                                        timeout, NULL);
-    }
-  else
-    {
-      /* directly start running the normal timeout */
-      timeout->timeout_id = g_timeout_add_seconds_full (G_PRIORITY_DEFAULT, interval,
-                                                        clock_time_timeout_running, timeout,
-                                                        clock_time_timeout_destroyed);
-    }
+  clock_time_timeout_schedule (timeout);
 }
 
 
@@ -409,11 +891,11 @@ clock_time_timeout_free (ClockTimeTimeout *timeout)
 {
   panel_return_if_fail (timeout != NULL);
 
-  timeout->restart = FALSE;
-
   if (timeout->time != NULL && timeout->time_changed_id != 0)
     g_signal_handler_disconnect (timeout->time, timeout->time_changed_id);
 
+  timeout->time->timeouts = g_slist_remove (timeout->time->timeouts, timeout);
+
   g_object_unref (G_OBJECT (timeout->time));
 
   if (G_LIKELY (timeout->timeout_id != 0))
@@ -423,6 +905,29 @@ clock_time_timeout_free (ClockTimeTimeout *timeout)
 
 
 
+/* stops all timeouts while nothing of the clock is visible */
+void
+clock_time_set_suspended (ClockTime *time,
+                          gboolean   suspended)
+{
+  GSList *li;
+
+  panel_return_if_fail (XFCE_IS_CLOCK_TIME (time));
+
+  if (time->suspended == !!suspended)
+    return;
+  time->suspended = !!suspended;
+
+  /* bring the clocks up-to-date when they become visible again */
+  if (!suspended)
+    g_signal_emit (G_OBJECT (time), clock_time_signals[TIME_CHANGED], 0);
+
+  for (li = time->timeouts; li != NULL; li = li->next)
+    clock_time_timeout_schedule (li->data);
+}
+
+
+
 ClockTime *
 clock_time_new (void)
 {
@@ -27,10 +27,13 @@ G_BEGIN_DECLS
 
 #define CLOCK_INTERVAL_SECOND (1)
 #define CLOCK_INTERVAL_MINUTE (60)
+#define CLOCK_INTERVAL_HOUR   (60 * 60)
+#define CLOCK_INTERVAL_DAY    (24 * 60 * 60)
 
 typedef struct _ClockTime          ClockTime;
 typedef struct _ClockTimeClass     ClockTimeClass;
 typedef struct _ClockTimeTimeout   ClockTimeTimeout;
+typedef struct _ClockTimeFormat    ClockTimeFormat;
 
 #define XFCE_TYPE_CLOCK_TIME              (clock_time_get_type ())
 #define XFCE_CLOCK_TIME(obj)              (G_TYPE_CHECK_INSTANCE_CAST ((obj), XFCE_TYPE_CLOCK_TIME, ClockTime))
@@ -57,6 +60,9 @@ void                clock_time_timeout_set_interval   (ClockTimeTimeout    *time
 
 void                clock_time_timeout_free           (ClockTimeTimeout    *timeout);
 
+void                clock_time_set_suspended          (ClockTime           *time,
+                                                       gboolean             suspended);
+
 GDateTime          *clock_time_get_time               (ClockTime           *time);
 
 gchar              *clock_time_strdup_strftime        (ClockTime           *time,
@@ -64,6 +70,15 @@ gchar              *clock_time_strdup_strftime        (ClockTime           *time
 
 guint               clock_time_interval_from_format   (const gchar         *format);
 
+ClockTimeFormat    *clock_time_format_new             (const gchar         *format);
+
+void                clock_time_format_free            (ClockTimeFormat     *format);
+
+gboolean            clock_time_format_update          (ClockTimeFormat     *format,
+                                                       ClockTime           *time);
+
+const gchar        *clock_time_format_get_text        (ClockTimeFormat     *format);
+
 G_END_DECLS
 
 #endif /* !__CLOCK_TIME_H__ */
@@ -72,6 +72,10 @@ static gboolean clock_plugin_enter_notify_event        (GtkWidget             *w
 static gboolean clock_plugin_button_press_event        (GtkWidget             *widget,
                                                         GdkEventButton        *event,
                                                         ClockPlugin           *plugin);
+static void     clock_plugin_map                       (GtkWidget             *widget);
+static void     clock_plugin_unmap                     (GtkWidget             *widget);
+static void     clock_plugin_hierarchy_changed         (GtkWidget             *widget,
+                                                        GtkWidget             *previous_toplevel);
 static void     clock_plugin_construct                 (XfcePanelPlugin       *panel_plugin);
 static void     clock_plugin_free_data                 (XfcePanelPlugin       *panel_plugin);
 static gboolean clock_plugin_size_changed              (XfcePanelPlugin       *panel_plugin,
@@ -150,6 +154,7 @@ struct _ClockPlugin
   guint               rotate_vertically : 1;
 
   gchar              *tooltip_format;
+  ClockTimeFormat    *tooltip_compiled;
   ClockTimeTimeout   *tooltip_timeout;
 
   GdkSeat            *seat;
@@ -157,6 +162,11 @@ struct _ClockPlugin
 
   gchar              *time_config_tool;
   ClockTime          *time;
+
+  /* toplevel, moved offscreen when the panel is autohidden */
+  GtkWidget          *toplevel;
+  gulong              toplevel_configure_id;
+  guint               offscreen : 1;
 };
 
 typedef struct
@@ -209,12 +219,18 @@ static void
 clock_plugin_class_init (ClockPluginClass *klass)
 {
   GObjectClass         *gobject_class;
+  GtkWidgetClass       *gtkwidget_class;
   XfcePanelPluginClass *plugin_class;
 
   gobject_class = G_OBJECT_CLASS (klass);
   gobject_class->set_property = clock_plugin_set_property;
   gobject_class->get_property = clock_plugin_get_property;
 
+  gtkwidget_class = GTK_WIDGET_CLASS (klass);
+  gtkwidget_class->map = clock_plugin_map;
+  gtkwidget_class->unmap = clock_plugin_unmap;
+  gtkwidget_class->hierarchy_changed = clock_plugin_hierarchy_changed;
+
   plugin_class = XFCE_PANEL_PLUGIN_CLASS (klass);
   plugin_class->construct = clock_plugin_construct;
   plugin_class->free_data = clock_plugin_free_data;
@@ -269,12 +285,16 @@ clock_plugin_init (ClockPlugin *plugin)
   plugin->clock = NULL;
   plugin->tooltip_format = g_strdup (DEFAULT_TOOLTIP_FORMAT);
   plugin->tooltip_timeout = NULL;
+  plugin->tooltip_compiled = NULL;
   plugin->command = NULL;
   plugin->time_config_tool = g_strdup (DEFAULT_TIME_CONFIG_TOOL);
   plugin->rotate_vertically = TRUE;
   plugin->seat = NULL;
   plugin->seat_grabbed = FALSE;
   plugin->time = clock_time_new ();
+  plugin->toplevel = NULL;
+  plugin->toplevel_configure_id = 0;
+  plugin->offscreen = FALSE;
 
   plugin->button = xfce_panel_create_toggle_button ();
   /* xfce_panel_plugin_add_action_widget (XFCE_PANEL_PLUGIN (plugin), plugin->button); */
@@ -354,6 +374,10 @@ clock_plugin_set_property (GObject      *object,
     case PROP_TOOLTIP_FORMAT:
       g_free (plugin->tooltip_format);
       plugin->tooltip_format = g_value_dup_string (value);
+
+      /* parse the new format on the next update */
+      clock_time_format_free (plugin->tooltip_compiled);
+      plugin->tooltip_compiled = NULL;
       break;
 
     case PROP_COMMAND:
@@ -476,6 +500,103 @@ clock_plugin_button_press_event (GtkWidget      *widget,
 
 
 
+static void
+clock_plugin_update_suspended (ClockPlugin *plugin)
+{
+  gboolean suspended;
+
+  /* no need to tick when nothing of the clock is visible */
+  suspended = !gtk_widget_get_mapped (GTK_WIDGET (plugin)) || plugin->offscreen;
+  clock_time_set_suspended (plugin->time, suspended);
+}
+
+
+
+static void
+clock_plugin_map (GtkWidget *widget)
+{
+  (*GTK_WIDGET_CLASS (clock_plugin_parent_class)->map) (widget);
+
+  /* the plugin is torn down, see clock_plugin_free_data() */
+  if (XFCE_CLOCK_PLUGIN (widget)->time == NULL)
+    return;
+
+  clock_plugin_update_suspended (XFCE_CLOCK_PLUGIN (widget));
+}
+
+
+
+static void
+clock_plugin_unmap (GtkWidget *widget)
+{
+  (*GTK_WIDGET_CLASS (clock_plugin_parent_class)->unmap) (widget);
+
+  if (XFCE_CLOCK_PLUGIN (widget)->time == NULL)
+    return;
+
+  clock_plugin_update_suspended (XFCE_CLOCK_PLUGIN (widget));
+}
+
+
+
+static gboolean
+clock_plugin_toplevel_configure_event (GtkWidget         *toplevel,
+                                       GdkEventConfigure *event,
+                                       ClockPlugin       *plugin)
+{
+  gboolean offscreen;
+
+  /* an autohidden panel is moved out of the screen */
+  offscreen = (event->x + event->width <= 0 || event->y + event->height <= 0);
+  if (plugin->offscreen != offscreen)
+    {
+      plugin->offscreen = offscreen;
+      clock_plugin_update_suspended (plugin);
+    }
+
+  return FALSE;
+}
+
+
+
+static void
+clock_plugin_hierarchy_changed (GtkWidget *widget,
+                                GtkWidget *previous_toplevel)
+{
+  ClockPlugin *plugin = XFCE_CLOCK_PLUGIN (widget);
+  GtkWidget   *toplevel;
+
+  if (GTK_WIDGET_CLASS (clock_plugin_parent_class)->hierarchy_changed != NULL)
+    (*GTK_WIDGET_CLASS (clock_plugin_parent_class)->hierarchy_changed) (widget, previous_toplevel);
+
+  /* the widget is unparented after free-data during dispose */
+  if (plugin->time == NULL)
+    return;
+
+  toplevel = gtk_widget_get_toplevel (widget);
+  if (!gtk_widget_is_toplevel (toplevel))
+    toplevel = NULL;
+
+  if (plugin->toplevel == toplevel)
+    return;
+
+  if (plugin->toplevel_configure_id != 0)
+    {
+      g_signal_handler_disconnect (G_OBJECT (plugin->toplevel), plugin->toplevel_configure_id);
+      plugin->toplevel_configure_id = 0;
+    }
+
+  plugin->toplevel = toplevel;
+  plugin->offscreen = FALSE;
+
+  if (toplevel != NULL)
+    plugin->toplevel_configure_id =
+      g_signal_connect (G_OBJECT (toplevel), "configure-event",
+                        G_CALLBACK (clock_plugin_toplevel_configure_event), plugin);
+}
+
+
+
 static void
 clock_plugin_construct (XfcePanelPlugin *panel_plugin)
 {
@@ -521,14 +642,26 @@ clock_plugin_free_data (XfcePanelPlugin *panel_plugin)
   ClockPlugin *plugin = XFCE_CLOCK_PLUGIN (panel_plugin);
 
   if (plugin->tooltip_timeout != NULL)
-    clock_time_timeout_free (plugin->tooltip_timeout);
+    {
+      clock_time_timeout_free (plugin->tooltip_timeout);
+      plugin->tooltip_timeout = NULL;
+    }
+
+  if (plugin->toplevel_configure_id != 0)
+    {
+      g_signal_handler_disconnect (G_OBJECT (plugin->toplevel), plugin->toplevel_configure_id);
+      plugin->toplevel_configure_id = 0;
+    }
+  plugin->toplevel = NULL;
 
   if (plugin->calendar_window != NULL)
     gtk_widget_destroy (plugin->calendar_window);
 
   g_object_unref (G_OBJECT (plugin->time));
+  plugin->time = NULL;
 
   g_free (plugin->tooltip_format);
+  clock_time_format_free (plugin->tooltip_compiled);
   g_free (plugin->time_config_tool);
   g_free (plugin->command);
 }
@@ -1359,15 +1492,19 @@ static gboolean
 clock_plugin_tooltip (gpointer user_data)
 {
   ClockPlugin *plugin = XFCE_CLOCK_PLUGIN (user_data);
-  gchar       *string;
 
-  /* set the tooltip */
-  string = clock_time_strdup_strftime (plugin->time, plugin->tooltip_format);
-  gtk_widget_set_tooltip_markup (GTK_WIDGET (plugin), string);
-  g_free (string);
+  if (G_UNLIKELY (plugin->tooltip_compiled == NULL))
+    plugin->tooltip_compiled = clock_time_format_new (plugin->tooltip_format);
+
+  /* set the tooltip when the text changed */
+  if (clock_time_format_update (plugin->tooltip_compiled, plugin->time))
+    {
+      gtk_widget_set_tooltip_markup (GTK_WIDGET (plugin),
+                                     clock_time_format_get_text (plugin->tooltip_compiled));
 
-  /* make sure the tooltip is up2date */
-  gtk_widget_trigger_tooltip_query (GTK_WIDGET (plugin));
+      /* make sure the tooltip is up2date */
+      gtk_widget_trigger_tooltip_query (GTK_WIDGET (plugin));
+    }
 
   /* keep the timeout running */
   return TRUE;
@@ -40,6 +40,7 @@
 
 #define ARROW_BUTTON_SIZE              (12)
 #define MENU_POPUP_DELAY               (225)
+#define TOOLTIP_ICON_SIZE              (32)
 #define NO_ARROW_INSIDE_BUTTON(plugin) ((plugin)->arrow_position != LAUNCHER_ARROW_INTERNAL \
                                         || LIST_HAS_ONE_OR_NO_ENTRIES ((plugin)->items))
 #define ARROW_INSIDE_BUTTON(plugin)    (!NO_ARROW_INSIDE_BUTTON (plugin))
@@ -74,8 +75,11 @@ static void               launcher_plugin_icon_theme_changed            (GtkIcon
                                                                          LauncherPlugin       *plugin);
 static LauncherArrowType  launcher_plugin_default_arrow_type            (LauncherPlugin       *plugin);
 static void               launcher_plugin_pack_widgets                  (LauncherPlugin       *plugin);
-static GdkPixbuf         *launcher_plugin_tooltip_pixbuf                (GdkScreen            *screen,
-                                                                         const gchar          *icon_name);
+static void               launcher_plugin_icon_cache_free               (gpointer              data);
+static GdkPixbuf         *launcher_plugin_icon_cache_lookup             (LauncherPlugin       *plugin,
+                                                                         GdkScreen            *screen,
+                                                                         const gchar          *icon_name,
+                                                                         gint                  size);
 static void               launcher_plugin_menu_deactivate               (GtkWidget            *menu,
                                                                          LauncherPlugin       *plugin);
 static void               launcher_plugin_menu_item_activate            (GtkMenuItem          *widget,
@@ -88,6 +92,11 @@ static void               launcher_plugin_menu_item_drag_data_received  (GtkWidg
                                                                          guint                 info,
                                                                          guint                 drag_time,
                                                                          GarconMenuItem       *item);
+static void               launcher_plugin_menu_item_update              (LauncherPlugin       *plugin,
+                                                                         GarconMenuItem       *item,
+                                                                         GtkWidget            *mi);
+static void               launcher_plugin_menu_sync                     (LauncherPlugin       *plugin);
+static void               launcher_plugin_menu_update                   (LauncherPlugin       *plugin);
 static void               launcher_plugin_menu_construct                (LauncherPlugin       *plugin);
 static void               launcher_plugin_menu_popup_destroyed          (gpointer              user_data);
 static gboolean           launcher_plugin_menu_popup                    (gpointer              user_data);
@@ -192,11 +201,17 @@ struct _LauncherPlugin
   GtkWidget         *child;
   GtkWidget         *menu;
 
+  /* menu item widgets in the menu, keyed by their garcon item */
+  GHashTable        *menu_items;
+
   GSList            *items;
 
   GdkPixbuf         *pixbuf;
   gchar             *icon_name;
-  GdkPixbuf         *tooltip_cache;
+
+  /* loaded icons for the button, menu items and tooltips */
+  GHashTable        *icon_cache;
+  GtkIconTheme      *icon_cache_theme;
 
   gulong             theme_change_id;
 
@@ -336,9 +351,13 @@ launcher_plugin_init (LauncherPlugin *plugin)
   plugin->show_label = FALSE;
   plugin->arrow_position = LAUNCHER_ARROW_DEFAULT;
   plugin->menu = NULL;
+  plugin->menu_items = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                              g_object_unref, NULL);
   plugin->items = NULL;
   plugin->child = NULL;
-  plugin->tooltip_cache = NULL;
+  plugin->icon_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                              launcher_plugin_icon_cache_free);
+  plugin->icon_cache_theme = NULL;
   plugin->pixbuf = NULL;
   plugin->icon_name = NULL;
   plugin->menu_timeout_id = 0;
@@ -490,7 +509,8 @@ static void
 launcher_plugin_item_changed (GarconMenuItem *item,
                               LauncherPlugin *plugin)
 {
-  GSList *li;
+  GSList    *li;
+  GtkWidget *mi;
 
   panel_return_if_fail (GARCON_IS_MENU_ITEM (item));
   panel_return_if_fail (XFCE_IS_LAUNCHER_PLUGIN (plugin));
@@ -499,11 +519,14 @@ launcher_plugin_item_changed (GarconMenuItem *item,
   li = g_slist_find (plugin->items, item);
   if (G_LIKELY (li != NULL))
     {
-      /* update the button or destroy the menu */
+      /* update the button */
       if (plugin->items == li)
         launcher_plugin_button_update (plugin);
-      else
-        launcher_plugin_menu_destroy (plugin);
+
+      /* update the menu item of this item only */
+      mi = g_hash_table_lookup (plugin->menu_items, item);
+      if (mi != NULL)
+        launcher_plugin_menu_item_update (plugin, item, mi);
     }
   else
     {
@@ -839,9 +862,6 @@ launcher_plugin_set_property (GObject      *object,
 
   panel_return_if_fail (G_IS_FILE (plugin->config_directory));
 
-  /* destroy the menu, all the setting changes need this */
-  launcher_plugin_menu_destroy (plugin);
-
   switch (prop_id)
     {
     case PROP_ITEMS:
@@ -916,8 +936,11 @@ update_arrow:
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
-      break;
+      return;
     }
+
+  /* patch the menu, all the setting changes need this */
+  launcher_plugin_menu_update (plugin);
 }
 
 
@@ -1002,7 +1025,7 @@ launcher_plugin_file_changed (GFileMonitor      *monitor,
   if (update_plugin)
     {
       launcher_plugin_button_update (plugin);
-      launcher_plugin_menu_destroy (plugin);
+      launcher_plugin_menu_update (plugin);
 
       /* save the new config */
       launcher_plugin_save_delayed (plugin);
@@ -1125,6 +1148,7 @@ launcher_plugin_free_data (XfcePanelPlugin *panel_plugin)
 
   /* destroy the menu and timeout */
   launcher_plugin_menu_destroy (plugin);
+  g_hash_table_destroy (plugin->menu_items);
 
   launcher_plugin_items_free (plugin);
 
@@ -1138,9 +1162,8 @@ launcher_plugin_free_data (XfcePanelPlugin *panel_plugin)
       g_signal_handler_disconnect (G_OBJECT (icon_theme), plugin->theme_change_id);
     }
 
-  /* release the cached tooltip */
-  if (plugin->tooltip_cache != NULL)
-    g_object_unref (G_OBJECT (plugin->tooltip_cache));
+  /* release the icon cache */
+  g_hash_table_destroy (plugin->icon_cache);
   /* release the cached pixbuf */
   if (plugin->pixbuf != NULL)
     g_object_unref (G_OBJECT (plugin->pixbuf));
@@ -1335,9 +1358,11 @@ launcher_plugin_size_changed (XfcePanelPlugin *panel_plugin,
     if (plugin->pixbuf != NULL &&
         plugin->icon_name != NULL) {
       g_object_unref (plugin->pixbuf);
-      plugin->pixbuf = gdk_pixbuf_new_from_file_at_size (plugin->icon_name,
-                                                         icon_size, icon_size,
-                                                         NULL);
+      plugin->pixbuf = launcher_plugin_icon_cache_lookup (plugin,
+                                                          gtk_widget_get_screen (GTK_WIDGET (plugin)),
+                                                          plugin->icon_name, icon_size);
+      if (plugin->pixbuf != NULL)
+        g_object_ref (G_OBJECT (plugin->pixbuf));
       gtk_image_set_from_pixbuf (GTK_IMAGE (plugin->child), plugin->pixbuf);
     }
     /* set the panel plugin icon size */
@@ -1370,8 +1395,8 @@ launcher_plugin_screen_position_changed (XfcePanelPlugin    *panel_plugin,
   xfce_arrow_button_set_arrow_type (XFCE_ARROW_BUTTON (plugin->arrow),
       xfce_panel_plugin_arrow_type (panel_plugin));
 
-  /* destroy the menu to update sort order */
-  launcher_plugin_menu_destroy (plugin);
+  /* update the sort order of the menu */
+  launcher_plugin_menu_update (plugin);
 }
 
 
@@ -1384,11 +1409,7 @@ launcher_plugin_icon_theme_changed (GtkIconTheme   *icon_theme,
   panel_return_if_fail (GTK_IS_ICON_THEME (icon_theme));
 
   /* invalid the icon cache */
-  if (plugin->tooltip_cache != NULL)
-    {
-      g_object_unref (G_OBJECT (plugin->tooltip_cache));
-      plugin->tooltip_cache = NULL;
-    }
+  g_hash_table_remove_all (plugin->icon_cache);
 }
 
 
@@ -1447,29 +1468,62 @@ launcher_plugin_pack_widgets (LauncherPlugin *plugin)
 
 
 
+static void
+launcher_plugin_icon_cache_free (gpointer data)
+{
+  /* failed lookups are cached as %NULL */
+  if (data != NULL)
+    g_object_unref (G_OBJECT (data));
+}
+
+
+
 static GdkPixbuf *
-launcher_plugin_tooltip_pixbuf (GdkScreen   *screen,
-                                const gchar *icon_name)
+launcher_plugin_icon_cache_lookup (LauncherPlugin *plugin,
+                                   GdkScreen      *screen,
+                                   const gchar    *icon_name,
+                                   gint            size)
 {
   GtkIconTheme *theme;
+  GdkPixbuf    *pixbuf;
+  gchar        *key;
 
+  panel_return_val_if_fail (XFCE_IS_LAUNCHER_PLUGIN (plugin), NULL);
   panel_return_val_if_fail (screen == NULL || GDK_IS_SCREEN (screen), NULL);
 
   if (panel_str_is_empty (icon_name))
     return NULL;
 
-  /* load directly from a file */
-  if (G_UNLIKELY (g_path_is_absolute (icon_name)))
-    return gdk_pixbuf_new_from_file_at_scale (icon_name, 32, 32, TRUE, NULL);
-
   if (G_LIKELY (screen != NULL))
     theme = gtk_icon_theme_get_for_screen (screen);
   else
     theme = gtk_icon_theme_get_default ();
 
-  return gtk_icon_theme_load_icon_for_scale (theme, icon_name, GTK_ICON_SIZE_DND,
-                                             GTK_ICON_SIZE_DND,
-                                             GTK_ICON_LOOKUP_FORCE_SIZE, NULL);
+  /* the cached icons are only valid for a single theme */
+  if (G_UNLIKELY (plugin->icon_cache_theme != theme))
+    {
+      g_hash_table_remove_all (plugin->icon_cache);
+      plugin->icon_cache_theme = theme;
+    }
+
+  key = g_strdup_printf ("%d:%s", size, icon_name);
+  if (g_hash_table_lookup_extended (plugin->icon_cache, key, NULL, (gpointer *) &pixbuf))
+    {
+      g_free (key);
+      return pixbuf;
+    }
+
+  /* load directly from a file */
+  if (G_UNLIKELY (g_path_is_absolute (icon_name)))
+    pixbuf = gdk_pixbuf_new_from_file_at_scale (icon_name, size, size, TRUE, NULL);
+  else
+    pixbuf = gtk_icon_theme_load_icon (theme, icon_name, size,
+                                       GTK_ICON_LOOKUP_FORCE_SIZE, NULL);
+
+  /* also remember failures, so we don't hit the disk again */
+  g_hash_table_insert (plugin->icon_cache, key, pixbuf);
+
+  return pixbuf;
 }
 
 
@@ -1529,8 +1583,8 @@ launcher_plugin_menu_item_activate (GtkMenuItem      *widget,
       plugin->items = g_slist_remove (plugin->items, item);
       plugin->items = g_slist_prepend (plugin->items, item);
 
-      /* destroy the menu and update the icon */
-      launcher_plugin_menu_destroy (plugin);
+      /* update the menu and the icon */
+      launcher_plugin_menu_update (plugin);
       launcher_plugin_button_update (plugin);
     }
 }
@@ -1584,93 +1638,189 @@ launcher_plugin_menu_item_drag_data_received (GtkWidget          *widget,
 
 
 static void
-launcher_plugin_menu_construct (LauncherPlugin *plugin)
+launcher_plugin_menu_item_update (LauncherPlugin *plugin,
+                                  GarconMenuItem *item,
+                                  GtkWidget      *mi)
+{
+  GtkWidget   *box, *label, *image;
+  const gchar *name, *icon_name;
+
+  panel_return_if_fail (XFCE_IS_LAUNCHER_PLUGIN (plugin));
+  panel_return_if_fail (GARCON_IS_MENU_ITEM (item));
+  panel_return_if_fail (GTK_IS_MENU_ITEM (mi));
+
+  /* remove the old contents */
+  box = gtk_bin_get_child (GTK_BIN (mi));
+  if (box != NULL)
+    gtk_widget_destroy (box);
+
+  name = garcon_menu_item_get_name (item);
+  label = gtk_label_new (panel_str_is_empty (name) ? _("Unnamed Item") : name);
+  gtk_label_set_xalign (GTK_LABEL (label), 0.0);
+  box = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 4);
+  gtk_box_pack_end (GTK_BOX (box), label, TRUE, TRUE, 0);
+  gtk_container_add (GTK_CONTAINER (mi), box);
+
+  /* set the icon if one is set */
+  icon_name = garcon_menu_item_get_icon_name (item);
+  if (!panel_str_is_empty (icon_name))
+    {
+      if (g_path_is_absolute (icon_name))
+        {
+          /* use the shared cache to avoid decoding the file on every rebuild */
+          image = gtk_image_new_from_pixbuf (
+              launcher_plugin_icon_cache_lookup (plugin,
+                                                 gtk_widget_get_screen (GTK_WIDGET (plugin)),
+                                                 icon_name, 16));
+        }
+      else
+        {
+          image = gtk_image_new_from_icon_name (icon_name, GTK_ICON_SIZE_MENU);
+          gtk_image_set_pixel_size (GTK_IMAGE (image), 16);
+        }
+      gtk_box_pack_start (GTK_BOX (box), image, FALSE, TRUE, 3);
+    }
+
+  gtk_widget_show_all (box);
+}
+
+
+
+static GtkWidget *
+launcher_plugin_menu_item_new (LauncherPlugin *plugin,
+                               GarconMenuItem *item)
+{
+  GtkWidget *mi;
+
+  panel_return_val_if_fail (XFCE_IS_LAUNCHER_PLUGIN (plugin), NULL);
+  panel_return_val_if_fail (GARCON_IS_MENU_ITEM (item), NULL);
+
+  /* create the menu item */
+  mi = gtk_menu_item_new ();
+  g_object_set_qdata (G_OBJECT (mi), launcher_plugin_quark, plugin);
+  gtk_drag_dest_set (mi, GTK_DEST_DEFAULT_ALL, drop_targets,
+                     G_N_ELEMENTS (drop_targets), GDK_ACTION_COPY);
+  g_signal_connect (G_OBJECT (mi), "activate",
+      G_CALLBACK (launcher_plugin_menu_item_activate), item);
+  g_signal_connect (G_OBJECT (mi), "drag-data-received",
+      G_CALLBACK (launcher_plugin_menu_item_drag_data_received), item);
+  g_signal_connect (G_OBJECT (mi), "drag-leave",
+      G_CALLBACK (launcher_plugin_arrow_drag_leave), plugin);
+
+  /* the tooltip is enabled or disabled in the menu sync */
+  g_signal_connect (G_OBJECT (mi), "query-tooltip",
+      G_CALLBACK (launcher_plugin_item_query_tooltip), item);
+
+  launcher_plugin_menu_item_update (plugin, item, mi);
+  gtk_widget_show (mi);
+
+  return mi;
+}
+
+
+
+static void
+launcher_plugin_menu_sync (LauncherPlugin *plugin)
 {
   GtkArrowType    arrow_type;
   guint           n;
   GarconMenuItem *item;
-  GtkWidget      *mi, *box, *label, *image;
-  const gchar    *name, *icon_name;
+  GtkWidget      *mi;
   GSList         *li;
+  GHashTableIter  iter;
+  gpointer        key, value;
+  GList          *children = NULL, *current, *lp, *lc;
+  gint            position;
 
   panel_return_if_fail (XFCE_IS_LAUNCHER_PLUGIN (plugin));
-  panel_return_if_fail (plugin->menu == NULL);
+  panel_return_if_fail (GTK_IS_MENU (plugin->menu));
 
-  /* create a new menu */
-  plugin->menu = gtk_menu_new ();
-  gtk_menu_set_reserve_toggle_size (GTK_MENU (plugin->menu), FALSE);
-  gtk_menu_attach_to_widget (GTK_MENU (plugin->menu), GTK_WIDGET (plugin), NULL);
-  g_signal_connect (G_OBJECT (plugin->menu), "deactivate",
-                    G_CALLBACK (launcher_plugin_menu_deactivate), plugin);
-
-  /* get the arrow type of the plugin */
-  arrow_type = xfce_arrow_button_get_arrow_type (XFCE_ARROW_BUTTON (plugin->arrow));
+  /* destroy the menu items of launcher items that were removed or
+   * moved to the button */
+  g_hash_table_iter_init (&iter, plugin->menu_items);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      li = g_slist_find (plugin->items, key);
+      if (li == NULL
+          || (li == plugin->items && plugin->arrow_position != LAUNCHER_ARROW_INTERNAL))
+        {
+          gtk_widget_destroy (GTK_WIDGET (value));
+          g_hash_table_iter_remove (&iter);
+        }
+    }
 
-  /* walk through the menu entries */
+  /* walk through the menu entries and create the missing menu items */
   for (li = plugin->items, n = 0; li != NULL; li = li->next, n++)
     {
       /* skip the first entry when the arrow is visible */
       if (n == 0 && plugin->arrow_position != LAUNCHER_ARROW_INTERNAL)
         continue;
 
-      /* get the item data */
       item = GARCON_MENU_ITEM (li->data);
-
-      /* create the menu item */
-      name = garcon_menu_item_get_name (item);
-      mi = gtk_menu_item_new ();
-      label = gtk_label_new (panel_str_is_empty (name) ? _("Unnamed Item") : name);
-      gtk_label_set_xalign (GTK_LABEL (label), 0.0);
-      box = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 4);
-      gtk_box_pack_end (GTK_BOX (box), label, TRUE, TRUE, 0);
-      gtk_container_add (GTK_CONTAINER (mi), box);
-      g_object_set_qdata (G_OBJECT (mi), launcher_plugin_quark, plugin);
-      gtk_widget_show_all (mi);
-      gtk_drag_dest_set (mi, GTK_DEST_DEFAULT_ALL, drop_targets,
-                         G_N_ELEMENTS (drop_targets), GDK_ACTION_COPY);
-      g_signal_connect (G_OBJECT (mi), "activate",
-          G_CALLBACK (launcher_plugin_menu_item_activate), item);
-      g_signal_connect (G_OBJECT (mi), "drag-data-received",
-          G_CALLBACK (launcher_plugin_menu_item_drag_data_received), item);
-      g_signal_connect (G_OBJECT (mi), "drag-leave",
-          G_CALLBACK (launcher_plugin_arrow_drag_leave), plugin);
-
-      /* only connect the tooltip signal if tips are enabled */
-      if (!plugin->disable_tooltips)
+      mi = g_hash_table_lookup (plugin->menu_items, item);
+      if (mi == NULL)
         {
-          gtk_widget_set_has_tooltip (mi, TRUE);
-          g_signal_connect (G_OBJECT (mi), "query-tooltip",
-              G_CALLBACK (launcher_plugin_item_query_tooltip), item);
+          mi = launcher_plugin_menu_item_new (plugin, item);
+          gtk_menu_shell_append (GTK_MENU_SHELL (plugin->menu), mi);
+          g_hash_table_insert (plugin->menu_items, g_object_ref (G_OBJECT (item)), mi);
         }
 
-      /* depending on the menu position we prepend or append */
-      if (G_UNLIKELY (arrow_type == GTK_ARROW_UP))
-        gtk_menu_shell_prepend (GTK_MENU_SHELL (plugin->menu), mi);
-      else
-        gtk_menu_shell_append (GTK_MENU_SHELL (plugin->menu), mi);
+      gtk_widget_set_has_tooltip (mi, !plugin->disable_tooltips);
+      children = g_list_prepend (children, mi);
+    }
 
-      /* set the icon if one is set */
-      icon_name = garcon_menu_item_get_icon_name (item);
-      if (!panel_str_is_empty (icon_name))
-        {
-          if (g_path_is_absolute (icon_name))
-            {
-              /* remember the icon name for recreating the pixbuf when panel
-                 size changes */
-              plugin->icon_name = g_strdup (icon_name);
-              plugin->pixbuf = gdk_pixbuf_new_from_file_at_size (icon_name, 16, 16, NULL);
-              image = gtk_image_new_from_pixbuf (plugin->pixbuf);
-            }
-          else
-            {
-              image = gtk_image_new_from_icon_name (icon_name, GTK_ICON_SIZE_MENU);
-              gtk_image_set_pixel_size (GTK_IMAGE (image), 16);
-              plugin->icon_name = NULL;
-            }
-          gtk_box_pack_start (GTK_BOX (box), image, FALSE, TRUE, 3);
-          gtk_widget_show (image);
-        }
+  /* get the arrow type of the plugin, depending on the menu
+   * position the items are in reversed order */
+  arrow_type = xfce_arrow_button_get_arrow_type (XFCE_ARROW_BUTTON (plugin->arrow));
+  if (G_LIKELY (arrow_type != GTK_ARROW_UP))
+    children = g_list_reverse (children);
+
+  /* only reorder if the order in the menu is different */
+  current = gtk_container_get_children (GTK_CONTAINER (plugin->menu));
+  for (lp = children, lc = current; lp != NULL && lc != NULL; lp = lp->next, lc = lc->next)
+    if (lp->data != lc->data)
+      break;
+
+  if (lp != NULL || lc != NULL)
+    {
+      for (lp = children, position = 0; lp != NULL; lp = lp->next, position++)
+        gtk_menu_reorder_child (GTK_MENU (plugin->menu), GTK_WIDGET (lp->data), position);
     }
+
+  g_list_free (current);
+  g_list_free (children);
+}
+
+
+
+static void
+launcher_plugin_menu_update (LauncherPlugin *plugin)
+{
+  panel_return_if_fail (XFCE_IS_LAUNCHER_PLUGIN (plugin));
+
+  /* the menu is synced when it is constructed */
+  if (plugin->menu != NULL)
+    launcher_plugin_menu_sync (plugin);
+}
+
+
+
+static void
+launcher_plugin_menu_construct (LauncherPlugin *plugin)
+{
+  panel_return_if_fail (XFCE_IS_LAUNCHER_PLUGIN (plugin));
+  panel_return_if_fail (plugin->menu == NULL);
+
+  /* create a new menu, the menu is kept around and patched
+   * when the launcher items change */
+  plugin->menu = gtk_menu_new ();
+  gtk_menu_set_reserve_toggle_size (GTK_MENU (plugin->menu), FALSE);
+  gtk_menu_attach_to_widget (GTK_MENU (plugin->menu), GTK_WIDGET (plugin), NULL);
+  g_signal_connect (G_OBJECT (plugin->menu), "deactivate",
+                    G_CALLBACK (launcher_plugin_menu_deactivate), plugin);
+
+  /* add the menu items */
+  launcher_plugin_menu_sync (plugin);
 }
 
 
@@ -1743,6 +1893,7 @@ launcher_plugin_menu_destroy (LauncherPlugin *plugin)
       /* destroy the menu */
       gtk_widget_destroy (plugin->menu);
       plugin->menu = NULL;
+      g_hash_table_remove_all (plugin->menu_items);
 
       /* deactivate the toggle button */
       gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (plugin->arrow), FALSE);
@@ -1762,17 +1913,14 @@ launcher_plugin_button_update (LauncherPlugin *plugin)
 
   panel_return_if_fail (XFCE_IS_LAUNCHER_PLUGIN (plugin));
 
-  /* invalate the tooltip icon cache */
-  if (plugin->tooltip_cache != NULL)
-    {
-      g_object_unref (G_OBJECT (plugin->tooltip_cache));
-      plugin->tooltip_cache = NULL;
-    }
   if (plugin->pixbuf != NULL)
     {
       g_object_unref (G_OBJECT (plugin->pixbuf));
       plugin->pixbuf = NULL;
     }
+  g_free (plugin->icon_name);
+  plugin->icon_name = NULL;
+
   /* get first item */
   if (G_LIKELY (plugin->items != NULL))
     item = GARCON_MENU_ITEM (plugin->items->data);
@@ -1806,7 +1954,11 @@ launcher_plugin_button_update (LauncherPlugin *plugin)
             /* remember the icon name for recreating the pixbuf when panel
                size changes */
             plugin->icon_name = g_strdup (icon_name);
-            plugin->pixbuf = gdk_pixbuf_new_from_file_at_size (icon_name, icon_size, icon_size, NULL);
+            plugin->pixbuf = launcher_plugin_icon_cache_lookup (plugin,
+                                                                gtk_widget_get_screen (GTK_WIDGET (plugin)),
+                                                                icon_name, icon_size);
+            if (plugin->pixbuf != NULL)
+              g_object_ref (G_OBJECT (plugin->pixbuf));
             gtk_image_set_from_pixbuf (GTK_IMAGE (plugin->child), plugin->pixbuf);
           }
           else {
@@ -1947,14 +2099,10 @@ launcher_plugin_button_query_tooltip (GtkWidget      *widget,
   result = launcher_plugin_item_query_tooltip (widget, x, y, keyboard_mode, tooltip, item);
   if (G_LIKELY (result))
     {
-      /* set the cached icon if not already set */
-      if (G_UNLIKELY (plugin->tooltip_cache == NULL))
-        plugin->tooltip_cache =
-            launcher_plugin_tooltip_pixbuf (gtk_widget_get_screen (widget),
-                                            garcon_menu_item_get_icon_name (item));
-
-      if (G_LIKELY (plugin->tooltip_cache != NULL))
-        gtk_tooltip_set_icon (tooltip, plugin->tooltip_cache);
+      gtk_tooltip_set_icon (tooltip,
+          launcher_plugin_icon_cache_lookup (plugin, gtk_widget_get_screen (widget),
+                                             garcon_menu_item_get_icon_name (item),
+                                             TOOLTIP_ICON_SIZE));
     }
 
   return result;
@@ -2313,9 +2461,9 @@ launcher_plugin_item_query_tooltip (GtkWidget      *widget,
                                     GtkTooltip     *tooltip,
                                     GarconMenuItem *item)
 {
-  gchar       *markup;
-  const gchar *name, *comment;
-  GdkPixbuf   *pixbuf;
+  gchar          *markup;
+  const gchar    *name, *comment;
+  LauncherPlugin *plugin;
 
   panel_return_val_if_fail (GARCON_IS_MENU_ITEM (item), FALSE);
 
@@ -2336,28 +2484,17 @@ launcher_plugin_item_query_tooltip (GtkWidget      *widget,
       gtk_tooltip_set_text (tooltip, name);
     }
 
-  /* the button uses a custom cache because the button widget is never
-   * destroyed, for menu items we cache the pixbuf by attaching the
-   * data on the menu item widget */
+  /* the button sets its own icon, for menu items we lookup the
+   * icon in the cache of the plugin attached to the item */
   if (GTK_IS_MENU_ITEM (widget))
     {
-      pixbuf = g_object_get_data (G_OBJECT (widget), "pixbuf-cache");
-      if (G_LIKELY (pixbuf != NULL))
-        {
-          gtk_tooltip_set_icon (tooltip, pixbuf);
-        }
-      else
-        {
-          pixbuf = launcher_plugin_tooltip_pixbuf (gtk_widget_get_screen (widget),
-                                                   garcon_menu_item_get_icon_name (item));
-          if (G_LIKELY (pixbuf != NULL))
-            {
-              gtk_tooltip_set_icon (tooltip, pixbuf);
-              g_object_set_data_full (G_OBJECT (widget), "pixbuf-cache", pixbuf,
-                                      (GDestroyNotify) g_object_unref);
-            }
-        }
-     }
+      plugin = g_object_get_qdata (G_OBJECT (widget), launcher_plugin_quark);
+      if (G_LIKELY (plugin != NULL))
+        gtk_tooltip_set_icon (tooltip,
+            launcher_plugin_icon_cache_lookup (plugin, gtk_widget_get_screen (widget),
+                                               garcon_menu_item_get_icon_name (item),
+                                               TOOLTIP_ICON_SIZE));
+    }
 
   return TRUE;
 }
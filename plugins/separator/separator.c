@@ -42,22 +42,35 @@
 
 
 
-static void     separator_plugin_get_property              (GObject               *object,
-                                                            guint                  prop_id,
-                                                            GValue                *value,
-                                                            GParamSpec            *pspec);
-static void     separator_plugin_set_property              (GObject               *object,
-                                                            guint                  prop_id,
-                                                            const GValue          *value,
-                                                            GParamSpec            *pspec);
-static gboolean separator_plugin_draw                      (GtkWidget             *widget,
-                                                            cairo_t               *cr);
-static void     separator_plugin_construct                 (XfcePanelPlugin       *panel_plugin);
-static gboolean separator_plugin_size_changed              (XfcePanelPlugin       *panel_plugin,
-                                                            gint                   size);
-static void     separator_plugin_configure_plugin          (XfcePanelPlugin       *panel_plugin);
-static void     separator_plugin_orientation_changed       (XfcePanelPlugin       *panel_plugin,
-                                                            GtkOrientation         orientation);
+typedef struct _SeparatorPattern SeparatorPattern;
+
+
+
+static void              separator_plugin_get_property        (GObject              *object,
+                                                               guint                 prop_id,
+                                                               GValue               *value,
+                                                               GParamSpec           *pspec);
+static void              separator_plugin_set_property        (GObject              *object,
+                                                               guint                 prop_id,
+                                                               const GValue         *value,
+                                                               GParamSpec           *pspec);
+static gboolean          separator_plugin_draw                (GtkWidget            *widget,
+                                                               cairo_t              *cr);
+static void              separator_plugin_construct           (XfcePanelPlugin      *panel_plugin);
+static void              separator_plugin_free_data           (XfcePanelPlugin      *panel_plugin);
+static gboolean          separator_plugin_size_changed        (XfcePanelPlugin      *panel_plugin,
+                                                               gint                  size);
+static void              separator_plugin_configure_plugin    (XfcePanelPlugin      *panel_plugin);
+static void              separator_plugin_orientation_changed (XfcePanelPlugin      *panel_plugin,
+                                                               GtkOrientation        orientation);
+static void              separator_pattern_render             (SeparatorPattern     *pattern,
+                                                               cairo_t              *cr);
+static SeparatorPattern *separator_pattern_get                (SeparatorPluginStyle  style,
+                                                               GtkOrientation        orientation,
+                                                               gint                  width,
+                                                               gint                  height,
+                                                               gint                  scale);
+static void              separator_pattern_release            (SeparatorPattern     *pattern);
 
 
 
@@ -88,6 +101,23 @@ struct _SeparatorPlugin
 
   /* separator style */
   SeparatorPluginStyle  style;
+
+  /* rendered handle or dots */
+  SeparatorPattern     *pattern;
+};
+
+struct _SeparatorPattern
+{
+  SeparatorPluginStyle  style;
+  GtkOrientation        orientation;
+  gint                  width;
+  gint                  height;
+  gint                  scale;
+
+  /* alpha mask of the handle or dots */
+  cairo_surface_t      *surface;
+
+  gint                  ref_count;
 };
 
 enum
@@ -104,6 +134,11 @@ XFCE_PANEL_DEFINE_PLUGIN (SeparatorPlugin, separator_plugin)
 
 
 
+/* patterns shared by all separators */
+static GSList *separator_patterns = NULL;
+
+
+
 static void
 separator_plugin_class_init (SeparatorPluginClass *klass)
 {
@@ -120,6 +155,7 @@ separator_plugin_class_init (SeparatorPluginClass *klass)
 
   plugin_class = XFCE_PANEL_PLUGIN_CLASS (klass);
   plugin_class->construct = separator_plugin_construct;
+  plugin_class->free_data = separator_plugin_free_data;
   plugin_class->size_changed = separator_plugin_size_changed;
   plugin_class->configure_plugin = separator_plugin_configure_plugin;
   plugin_class->orientation_changed = separator_plugin_orientation_changed;
@@ -147,6 +183,7 @@ static void
 separator_plugin_init (SeparatorPlugin *plugin)
 {
   plugin->style = SEPARATOR_PLUGIN_STYLE_DEFAULT;
+  plugin->pattern = NULL;
 }
 
 
@@ -196,6 +233,12 @@ separator_plugin_set_property (GObject      *object,
       if (plugin->style == SEPARATOR_PLUGIN_STYLE_WRAP)
         plugin->style = SEPARATOR_PLUGIN_STYLE_DEFAULT;
 
+      if (plugin->pattern != NULL)
+        {
+          separator_pattern_release (plugin->pattern);
+          plugin->pattern = NULL;
+        }
+
       gtk_widget_queue_draw (GTK_WIDGET (object));
       break;
 
@@ -212,16 +255,150 @@ separator_plugin_set_property (GObject      *object,
 
 
 
+static void
+separator_pattern_render (SeparatorPattern *pattern,
+                          cairo_t          *cr)
+{
+  gdouble x, y;
+  guint   dotcount, i;
+  gint    width = pattern->width;
+  gint    height = pattern->height;
+
+  switch (pattern->style)
+    {
+    case SEPARATOR_PLUGIN_STYLE_HANDLE:
+      x = (width - HANDLE_SIZE) / 2;
+      y = (height - HANDLE_SIZE) / 2;
+      cairo_set_line_width (cr, 1.5);
+      /* draw the handle */
+      for (i = 0; i < 3; i++)
+        {
+          if (pattern->orientation == GTK_ORIENTATION_HORIZONTAL)
+            {
+              cairo_move_to (cr, x, y + (i * HANDLE_SIZE) - (HANDLE_SIZE / 2));
+              cairo_line_to (cr, x + HANDLE_SIZE, y + (i * HANDLE_SIZE) - (HANDLE_SIZE / 2));
+            }
+          else
+            {
+              cairo_move_to (cr, x + (i * HANDLE_SIZE) - (HANDLE_SIZE / 2), y);
+              cairo_line_to (cr, x + (i * HANDLE_SIZE) - (HANDLE_SIZE / 2), y + HANDLE_SIZE);
+            }
+          cairo_stroke (cr);
+        }
+      break;
+
+    case SEPARATOR_PLUGIN_STYLE_DOTS:
+      x = (width - DOTS_SIZE) / 2;
+      y = (height - DOTS_SIZE) / 2;
+      if (pattern->orientation == GTK_ORIENTATION_HORIZONTAL)
+        {
+          dotcount = MAX(height / (DOTS_SIZE + DOTS_OFFSET), 1);
+          y = (height / (double) dotcount - DOTS_SIZE) / 2;
+        }
+      else
+        {
+          dotcount = MAX(width / (DOTS_SIZE + DOTS_OFFSET), 1);
+          x = (width / (double) dotcount - DOTS_SIZE) / 2;
+        }
+
+      /* draw the dots */
+      for (i = 0; i < dotcount; i++)
+        {
+          if (pattern->orientation == GTK_ORIENTATION_HORIZONTAL)
+              cairo_arc (cr, x , y + (i * (height / (double) dotcount)) + (DOTS_SIZE / 2),
+                         DOTS_SIZE / 2, 0, 2 * 3.14);
+          else
+              cairo_arc (cr, x + (i * (width / (double) dotcount)) + (DOTS_SIZE / 2), y,
+                         DOTS_SIZE / 2, 0, 2 * 3.14);
+          cairo_fill (cr);
+        }
+      break;
+
+    default:
+      panel_assert_not_reached ();
+      break;
+    }
+}
+
+
+
+static SeparatorPattern *
+separator_pattern_get (SeparatorPluginStyle style,
+                       GtkOrientation       orientation,
+                       gint                 width,
+                       gint                 height,
+                       gint                 scale)
+{
+  SeparatorPattern *pattern;
+  GSList           *li;
+  cairo_t          *cr;
+
+  for (li = separator_patterns; li != NULL; li = li->next)
+    {
+      pattern = li->data;
+      if (pattern->style == style
+          && pattern->orientation == orientation
+          && pattern->width == width
+          && pattern->height == height
+          && pattern->scale == scale)
+        {
+          pattern->ref_count++;
+          return pattern;
+        }
+    }
+
+  pattern = g_slice_new0 (SeparatorPattern);
+  pattern->style = style;
+  pattern->orientation = orientation;
+  pattern->width = width;
+  pattern->height = height;
+  pattern->scale = scale;
+  pattern->ref_count = 1;
+
+  /* render the shape once as an alpha mask, the color is applied
+   * when the mask is painted */
+  pattern->surface = cairo_image_surface_create (CAIRO_FORMAT_A8, width * scale, height * scale);
+  cairo_surface_set_device_scale (pattern->surface, scale, scale);
+
+  cr = cairo_create (pattern->surface);
+  separator_pattern_render (pattern, cr);
+  cairo_destroy (cr);
+
+  separator_patterns = g_slist_prepend (separator_patterns, pattern);
+
+  return pattern;
+}
+
+
+
+static void
+separator_pattern_release (SeparatorPattern *pattern)
+{
+  panel_return_if_fail (pattern != NULL);
+  panel_return_if_fail (pattern->ref_count > 0);
+
+  if (--pattern->ref_count > 0)
+    return;
+
+  separator_patterns = g_slist_remove (separator_patterns, pattern);
+
+  cairo_surface_destroy (pattern->surface);
+  g_slice_free (SeparatorPattern, pattern);
+}
+
+
+
 static gboolean
 separator_plugin_draw (GtkWidget *widget,
                        cairo_t   *cr)
 {
   SeparatorPlugin  *plugin = XFCE_SEPARATOR_PLUGIN (widget);
   GtkAllocation     alloc;
-  gdouble           x, y;
-  guint             dotcount, i;
   GtkStyleContext  *ctx;
   GdkRGBA           fg_rgba;
+  GtkOrientation    orientation;
+  gint              scale;
+  SeparatorPattern *pattern;
 
   gtk_widget_get_allocation (widget, &alloc);
 
@@ -231,6 +408,8 @@ separator_plugin_draw (GtkWidget *widget,
   fg_rgba.alpha = 0.5;
   gdk_cairo_set_source_rgba (cr, &fg_rgba);
 
+  orientation = xfce_panel_plugin_get_orientation (XFCE_PANEL_PLUGIN (plugin));
+
   switch (plugin->style)
     {
     case SEPARATOR_PLUGIN_STYLE_TRANSPARENT:
@@ -240,8 +419,7 @@ separator_plugin_draw (GtkWidget *widget,
 
     case SEPARATOR_PLUGIN_STYLE_SEPARATOR:
 
-      if (xfce_panel_plugin_get_orientation (XFCE_PANEL_PLUGIN (plugin)) ==
-          GTK_ORIENTATION_HORIZONTAL)
+      if (orientation == GTK_ORIENTATION_HORIZONTAL)
         {
           gtk_render_line (ctx, cr,
                            (gdouble) (alloc.width - 1.0) / 2.0,
@@ -260,54 +438,27 @@ separator_plugin_draw (GtkWidget *widget,
       break;
 
     case SEPARATOR_PLUGIN_STYLE_HANDLE:
-      x = (alloc.width - HANDLE_SIZE) / 2;
-      y = (alloc.height - HANDLE_SIZE) / 2;
-      cairo_set_line_width (cr, 1.5);
-      /* draw the handle */
-      for (i = 0; i < 3; i++)
-        {
-          if (xfce_panel_plugin_get_orientation (XFCE_PANEL_PLUGIN (plugin)) ==
-              GTK_ORIENTATION_HORIZONTAL)
-            {
-              cairo_move_to (cr, x, y + (i * HANDLE_SIZE) - (HANDLE_SIZE / 2));
-              cairo_line_to (cr, x + HANDLE_SIZE, y + (i * HANDLE_SIZE) - (HANDLE_SIZE / 2));
-            }
-          else
-            {
-              cairo_move_to (cr, x + (i * HANDLE_SIZE) - (HANDLE_SIZE / 2), y);
-              cairo_line_to (cr, x + (i * HANDLE_SIZE) - (HANDLE_SIZE / 2), y + HANDLE_SIZE);
-            }
-          cairo_stroke (cr);
-        }
-      break;
-
     case SEPARATOR_PLUGIN_STYLE_DOTS:
-      x = (alloc.width - DOTS_SIZE) / 2;
-      y = (alloc.height - DOTS_SIZE) / 2;
-      if (xfce_panel_plugin_get_orientation (XFCE_PANEL_PLUGIN (plugin)) ==
-          GTK_ORIENTATION_HORIZONTAL)
+      if (alloc.width <= 0 || alloc.height <= 0)
+        break;
+
+      /* lookup the shared pattern if the geometry changed */
+      scale = gtk_widget_get_scale_factor (widget);
+      pattern = plugin->pattern;
+      if (pattern == NULL
+          || pattern->style != plugin->style
+          || pattern->orientation != orientation
+          || pattern->width != alloc.width
+          || pattern->height != alloc.height
+          || pattern->scale != scale)
         {
-          dotcount = MAX(alloc.height / (DOTS_SIZE + DOTS_OFFSET), 1);
-          y = (alloc.height / (double) dotcount - DOTS_SIZE) / 2;
-        }
-      else
-        {
-          dotcount = MAX(alloc.width / (DOTS_SIZE + DOTS_OFFSET), 1);
-          x = (alloc.width / (double) dotcount - DOTS_SIZE) / 2;
+          plugin->pattern = separator_pattern_get (plugin->style, orientation,
+                                                   alloc.width, alloc.height, scale);
+          if (pattern != NULL)
+            separator_pattern_release (pattern);
         }
 
-      /* draw the dots */
-      for (i = 0; i < dotcount; i++)
-        {
-          if (xfce_panel_plugin_get_orientation (XFCE_PANEL_PLUGIN (plugin)) ==
-              GTK_ORIENTATION_HORIZONTAL)
-              cairo_arc (cr, x , y + (i * (alloc.height / (double) dotcount)) + (DOTS_SIZE / 2),
-                         DOTS_SIZE / 2, 0, 2 * 3.14);
-          else
-              cairo_arc (cr, x + (i * (alloc.width / (double) dotcount)) + (DOTS_SIZE / 2), y,
-                         DOTS_SIZE / 2, 0, 2 * 3.14);
-          cairo_fill (cr);
-        }
+      cairo_mask_surface (cr, plugin->pattern->surface, 0, 0);
       break;
     }
 
@@ -342,6 +493,17 @@ separator_plugin_construct (XfcePanelPlugin *panel_plugin)
 
 
 
+static void
+separator_plugin_free_data (XfcePanelPlugin *panel_plugin)
+{
+  SeparatorPlugin *plugin = XFCE_SEPARATOR_PLUGIN (panel_plugin);
+
+  if (plugin->pattern != NULL)
+    separator_pattern_release (plugin->pattern);
+}
+
+
+
 static gboolean
 separator_plugin_size_changed (XfcePanelPlugin *panel_plugin,
                                gint             size)
@@ -37,7 +37,6 @@
 #ifdef GDK_WINDOWING_X11
 #include <X11/Xlib.h>
 #include <gdk/gdkx.h>
-#include <X11/extensions/shape.h>
 #endif
 
 
@@ -189,8 +188,11 @@ struct _XfceTasklist
   guint                 show_handle : 1;
 
 #ifdef GDK_WINDOWING_X11
-  /* wireframe window */
-  Window                wireframe_window;
+  /* wireframe overlay window and the pending geometry */
+  GtkWidget            *wireframe_window;
+  guint                 wireframe_composited : 1;
+  GdkRectangle          wireframe_geometry;
+  guint                 wireframe_update_id;
 #endif
 
   /* gtk style properties */
@@ -319,8 +321,16 @@ static void               xfce_tasklist_update_icon_geometries_destroyed (gpoint
 
 /* wireframe */
 #ifdef GDK_WINDOWING_X11
+static gboolean           xfce_tasklist_wireframe_draw                   (GtkWidget            *window,
+                                                                          cairo_t              *cr,
+                                                                          XfceTasklist         *tasklist);
+static void               xfce_tasklist_wireframe_create                 (XfceTasklist         *tasklist);
 static void               xfce_tasklist_wireframe_hide                   (XfceTasklist         *tasklist);
 static void               xfce_tasklist_wireframe_destroy                (XfceTasklist         *tasklist);
+static gboolean           xfce_tasklist_wireframe_update_tick            (GtkWidget            *widget,
+                                                                          GdkFrameClock        *frame_clock,
+                                                                          gpointer              data);
+static void               xfce_tasklist_wireframe_update_tick_destroyed  (gpointer              data);
 static void               xfce_tasklist_wireframe_update                 (XfceTasklist         *tasklist,
                                                                           XfceTasklistChild    *child);
 #endif
@@ -593,7 +603,9 @@ xfce_tasklist_init (XfceTasklist *tasklist)
   tasklist->middle_click = XFCE_TASKLIST_MIDDLE_CLICK_DEFAULT;
   tasklist->label_decorations = FALSE;
 #ifdef GDK_WINDOWING_X11
-  tasklist->wireframe_window = 0;
+  tasklist->wireframe_window = NULL;
+  tasklist->wireframe_composited = FALSE;
+  tasklist->wireframe_update_id = 0;
 #endif
   tasklist->update_icon_geometries_id = 0;
   tasklist->update_monitor_geometry_id = 0;
@@ -2325,122 +2337,214 @@ xfce_tasklist_child_new (XfceTasklist *tasklist)
  * Wire Frame
  **/
 #ifdef GDK_WINDOWING_X11
-static void
-xfce_tasklist_wireframe_hide (XfceTasklist *tasklist)
+static gboolean
+xfce_tasklist_wireframe_draw (GtkWidget    *window,
+                              cairo_t      *cr,
+                              XfceTasklist *tasklist)
 {
-  GdkDisplay *dpy;
+  gint width, height;
 
-  panel_return_if_fail (XFCE_IS_TASKLIST (tasklist));
+  panel_return_val_if_fail (XFCE_IS_TASKLIST (tasklist), FALSE);
 
-  if (tasklist->wireframe_window != 0)
-    {
-      /* unmap the window */
-      dpy = gtk_widget_get_display (GTK_WIDGET (tasklist));
-      XUnmapWindow (GDK_DISPLAY_XDISPLAY (dpy), tasklist->wireframe_window);
-    }
+  width = gtk_widget_get_allocated_width (window);
+  height = gtk_widget_get_allocated_height (window);
+
+  /* clear the window, with a compositor the inside of the
+   * frame stays transparent */
+  cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+  cairo_set_source_rgba (cr, 0.0, 0.0, 0.0, 0.0);
+  cairo_paint (cr);
+
+  /* black frame */
+  cairo_set_fill_rule (cr, CAIRO_FILL_RULE_EVEN_ODD);
+  cairo_rectangle (cr, 0, 0, width, height);
+  cairo_rectangle (cr, WIREFRAME_SIZE, WIREFRAME_SIZE,
+                   width - WIREFRAME_SIZE * 2, height - WIREFRAME_SIZE * 2);
+  cairo_set_source_rgb (cr, 0.0, 0.0, 0.0);
+  cairo_fill (cr);
+
+  /* outer and inner white rectangle */
+  cairo_set_line_width (cr, 1.0);
+  cairo_rectangle (cr, 0.5, 0.5, width - 1, height - 1);
+  cairo_rectangle (cr, WIREFRAME_SIZE - 0.5, WIREFRAME_SIZE - 0.5,
+                   width - 2 * (WIREFRAME_SIZE - 1) - 1,
+                   height - 2 * (WIREFRAME_SIZE - 1) - 1);
+  cairo_set_source_rgb (cr, 1.0, 1.0, 1.0);
+  cairo_stroke (cr);
+
+  return TRUE;
 }
 
 
 
 static void
-xfce_tasklist_wireframe_destroy (XfceTasklist *tasklist)
+xfce_tasklist_wireframe_create (XfceTasklist *tasklist)
 {
-  GdkDisplay *dpy;
+  GdkScreen      *screen;
+  GdkVisual      *visual;
+  cairo_region_t *region;
 
   panel_return_if_fail (XFCE_IS_TASKLIST (tasklist));
+  panel_return_if_fail (tasklist->wireframe_window == NULL);
 
-  if (tasklist->wireframe_window != 0)
-    {
-      /* unmap and destroy the window */
-      dpy = gtk_widget_get_display (GTK_WIDGET (tasklist));
-      XUnmapWindow (GDK_DISPLAY_XDISPLAY (dpy), tasklist->wireframe_window);
-      XDestroyWindow (GDK_DISPLAY_XDISPLAY (dpy), tasklist->wireframe_window);
+  screen = gtk_widget_get_screen (GTK_WIDGET (tasklist));
 
-      tasklist->wireframe_window = 0;
-    }
+  tasklist->wireframe_window = gtk_window_new (GTK_WINDOW_POPUP);
+  gtk_window_set_screen (GTK_WINDOW (tasklist->wireframe_window), screen);
+  gtk_widget_set_app_paintable (tasklist->wireframe_window, TRUE);
+  g_signal_connect (G_OBJECT (tasklist->wireframe_window), "draw",
+      G_CALLBACK (xfce_tasklist_wireframe_draw), tasklist);
+
+  /* use an argb visual if a compositor is running, otherwise the
+   * inside of the frame is cut out with a shape in the update */
+  visual = gdk_screen_get_rgba_visual (screen);
+  tasklist->wireframe_composited = visual != NULL && gdk_screen_is_composited (screen);
+  if (tasklist->wireframe_composited)
+    gtk_widget_set_visual (tasklist->wireframe_window, visual);
+
+  gtk_widget_realize (tasklist->wireframe_window);
+
+  /* let all pointer events pass through the wireframe */
+  region = cairo_region_create ();
+  gtk_widget_input_shape_combine_region (tasklist->wireframe_window, region);
+  cairo_region_destroy (region);
 }
 
 
 
 static void
-xfce_tasklist_wireframe_update (XfceTasklist      *tasklist,
-                                XfceTasklistChild *child)
+xfce_tasklist_wireframe_hide (XfceTasklist *tasklist)
 {
-  Display              *dpy;
-  GdkDisplay           *gdpy;
-  gint                  x, y, width, height;
-  XSetWindowAttributes  attrs;
-  GC                    gc;
-  XRectangle            xrect;
+  panel_return_if_fail (XFCE_IS_TASKLIST (tasklist));
 
+  /* drop a pending update */
+  if (tasklist->wireframe_update_id != 0)
+    gtk_widget_remove_tick_callback (GTK_WIDGET (tasklist), tasklist->wireframe_update_id);
+
+  /* unmap the window, it is kept for the next button */
+  if (tasklist->wireframe_window != NULL)
+    gtk_widget_hide (tasklist->wireframe_window);
+}
+
+
+
+static void
+xfce_tasklist_wireframe_destroy (XfceTasklist *tasklist)
+{
   panel_return_if_fail (XFCE_IS_TASKLIST (tasklist));
-  panel_return_if_fail (tasklist->show_wireframes == TRUE);
-  panel_return_if_fail (WNCK_IS_WINDOW (child->window));
 
-  /* get the window geometry */
-  wnck_window_get_geometry (child->window, &x, &y, &width, &height);
+  if (tasklist->wireframe_update_id != 0)
+    gtk_widget_remove_tick_callback (GTK_WIDGET (tasklist), tasklist->wireframe_update_id);
+
+  if (tasklist->wireframe_window != NULL)
+    {
+      /* unmap and destroy the window */
+      gtk_widget_destroy (tasklist->wireframe_window);
+      tasklist->wireframe_window = NULL;
+    }
+}
+
+
 
-  gdpy = gtk_widget_get_display (GTK_WIDGET (tasklist));
-  dpy = GDK_DISPLAY_XDISPLAY (gdpy);
+static gboolean
+xfce_tasklist_wireframe_update_tick (GtkWidget     *widget,
+                                     GdkFrameClock *frame_clock,
+                                     gpointer       data)
+{
+  XfceTasklist          *tasklist = XFCE_TASKLIST (data);
+  GdkRectangle          *geometry = &tasklist->wireframe_geometry;
+  GdkScreen             *screen;
+  GdkWindow             *window;
+  cairo_region_t        *region;
+  cairo_rectangle_int_t  rect;
 
-  if (G_LIKELY (tasklist->wireframe_window != 0))
+  panel_return_val_if_fail (XFCE_IS_TASKLIST (tasklist), FALSE);
+
+  /* recreate the overlay if the compositor was started or stopped */
+  screen = gtk_widget_get_screen (GTK_WIDGET (tasklist));
+  if (tasklist->wireframe_window != NULL
+      && tasklist->wireframe_composited != !!gdk_screen_is_composited (screen))
     {
-      /* reposition the wireframe */
-      XMoveResizeWindow (dpy, tasklist->wireframe_window, x, y, width, height);
-
-      /* full window rectangle */
-      xrect.x = 0;
-      xrect.y = 0;
-      xrect.width = width;
-      xrect.height = height;
-
-      /* we need to restore the window first */
-      XShapeCombineRectangles (dpy, tasklist->wireframe_window, ShapeBounding,
-                               0, 0, &xrect, 1, ShapeSet, Unsorted);
+      gtk_widget_destroy (tasklist->wireframe_window);
+      tasklist->wireframe_window = NULL;
     }
-  else
+
+  if (G_UNLIKELY (tasklist->wireframe_window == NULL))
+    xfce_tasklist_wireframe_create (tasklist);
+
+  window = gtk_widget_get_window (tasklist->wireframe_window);
+
+  if (gdk_window_get_width (window) != geometry->width
+      || gdk_window_get_height (window) != geometry->height
+      || !gtk_widget_get_visible (tasklist->wireframe_window))
     {
-      /* set window attributes */
-      attrs.override_redirect = True;
-      attrs.background_pixel = 0x000000;
-
-      /* create new window */
-      tasklist->wireframe_window = XCreateWindow (dpy, DefaultRootWindow (dpy),
-                                                  x, y, width, height, 0,
-                                                  CopyFromParent, InputOutput,
-                                                  CopyFromParent,
-                                                  CWOverrideRedirect | CWBackPixel,
-                                                  &attrs);
+      if (!tasklist->wireframe_composited)
+        {
+          /* cut the inside out of the window */
+          rect.x = rect.y = 0;
+          rect.width = geometry->width;
+          rect.height = geometry->height;
+          region = cairo_region_create_rectangle (&rect);
+
+          rect.x = rect.y = WIREFRAME_SIZE;
+          rect.width = geometry->width - WIREFRAME_SIZE * 2;
+          rect.height = geometry->height - WIREFRAME_SIZE * 2;
+          if (rect.width > 0 && rect.height > 0)
+            cairo_region_subtract_rectangle (region, &rect);
+
+          gtk_widget_shape_combine_region (tasklist->wireframe_window, region);
+          cairo_region_destroy (region);
+        }
+
+      gtk_widget_queue_draw (tasklist->wireframe_window);
     }
 
-  /* create rectangle what will be 'transparent' in the window */
-  xrect.x = WIREFRAME_SIZE;
-  xrect.y = WIREFRAME_SIZE;
-  xrect.width = width - WIREFRAME_SIZE * 2;
-  xrect.height = height - WIREFRAME_SIZE * 2;
+  /* gtk sends the new position and size in a single configure request
+   * in the layout phase of this frame, a plain move does not need a
+   * redraw */
+  gtk_window_move (GTK_WINDOW (tasklist->wireframe_window),
+                   geometry->x, geometry->y);
+  gtk_window_resize (GTK_WINDOW (tasklist->wireframe_window),
+                     geometry->width, geometry->height);
+
+  gtk_widget_show (tasklist->wireframe_window);
+
+  return G_SOURCE_REMOVE;
+}
+
 
-  /* substruct rectangle from the window */
-  XShapeCombineRectangles (dpy, tasklist->wireframe_window, ShapeBounding,
-                           0, 0, &xrect, 1, ShapeSubtract, Unsorted);
 
-  /* map the window */
-  XMapWindow (dpy, tasklist->wireframe_window);
+static void
+xfce_tasklist_wireframe_update_tick_destroyed (gpointer data)
+{
+  XFCE_TASKLIST (data)->wireframe_update_id = 0;
+}
 
-  /* create a white gc */
-  gc = XCreateGC (dpy, tasklist->wireframe_window, 0, NULL);
-  XSetForeground (dpy, gc, 0xffffff);
 
-  /* draw the outer white rectangle */
-  XDrawRectangle (dpy, tasklist->wireframe_window, gc,
-                  0, 0, width - 1, height - 1);
 
-  /* draw the inner white rectangle */
-  XDrawRectangle (dpy, tasklist->wireframe_window, gc,
-                  WIREFRAME_SIZE - 1, WIREFRAME_SIZE - 1,
-                  width - 2 * (WIREFRAME_SIZE - 1) - 1,
-                  height - 2 * (WIREFRAME_SIZE - 1) - 1);
+static void
+xfce_tasklist_wireframe_update (XfceTasklist      *tasklist,
+                                XfceTasklistChild *child)
+{
+  GdkRectangle *geometry = &tasklist->wireframe_geometry;
 
-  XFreeGC (dpy, gc);
+  panel_return_if_fail (XFCE_IS_TASKLIST (tasklist));
+  panel_return_if_fail (tasklist->show_wireframes == TRUE);
+  panel_return_if_fail (WNCK_IS_WINDOW (child->window));
+
+  /* remember the window geometry, the overlay is moved once per frame
+   * when the pointer sweeps over the buttons or a window is dragged */
+  wnck_window_get_geometry (child->window, &geometry->x, &geometry->y,
+                            &geometry->width, &geometry->height);
+
+  /* the tick callback runs at the start of the next frame of the
+   * tasklist's frame clock */
+  if (tasklist->wireframe_update_id == 0)
+    {
+      tasklist->wireframe_update_id =
+          gtk_widget_add_tick_callback (GTK_WIDGET (tasklist), xfce_tasklist_wireframe_update_tick,
+                                        tasklist, xfce_tasklist_wireframe_update_tick_destroyed);
+    }
 }
 #endif
 
@@ -4326,6 +4430,11 @@ xfce_tasklist_set_show_wireframes (XfceTasklist *tasklist,
 #ifdef GDK_WINDOWING_X11
   /* destroy the window if needed */
   xfce_tasklist_wireframe_destroy (tasklist);
+
+  /* create the overlay up front, so hovering a button only has
+   * to move it instead of creating a new window */
+  if (tasklist->show_wireframes)
+    xfce_tasklist_wireframe_create (tasklist);
 #endif
 }
 
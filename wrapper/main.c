@@ -50,6 +50,87 @@
 
 static GQuark   plug_quark = 0;
 static gint     retval = PLUGIN_EXIT_FAILURE;
+static gboolean debug_enabled = FALSE;
+
+/* order in which staged geometry properties are applied, the size
+ * last so the plugin computes it with the final mode and rows */
+static const XfcePanelPluginProviderPropType geometry_order[] =
+{
+  PROVIDER_PROP_TYPE_SET_MODE,
+  PROVIDER_PROP_TYPE_SET_NROWS,
+  PROVIDER_PROP_TYPE_SET_SCREEN_POSITION,
+  PROVIDER_PROP_TYPE_SET_ICON_SIZE,
+  PROVIDER_PROP_TYPE_SET_SIZE
+};
+
+
+
+static void
+wrapper_gproxy_set_geometry (XfcePanelPluginProvider *provider,
+                             const gint              *geometry,
+                             guint                    staged)
+{
+  XfcePanelPluginProviderPropType type;
+  guint                           i;
+
+  /* let the plugin emit its geometry signals once for the batch */
+  if (XFCE_IS_PANEL_PLUGIN (provider))
+    xfce_panel_plugin_freeze_geometry (XFCE_PANEL_PLUGIN (provider));
+
+  for (i = 0; i < G_N_ELEMENTS (geometry_order); i++)
+    {
+      type = geometry_order[i];
+      if (!PANEL_HAS_FLAG (staged, 1 << type))
+        continue;
+
+      switch (type)
+        {
+        case PROVIDER_PROP_TYPE_SET_SIZE:
+          xfce_panel_plugin_provider_set_size (provider, geometry[type]);
+          break;
+
+        case PROVIDER_PROP_TYPE_SET_ICON_SIZE:
+          xfce_panel_plugin_provider_set_icon_size (provider, geometry[type]);
+          break;
+
+        case PROVIDER_PROP_TYPE_SET_MODE:
+          xfce_panel_plugin_provider_set_mode (provider, geometry[type]);
+          break;
+
+        case PROVIDER_PROP_TYPE_SET_SCREEN_POSITION:
+          xfce_panel_plugin_provider_set_screen_position (provider, geometry[type]);
+          break;
+
+        case PROVIDER_PROP_TYPE_SET_NROWS:
+          xfce_panel_plugin_provider_set_nrows (provider, geometry[type]);
+          break;
+
+        default:
+          panel_assert_not_reached ();
+          break;
+        }
+    }
+
+  if (XFCE_IS_PANEL_PLUGIN (provider))
+    xfce_panel_plugin_thaw_geometry (XFCE_PANEL_PLUGIN (provider));
+
+  /* one relayout for the whole batch */
+  gtk_widget_queue_resize (GTK_WIDGET (provider));
+}
+
+
+
+static gboolean
+wrapper_gproxy_is_geometry (XfcePanelPluginProviderPropType type)
+{
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (geometry_order); i++)
+    if (geometry_order[i] == type)
+      return TRUE;
+
+  return FALSE;
+}
 
 
 
@@ -61,34 +142,45 @@ wrapper_gproxy_set (XfcePanelPluginProvider *provider,
   GVariantIter                    iter;
   GVariant                       *variant;
   XfcePanelPluginProviderPropType type;
+  gint                            geometry[PROVIDER_PROP_TYPE_SET_NROWS + 1];
+  guint                           staged = 0;
+  guint                           n_values = 0, n_duplicates = 0;
+  gint64                          start_time = 0;
 
   panel_return_if_fail (XFCE_IS_PANEL_PLUGIN_PROVIDER (provider));
   panel_return_if_fail (g_variant_is_of_type (parameters, G_VARIANT_TYPE_TUPLE));
 
+  if (G_UNLIKELY (debug_enabled))
+    start_time = g_get_monotonic_time ();
+
   g_variant_iter_init (&iter, parameters);
 
   while (g_variant_iter_next (&iter, "(uv)", &type, &variant))
     {
+      n_values++;
+
+      /* apply the staged geometry before any other property or action,
+       * so those are handled in the order the panel sent them */
+      if (staged != 0 && !wrapper_gproxy_is_geometry (type))
+        {
+          wrapper_gproxy_set_geometry (provider, geometry, staged);
+          staged = 0;
+        }
+
       switch (type)
         {
         case PROVIDER_PROP_TYPE_SET_SIZE:
-          xfce_panel_plugin_provider_set_size (provider, g_variant_get_int32 (variant));
-          break;
-
         case PROVIDER_PROP_TYPE_SET_ICON_SIZE:
-          xfce_panel_plugin_provider_set_icon_size (provider, g_variant_get_int32 (variant));
-          break;
-
         case PROVIDER_PROP_TYPE_SET_MODE:
-          xfce_panel_plugin_provider_set_mode (provider, g_variant_get_int32 (variant));
-          break;
-
         case PROVIDER_PROP_TYPE_SET_SCREEN_POSITION:
-          xfce_panel_plugin_provider_set_screen_position (provider, g_variant_get_int32 (variant));
-          break;
-
         case PROVIDER_PROP_TYPE_SET_NROWS:
-          xfce_panel_plugin_provider_set_nrows (provider, g_variant_get_int32 (variant));
+          /* stage the geometry, only the last value of each is applied
+           * in wrapper_gproxy_set_geometry() after the run of geometry
+           * properties */
+          if (PANEL_HAS_FLAG (staged, 1 << type))
+            n_duplicates++;
+          geometry[type] = g_variant_get_int32 (variant);
+          PANEL_SET_FLAG (staged, 1 << type);
           break;
 
         case PROVIDER_PROP_TYPE_SET_LOCKED:
@@ -155,6 +247,15 @@ wrapper_gproxy_set (XfcePanelPluginProvider *provider,
 
       g_variant_unref (variant);
     }
+
+  if (staged != 0)
+    wrapper_gproxy_set_geometry (provider, geometry, staged);
+
+  if (G_UNLIKELY (debug_enabled))
+    g_debug ("%s-%d: applied %u properties (%u duplicates) in %" G_GINT64_FORMAT " us",
+             xfce_panel_plugin_provider_get_name (provider),
+             xfce_panel_plugin_provider_get_unique_id (provider),
+             n_values, n_duplicates, g_get_monotonic_time () - start_time);
 }
 
 
@@ -188,6 +289,30 @@ wrapper_dbus_return_remote_event_result (GDBusProxy *proxy,
 }
 
 
+static gboolean
+wrapper_remote_event_dispatch (XfcePanelPluginProvider *provider,
+                               const gchar             *name,
+                               GVariant                *variant)
+{
+  gboolean result;
+  GValue   real_value = { 0, };
+
+  if ( g_variant_is_of_type (variant, G_VARIANT_TYPE_BYTE) &&
+       g_variant_get_byte (variant) == '\0')
+    {
+      result = xfce_panel_plugin_provider_remote_event (provider, name, NULL, NULL);
+    }
+  else
+    {
+      g_dbus_gvariant_to_gvalue(variant, &real_value);
+      result = xfce_panel_plugin_provider_remote_event (provider, name, &real_value, NULL);
+      g_value_unset (&real_value);
+    }
+
+  return result;
+}
+
+
 static void
 wrapper_gproxy_remote_event (XfcePanelPluginProvider *provider,
                              GDBusProxy *proxy,
@@ -197,25 +322,13 @@ wrapper_gproxy_remote_event (XfcePanelPluginProvider *provider,
   guint         handle;
   const gchar  *name;
   gboolean      result;
-  GValue        real_value = { 0, };
 
   panel_return_if_fail (XFCE_IS_PANEL_PLUGIN_PROVIDER (provider));
 
   if (G_LIKELY (g_variant_is_of_type (parameters, G_VARIANT_TYPE("(svu)"))))
     {
       g_variant_get (parameters, "(&svu)", &name, &variant, &handle);
-      if ( g_variant_is_of_type (variant, G_VARIANT_TYPE_BYTE) &&
-           g_variant_get_byte (variant) == '\0')
-        {
-          result = xfce_panel_plugin_provider_remote_event (provider, name, NULL, NULL);
-        }
-      else
-        {
-          g_dbus_gvariant_to_gvalue(variant, &real_value);
-          result = xfce_panel_plugin_provider_remote_event (provider, name, &real_value, NULL);
-          g_value_unset (&real_value);
-        }
-
+      result = wrapper_remote_event_dispatch (provider, name, variant);
       wrapper_dbus_return_remote_event_result (proxy, handle, result);
 
       g_variant_unref (variant);
@@ -229,6 +342,62 @@ wrapper_gproxy_remote_event (XfcePanelPluginProvider *provider,
 }
 
 
+static void
+wrapper_gproxy_remote_events (XfcePanelPluginProvider *provider,
+                              GDBusProxy *proxy,
+                              GVariant   *parameters)
+{
+  GVariant        *events;
+  GVariant        *variant;
+  GVariantIter     iter;
+  GVariantBuilder  results;
+  guint            handle;
+  const gchar     *name;
+  gboolean         result;
+  GVariant        *retval;
+  GError          *error = NULL;
+
+  panel_return_if_fail (XFCE_IS_PANEL_PLUGIN_PROVIDER (provider));
+
+  if (G_UNLIKELY (!g_variant_is_of_type (parameters, G_VARIANT_TYPE("(a(svu))"))))
+    {
+      g_warning ("remote events handler expects (a(svu)) type, but %s received",
+                 g_variant_get_type_string(parameters));
+      return;
+    }
+
+  g_variant_builder_init (&results, G_VARIANT_TYPE ("a(ub)"));
+
+  /* dispatch all the events, and return the results in one call */
+  events = g_variant_get_child_value (parameters, 0);
+  g_variant_iter_init (&iter, events);
+  while (g_variant_iter_next (&iter, "(&svu)", &name, &variant, &handle))
+    {
+      result = wrapper_remote_event_dispatch (provider, name, variant);
+      g_variant_builder_add (&results, "(ub)", handle, result);
+      g_variant_unref (variant);
+    }
+  g_variant_unref (events);
+
+  retval = g_dbus_proxy_call_sync (proxy,
+                                   "RemoteEventResults",
+                                   g_variant_new ("(a(ub))", &results),
+                                   G_DBUS_CALL_FLAGS_NONE,
+                                   -1,
+                                   NULL,
+                                   &error);
+
+  if (G_UNLIKELY (error != NULL ))
+    {
+      g_warning ("RemoteEventResults call failed: %s", error->message);
+      g_error_free (error);
+    }
+
+  if (retval)
+    g_variant_unref (retval);
+}
+
+
 
 static void
 wrapper_gproxy_g_signal (GDBusProxy *proxy,
@@ -239,6 +408,8 @@ wrapper_gproxy_g_signal (GDBusProxy *proxy,
 {
   if (g_strcmp0(signal_name, "RemoteEvent") == 0)
     wrapper_gproxy_remote_event (provider, proxy, parameters);
+  else if (g_strcmp0(signal_name, "RemoteEvents") == 0)
+    wrapper_gproxy_remote_events (provider, proxy, parameters);
   else if (g_strcmp0(signal_name, "Set") == 0)
     wrapper_gproxy_set (provider, parameters);
   else
@@ -332,6 +503,10 @@ main (gint argc, gchar **argv)
   g_log_set_always_fatal (G_LOG_LEVEL_CRITICAL | G_LOG_LEVEL_WARNING);
 #endif
 
+  /* the wrapper does not link the panel debug code, only check if
+   * debugging is enabled at all */
+  debug_enabled = (g_getenv ("PANEL_DEBUG") != NULL);
+
   /* check if we have all the reuiqred arguments */
   if (G_UNLIKELY (argc < PLUGIN_ARGV_ARGUMENTS))
     {